@@ -1,5 +1,5 @@
 TEMPLATE = app
-CONFIG += console testcase
+CONFIG += console testcase thread
 CONFIG -= app_bundle
 CONFIG -= qt
 
@@ -31,9 +31,18 @@ SOURCES += \
     tests/direct_map.cpp \
     tests/hash.cpp \
     tests/sort.cpp \
+    tests/external_sort.cpp \
+    tests/flat_hash_map.cpp \
+    tests/perfect_hash.cpp \
+    tests/concurrent_hash_map.cpp \
+    tests/bloom_filter.cpp \
     tests/random.cpp \
     tests/poly_obj.cpp \
-    tests/visitation_benchmarks.cpp
+    tests/visitation_benchmarks.cpp \
+    tests/sort_benchmarks.cpp \
+    tests/concurrent_hash_map_benchmarks.cpp \
+    tests/hash_benchmarks.cpp \
+    tests/trie_benchmarks.cpp
 
 HEADERS += \
     kblib/bits.h \
@@ -62,6 +71,11 @@ HEADERS += \
     kblib/direct_map.h \
     kblib/hash.h \
     kblib/sort.h \
+    kblib/external_sort.h \
+    kblib/flat_hash_map.h \
+    kblib/perfect_hash.h \
+    kblib/concurrent_hash_map.h \
+    kblib/bloom_filter.h \
     kblib/random.h \
     kblib/poly_obj.h \
     kblib/enumerate-contrib-cry.h \
@@ -74,6 +88,9 @@ DISTFILES += \
     doc/table_ana.yml \
     doc/table_cata.yml \
     var_timings.log \
+    sort_timings.log \
+    hash_timings.log \
+    trie_timings.log \
     Doxyfile \
     doc/algorithm_intuition_ana.html \
     doc/algorithm_intuition_cata.html \
@@ -34,8 +34,10 @@
 #include <algorithm>
 #include <array>
 #include <bitset>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -109,12 +111,49 @@ class bit_trie {
   std::array<detail_bits::trie_node, bits_of<key_type>> roots;
 };//*/
 
+/**
+ * @brief A binary trie mapping bit-string prefixes to values, such as a
+ * routing table mapping IP prefixes to next hops.
+ *
+ * A key is the first bits bits of prefix, counting from the most significant
+ * bit, so the IPv4 prefix 10.0.0.0/8 is {0x0A000000, 8}. Bits of prefix past
+ * the first bits are ignored. Nodes are kept in a single vector and refer to
+ * each other by index, and values are kept in a second vector.
+ *
+ * Iteration visits a key before the keys it is a prefix of, and keys whose
+ * next bit is 0 before those whose next bit is 1. For keys of equal length,
+ * that is ascending order of prefix.
+ *
+ * Once the trie is built, shrink_to_fit lays it out for lookups: nodes are
+ * renumbered in iteration order, so that iterating is a forward scan, and a
+ * table indexed by the first index_bits bits of an address lets
+ * longest_prefix_match skip that many levels. Inserting a new key undoes
+ * this until shrink_to_fit is called again.
+ *
+ * @tparam Key An unsigned integral type holding the bits of a key.
+ * @tparam key_range The largest number of nodes the trie may need. It selects
+ * size_type, which is used for node and value indices.
+ * @tparam Value The mapped type.
+ */
 template <typename Key, Key key_range, typename Value>
 class compact_bit_trie {
  public:
 	struct key_type {
+		/**
+		 * @param b The number of leading bits of p that make up the key, at
+		 * most bits_of<Key>.
+		 */
+		constexpr key_type(Key p = Key{}, std::uint16_t b = 0) noexcept
+		    : prefix(p)
+		    , bits(b & bits_mask) {}
+
 		Key prefix;
-		std::uint16_t bits : filg2(key_range);
+		std::uint16_t bits : filg2(bits_of<Key>) + 1;
+
+	 private:
+		// Masking keeps the conversion to the bit-field visibly lossless
+		KBLIB_CONSTANT_M std::uint16_t bits_mask
+		    = (1u << (filg2(bits_of<Key>) + 1)) - 1;
 	};
 
 	using value_type = Value;
@@ -141,102 +180,113 @@ class compact_bit_trie {
 	static_assert(std::is_nothrow_destructible<mapped_type>::value,
 	              "mapped_type must be nothrow destructible.");
 
+	/**
+	 * @brief The number of leading address bits resolved by the table that
+	 * shrink_to_fit builds for longest_prefix_match.
+	 */
+	KBLIB_CONSTANT_M std::size_t index_bits
+	    = std::min<std::size_t>(16, bits_of<Key> / 2);
+
+	/**
+	 * @brief Returns the value stored under exactly key.
+	 */
 	KBLIB_NODISCARD auto at(key_type key) const noexcept(false)
 	    -> const_reference {
-		if (empty()) {
-			throw std::out_of_range("searched in an empty compact_bit_trie");
-		}
-		if (key.bits > bits_of<Key>) {
-			throw std::invalid_argument("key prefix longer than key length");
-		}
-		size_type node = 1;
-		const bitset_type search = key.prefix;
-		int idx = 0;
-		while (node and idx < key.bits) {
-			if (auto val = storage[node].val) {
-				return values[val];
-			} else {
-				node = storage[node].children[search[idx++]];
-			}
-		}
-		throw std::out_of_range("key not found in compact_bit_trie");
+		return values[storage[checked_find(key)].val];
 	}
 
 	KBLIB_NODISCARD auto at(key_type key) noexcept(false) -> reference {
-		if (empty()) {
-			throw std::out_of_range("searched in an empty compact_bit_trie");
-		}
-		if (key.bits > bits_of<Key>) {
-			throw std::invalid_argument("key prefix longer than key length");
-		}
-		size_type node = 1;
-		const bitset_type search = key.prefix;
-		int idx = 0;
-		while (node and idx < key.bits) {
-			if (auto val = storage[node].val) {
-				return values[val];
-			} else {
-				node = storage[node].children[search[idx++]];
-			}
-		}
-		throw std::out_of_range("key not found in compact_bit_trie");
+		return values[storage[checked_find(key)].val];
 	}
 
+	/**
+	 * @brief Returns the value of the longest stored prefix of key, stopping
+	 * early once depth stored prefixes have been passed.
+	 */
 	KBLIB_NODISCARD auto find_deep(key_type key, size_type depth = -1) const
 	    noexcept(false) -> const_reference {
-		if (empty()) {
-			throw std::out_of_range("searched in an empty compact_bit_trie");
-		}
-		if (key.bits > bits_of<Key>) {
-			throw std::invalid_argument("key prefix longer than key length");
-		}
-		size_type node = 1;
-		size_type found = 0;
-		const bitset_type search = key.prefix;
-		int idx = 0;
-		while (node and idx < key.bits) {
-			if (auto val = storage[node].val) {
-				found = val;
-				if (depth--) {
-					break;
-				}
-			}
-			node = storage[node].children[search[idx++]];
-		}
-		if (found) {
-			return values[found];
-		} else {
-			throw std::out_of_range("key not found in compact_bit_trie");
-		}
+		return values[storage[checked_find_deep(key, depth)].val];
 	}
 
 	KBLIB_NODISCARD auto find_deep(key_type key,
 	                               size_type depth = -1) noexcept(false)
 	    -> reference {
-		if (empty()) {
-			throw std::out_of_range("searched in an empty compact_bit_trie");
-		}
-		if (key.bits > bits_of<Key>) {
-			throw std::invalid_argument("key prefix longer than key length");
-		}
-		size_type node = 1;
-		size_type found = 0;
-		const bitset_type search = key.prefix;
-		int idx = 0;
-		while (node and idx < key.bits) {
-			if (auto val = storage[node].val) {
-				found = val;
-				if (depth--) {
-					break;
-				}
-			}
-			node = storage[node].children[search[idx++]];
-		}
-		if (found) {
-			return values[found];
-		} else {
-			throw std::out_of_range("key not found in compact_bit_trie");
-		}
+		return values[storage[checked_find_deep(key, depth)].val];
+	}
+
+	/**
+	 * @brief Finds the element stored under exactly key.
+	 */
+	KBLIB_NODISCARD auto find(key_type key) noexcept(false) -> iterator {
+		const auto node = find_node(key);
+		return {*this, node and storage[node].val != no_value ? node : 0};
+	}
+	KBLIB_NODISCARD auto find(key_type key) const noexcept(false)
+	    -> const_iterator {
+		const auto node = find_node(key);
+		return {*this, node and storage[node].val != no_value ? node : 0};
+	}
+
+	/**
+	 * @brief Finds the element with the longest key that is a prefix of
+	 * address, as a router looks up a destination. Use iterator::key() to
+	 * obtain the matched prefix.
+	 *
+	 * @return An iterator to the matched element, or end() if no stored key is
+	 * a prefix of address.
+	 */
+	KBLIB_NODISCARD auto longest_prefix_match(Key address) noexcept -> iterator {
+		return {*this, longest_match(address)};
+	}
+	KBLIB_NODISCARD auto longest_prefix_match(Key address) const noexcept
+	    -> const_iterator {
+		return {*this, longest_match(address)};
+	}
+
+	/**
+	 * @brief The elements whose keys start with prefix, including prefix
+	 * itself, as an iterator range. Pass it to kblib::indirect to use it in a
+	 * range-for loop.
+	 */
+	KBLIB_NODISCARD auto prefix_range(key_type prefix) noexcept(false)
+	    -> std::pair<iterator, iterator> {
+		const auto r = find_subtree(prefix);
+		return {{*this, r.first}, {*this, r.second}};
+	}
+	KBLIB_NODISCARD auto prefix_range(key_type prefix) const noexcept(false)
+	    -> std::pair<const_iterator, const_iterator> {
+		const auto r = find_subtree(prefix);
+		return {{*this, r.first}, {*this, r.second}};
+	}
+
+	KBLIB_NODISCARD auto begin() noexcept -> iterator {
+		return {*this, first_value()};
+	}
+	KBLIB_NODISCARD auto begin() const noexcept -> const_iterator {
+		return {*this, first_value()};
+	}
+	KBLIB_NODISCARD auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+	KBLIB_NODISCARD auto end() noexcept -> iterator { return {*this, 0}; }
+	KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+		return {*this, 0};
+	}
+	KBLIB_NODISCARD auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+
+	KBLIB_NODISCARD auto rbegin() noexcept -> reverse_iterator {
+		return reverse_iterator(end());
+	}
+	KBLIB_NODISCARD auto rbegin() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator(end());
+	}
+	KBLIB_NODISCARD auto rend() noexcept -> reverse_iterator {
+		return reverse_iterator(begin());
+	}
+	KBLIB_NODISCARD auto rend() const noexcept -> const_reverse_iterator {
+		return const_reverse_iterator(begin());
 	}
 
 	KBLIB_NODISCARD auto empty() const noexcept -> bool {
@@ -246,11 +296,10 @@ class compact_bit_trie {
 	template <typename... Ts>
 	auto emplace(key_type key, Ts&&... args) -> bool {
 		size_type node = get_storage_node_for(key);
-		if (auto& v = storage[node].val; v != max) {
+		if (storage[node].val != no_value) {
 			return false;
 		} else {
-			values.emplace_back(std::forward<Ts>(args)...);
-			v = static_cast<size_type>(values.size() - 1);
+			storage[node].val = new_value(std::forward<Ts>(args)...);
 			return true;
 		}
 	}
@@ -265,9 +314,8 @@ class compact_bit_trie {
 	auto insert_or_assign(key_type key, const value_type& value) -> reference {
 		size_type node = get_storage_node_for(key);
 		auto& v = storage[node].val;
-		if (v != -1) {
-			values.push_back(value);
-			v = static_cast<size_type>(values.size() - 1);
+		if (v == no_value) {
+			v = new_value(value);
 		} else {
 			values[v] = value;
 		}
@@ -277,9 +325,8 @@ class compact_bit_trie {
 	auto insert_or_assign(key_type key, value_type&& value) -> reference {
 		size_type node = get_storage_node_for(key);
 		auto& v = storage[node].val;
-		if (v != -1) {
-			values.push_back(std::move(value));
-			v = static_cast<size_type>(values.size() - 1);
+		if (v == no_value) {
+			v = new_value(std::move(value));
 		} else {
 			values[v] = std::move(value);
 		}
@@ -291,6 +338,8 @@ class compact_bit_trie {
 	auto clear() -> void {
 		storage.clear();
 		values.clear();
+		index.clear();
+		in_order = false;
 	}
 
 	KBLIB_NODISCARD auto size() const noexcept -> size_type {
@@ -299,15 +348,49 @@ class compact_bit_trie {
 
 	KBLIB_NODISCARD auto memory_use() const noexcept -> std::size_t {
 		return storage.capacity() * sizeof(inline_node)
-		       + values.size() * sizeof(Value);
+		       + values.capacity() * sizeof(Value)
+		       + index.capacity() * sizeof(index_entry);
 	}
 
+	/**
+	 * @brief Renumbers the nodes and values in iteration order, builds the
+	 * longest_prefix_match table, and frees unused capacity. Invalidates all
+	 * iterators and references.
+	 */
 	auto shrink_to_fit() -> void {
-		storage.shrink_to_fit();
-		values.shrink_to_fit();
+		if (storage.size() > 2 and not in_order) {
+			std::vector<size_type> new_index(storage.size());
+			std::vector<inline_node> nodes;
+			nodes.reserve(storage.size());
+			nodes.push_back(storage[0]);
+			std::vector<Value> vals;
+			vals.reserve(values.size());
+			for (size_type n = 1; n; n = next_node(n)) {
+				new_index[n] = static_cast<size_type>(nodes.size());
+				nodes.push_back(storage[n]);
+				if (auto& v = nodes.back().val; v != no_value) {
+					vals.push_back(std::move(values[v]));
+					v = static_cast<size_type>(vals.size() - 1);
+				}
+			}
+			for (auto& node : nodes) {
+				node.children[0] = new_index[node.children[0]];
+				node.children[1] = new_index[node.children[1]];
+				node.parent = new_index[node.parent];
+			}
+			storage = std::move(nodes);
+			values = std::move(vals);
+			in_order = true;
+		} else {
+			storage.shrink_to_fit();
+			values.shrink_to_fit();
+		}
+		build_index();
 	}
 
  private:
+	// Node 0 is a null node, which doubles as the end position, and node 1 is
+	// the root, whose key is empty
 	struct inline_node {
 		size_type children[2];
 		size_type parent;
@@ -316,65 +399,359 @@ class compact_bit_trie {
 	std::vector<inline_node> storage;
 	std::vector<Value> values;
 
+	// The node reached by each value of the first index_bits bits of an
+	// address (0 if the path ends sooner), and the deepest node with a value
+	// on the way there (0 if none). Empty unless built by shrink_to_fit.
+	struct index_entry {
+		size_type node;
+		size_type match;
+	};
+	std::vector<index_entry> index;
+	// Whether nodes are numbered in iteration order, so that the next node
+	// is always the next index
+	bool in_order = false;
+
+	KBLIB_CONSTANT_M size_type no_value = std::numeric_limits<size_type>::max();
+
+	KBLIB_NODISCARD static auto bit_at(Key prefix, std::size_t i) noexcept
+	    -> std::size_t {
+		return (prefix >> (bits_of<Key> - 1 - i)) & 1u;
+	}
+
+	static auto check_bits(key_type key) -> void {
+		if (key.bits > bits_of<Key>) {
+			throw std::invalid_argument("key prefix longer than key length");
+		}
+	}
+
 	auto do_init() -> void {
 		if (storage.size() < 2) {
-			storage.resize(2);
-			storage[0] = {};
-			storage[1] = {};
+			storage.assign(2, {{0, 0}, 0, no_value});
 		}
 	}
 
-	KBLIB_NODISCARD auto get_storage_node_for(key_type key) -> size_type {
-		if (key.bits > bits_of<Key>) {
-			throw std::invalid_argument("key prefix longer than key length");
+	template <typename... Ts>
+	auto new_value(Ts&&... args) -> size_type {
+		if (values.size() == no_value) {
+			throw std::length_error("compact_bit_trie: too many values");
 		}
-		const bitset_type search = key.prefix;
-		size_type node = 1;
+		values.emplace_back(std::forward<Ts>(args)...);
+		index.clear();
+		return static_cast<size_type>(values.size() - 1);
+	}
+
+	KBLIB_NODISCARD auto get_storage_node_for(key_type key) -> size_type {
+		check_bits(key);
 		do_init();
-		for (std::size_t i : range<std::size_t>(key.bits - 1)) {
-			if (auto n = storage[node].children[std::as_const(search)[i]]) {
+		size_type node = 1;
+		for (std::size_t i = 0; i != key.bits; ++i) {
+			const auto b = bit_at(key.prefix, i);
+			if (auto n = storage[node].children[b]) {
 				node = n;
 			} else {
-				storage.push_back({{0, 0}, node, max});
-				node = static_cast<size_type>(storage.size() - 1);
-				storage[node].children[std::as_const(search)[i]] = node;
+				if (storage.size() == no_value) {
+					throw std::length_error("compact_bit_trie: too many nodes");
+				}
+				const auto next = static_cast<size_type>(storage.size());
+				storage.push_back({{0, 0}, node, no_value});
+				in_order = false;
+				index.clear();
+				storage[node].children[b] = next;
+				node = next;
+			}
+		}
+		return node;
+	}
+
+	/**
+	 * @brief The node for key, or 0 if there is none. It may not hold a value.
+	 */
+	KBLIB_NODISCARD auto find_node(key_type key) const -> size_type {
+		check_bits(key);
+		if (storage.empty()) {
+			return 0;
+		}
+		size_type node = 1;
+		for (std::size_t i = 0; node and i != key.bits; ++i) {
+			node = storage[node].children[bit_at(key.prefix, i)];
+		}
+		return node;
+	}
+
+	/**
+	 * @brief The deepest node holding a value on the path to the first bits
+	 * bits of address, passing at most depth such nodes, or 0 if there is
+	 * none.
+	 */
+	KBLIB_NODISCARD auto deepest_match(Key address, std::size_t bits,
+	                                   size_type depth) const noexcept
+	    -> size_type {
+		if (storage.empty()) {
+			return 0;
+		}
+		size_type node = 1;
+		size_type found = 0;
+		for (std::size_t i = 0;; ++i) {
+			if (storage[node].val != no_value) {
+				found = node;
+				if (--depth == 0) {
+					break;
+				}
+			}
+			if (i == bits) {
+				break;
+			}
+			node = storage[node].children[bit_at(address, i)];
+			if (not node) {
+				break;
+			}
+		}
+		return found;
+	}
+
+	KBLIB_NODISCARD auto longest_match(Key address) const noexcept
+	    -> size_type {
+		if (index.empty()) {
+			return deepest_match(address, bits_of<Key>, -1);
+		}
+		const auto& e = index[address >> (bits_of<Key> - index_bits)];
+		size_type found = e.match;
+		size_type node = e.node;
+		for (std::size_t i = index_bits; node and i != bits_of<Key>; ++i) {
+			node = storage[node].children[bit_at(address, i)];
+			if (storage[node].val != no_value) {
+				found = node;
+			}
+		}
+		return found;
+	}
+
+	auto build_index() -> void {
+		index.clear();
+		if (storage.empty()) {
+			return;
+		}
+		index.resize(std::size_t{1} << index_bits);
+		for (std::size_t i = 0; i != index.size(); ++i) {
+			const auto address
+			    = static_cast<Key>(i << (bits_of<Key> - index_bits));
+			size_type node = 1;
+			size_type found = 0;
+			for (std::size_t b = 0; node; ++b) {
+				if (storage[node].val != no_value) {
+					found = node;
+				}
+				if (b == index_bits) {
+					break;
+				}
+				node = storage[node].children[bit_at(address, b)];
+			}
+			index[i] = {node, found};
+		}
+	}
+
+	KBLIB_NODISCARD auto checked_find(key_type key) const -> size_type {
+		if (empty()) {
+			throw std::out_of_range("searched in an empty compact_bit_trie");
+		}
+		const auto node = find_node(key);
+		if (not node or storage[node].val == no_value) {
+			throw std::out_of_range("key not found in compact_bit_trie");
+		}
+		return node;
+	}
+
+	KBLIB_NODISCARD auto checked_find_deep(key_type key, size_type depth) const
+	    -> size_type {
+		if (empty()) {
+			throw std::out_of_range("searched in an empty compact_bit_trie");
+		}
+		check_bits(key);
+		if (const auto node = deepest_match(key.prefix, key.bits, depth)) {
+			return node;
+		}
+		throw std::out_of_range("key not found in compact_bit_trie");
+	}
+
+	/**
+	 * @brief The first node after the subtree of node in iteration order, or
+	 * 0.
+	 */
+	KBLIB_NODISCARD auto skip_subtree(size_type node) const noexcept
+	    -> size_type {
+		while (node != 1) {
+			const auto p = storage[node].parent;
+			if (storage[p].children[0] == node and storage[p].children[1]) {
+				return storage[p].children[1];
+			}
+			node = p;
+		}
+		return 0;
+	}
+
+	KBLIB_NODISCARD auto next_node(size_type node) const noexcept
+	    -> size_type {
+		if (in_order) {
+			return node + 1u == storage.size() ? 0 : node + 1u;
+		} else if (storage[node].children[0]) {
+			return storage[node].children[0];
+		} else if (storage[node].children[1]) {
+			return storage[node].children[1];
+		} else {
+			return skip_subtree(node);
+		}
+	}
+
+	/**
+	 * @brief The last node of the subtree of node in iteration order.
+	 */
+	KBLIB_NODISCARD auto last_node(size_type node) const noexcept
+	    -> size_type {
+		for (;;) {
+			if (storage[node].children[1]) {
+				node = storage[node].children[1];
+			} else if (storage[node].children[0]) {
+				node = storage[node].children[0];
+			} else {
+				return node;
 			}
 		}
+	}
+
+	KBLIB_NODISCARD auto prev_node(size_type node) const noexcept
+	    -> size_type {
+		if (in_order) {
+			return node == 0 ? static_cast<size_type>(storage.size() - 1)
+			                 : node - 1u;
+		} else if (node == 0) {
+			return last_node(1);
+		}
+		const auto p = storage[node].parent;
+		if (storage[p].children[1] == node and storage[p].children[0]) {
+			return last_node(storage[p].children[0]);
+		}
+		return p;
+	}
+
+	/**
+	 * @brief The first node at or after node that holds a value, or 0.
+	 */
+	KBLIB_NODISCARD auto seek_value(size_type node) const noexcept
+	    -> size_type {
+		while (node and storage[node].val == no_value) {
+			node = next_node(node);
+		}
 		return node;
 	}
 
+	KBLIB_NODISCARD auto first_value() const noexcept -> size_type {
+		return storage.empty() ? 0 : seek_value(1);
+	}
+
+	/**
+	 * @brief The first node with a value in the subtree of prefix, and the
+	 * first one after it, or 0 for either if there is none.
+	 */
+	KBLIB_NODISCARD auto find_subtree(key_type prefix) const
+	    -> std::pair<size_type, size_type> {
+		const auto node = find_node(prefix);
+		if (not node) {
+			return {0, 0};
+		}
+		// If the subtree has no values, both searches find the same node
+		return {seek_value(node), seek_value(skip_subtree(node))};
+	}
+
  public:
+	/**
+	 * @brief A bidirectional iterator over the values of a compact_bit_trie.
+	 * key() gives the key of the current element.
+	 */
 	template <typename V>
 	class iterator_t {
 	 public:
-		using value_type = V;
+		using value_type = std::remove_const_t<V>;
 		using pointer = V*;
 		using reference = V&;
 		using difference_type = compact_bit_trie::difference_type;
 		using iterator_category = std::bidirectional_iterator_tag;
 
 		iterator_t() = default;
-		iterator_t(const compact_bit_trie& range)
-		    : tree_ptr{&range.storage}
-		    , values_ptr{&range.values}
-		    , node{0} {}
+		template <typename U, typename = std::enable_if_t<
+		                          std::is_convertible<U*, V*>::value>>
+		iterator_t(const iterator_t<U>& other) noexcept
+		    : trie{other.trie}
+		    , node{other.node} {}
 
 		auto operator*() const noexcept -> reference {
-			return (*values_ptr)[(*tree_ptr)[node].val];
+			return trie->values[trie->storage[node].val];
 		}
 		auto operator->() const noexcept -> pointer {
-			return std::addressof((*values_ptr)[(*tree_ptr)[node].val]);
+			return std::addressof(**this);
 		}
-		auto operator++() -> iterator_t {}
 
-	 private:
-		iterator_t(const compact_bit_trie& range, size_type n_)
-		    : iterator_t(range) {
-			node = n_;
+		/**
+		 * @brief Rebuilds the key of the current element by walking up to the
+		 * root.
+		 */
+		KBLIB_NODISCARD auto key() const noexcept -> key_type {
+			const auto& s = trie->storage;
+			Key path = 0;
+			std::size_t bits = 0;
+			for (auto n = node; n != 1; ++bits) {
+				const auto p = s[n].parent;
+				if (s[p].children[1] == n) {
+					path |= static_cast<Key>(Key(1) << bits);
+				}
+				n = p;
+			}
+			return {bits ? static_cast<Key>(path << (bits_of<Key> - bits))
+			             : Key(0),
+			        static_cast<std::uint16_t>(bits)};
+		}
+
+		auto operator++() noexcept -> iterator_t& {
+			node = trie->seek_value(trie->next_node(node));
+			return *this;
+		}
+		auto operator++(int) noexcept -> iterator_t {
+			auto tmp = *this;
+			++*this;
+			return tmp;
+		}
+		auto operator--() noexcept -> iterator_t& {
+			do {
+				node = trie->prev_node(node);
+			} while (trie->storage[node].val == no_value);
+			return *this;
 		}
+		auto operator--(int) noexcept -> iterator_t {
+			auto tmp = *this;
+			--*this;
+			return tmp;
+		}
+
+		KBLIB_NODISCARD friend auto operator==(const iterator_t& a,
+		                                       const iterator_t& b) noexcept
+		    -> bool {
+			return a.node == b.node;
+		}
+		KBLIB_NODISCARD friend auto operator!=(const iterator_t& a,
+		                                       const iterator_t& b) noexcept
+		    -> bool {
+			return not (a == b);
+		}
+
+	 private:
+		friend class compact_bit_trie;
+		template <typename>
+		friend class iterator_t;
+
+		iterator_t(copy_const_t<V, compact_bit_trie>& range, size_type n_)
+		    : trie{&range}
+		    , node{n_} {}
 
-		const std::vector<inline_node>* tree_ptr{};
-		const std::vector<Value>* values_ptr{};
+		copy_const_t<V, compact_bit_trie>* trie{};
 		size_type node{};
 	};
 };
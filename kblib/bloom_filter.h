@@ -0,0 +1,585 @@
+/* *****************************************************************************
+ * kblib is a general utility library for C++14 and C++17, intended to provide
+ * performant high-level abstractions and more expressive ways to do simple
+ * things.
+ *
+ * Copyright (c) 2021 killerbee
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/**
+ * @file
+ * @brief Provides bloom_filter and blocked_bloom_filter, probabilistic set
+ * membership filters built on FNV_hash, and read-only views of serialized
+ * filters.
+ *
+ * @author killerbee
+ * @date 2019-2021
+ * @copyright GNU General Public Licence v3.0
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include "hash.h"
+#include "tdecl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace KBLIB_NS {
+
+namespace detail_bloom {
+
+	/**
+	 * @brief Storage is allocated in cache-line-sized blocks of 512 bits, so
+	 * that a blocked filter touches exactly one cache line per key.
+	 */
+	struct alignas(64) block {
+		std::uint64_t words[8];
+	};
+	KBLIB_CONSTANT std::size_t block_words = 8;
+	KBLIB_CONSTANT std::size_t block_bits = 512;
+
+	/**
+	 * @brief Bulk operations hash this many keys and prefetch their bits
+	 * before probing any of them, to overlap the cache misses.
+	 */
+	KBLIB_CONSTANT std::size_t batch_size = 16;
+
+	/**
+	 * @brief The size of the header of a serialized filter. Keeps the bit array
+	 * cache-line aligned when the buffer is page aligned, as mapped files are.
+	 */
+	KBLIB_CONSTANT std::size_t header_size = 64;
+	KBLIB_CONSTANT char magic[8] = {'k', 'b', 'b', 'l', 'o', 'o', 'm', '1'};
+
+	/**
+	 * @brief Maps x onto [0, n) without a division, by taking the high half of
+	 * x * n.
+	 */
+	constexpr auto reduce(std::uint64_t x, std::uint64_t n) noexcept
+	    -> std::uint64_t {
+		detail_hash::mul128(x, n);
+		return n;
+	}
+
+	/**
+	 * @brief The two hashes for double hashing, derived from one FNV_hash by
+	 * remixing it twice. h2 is odd, so h1 + i * h2 never repeats early.
+	 */
+	struct hash_pair {
+		std::uint64_t h1;
+		std::uint64_t h2;
+	};
+	constexpr auto split(std::uint64_t h) noexcept -> hash_pair {
+		return {detail_hash::mum(h, mix::secret0),
+		        detail_hash::mum(h, mix::secret1) | 1u};
+	}
+
+	inline auto prefetch(const void* p) noexcept -> void {
+#if defined(__GNUC__)
+		__builtin_prefetch(p);
+#else
+		static_cast<void>(p);
+#endif
+	}
+
+	/**
+	 * @brief The classic layout: bit h1 + i * h2 of the whole array, for each
+	 * i in [0, k).
+	 */
+	struct plain_layout {
+		KBLIB_CONSTANT_M std::uint32_t id = 0;
+
+		static auto insert(block* blocks, std::size_t n, std::uint32_t k,
+		                   hash_pair h) noexcept -> void {
+			const std::uint64_t bits = n * block_bits;
+			for (std::uint32_t i = 0; i != k; ++i, h.h1 += h.h2) {
+				const auto bit = reduce(h.h1, bits);
+				blocks[bit / block_bits].words[bit % block_bits / 64]
+				    |= std::uint64_t{1} << (bit % 64);
+			}
+		}
+		static auto contains(const block* blocks, std::size_t n,
+		                     std::uint32_t k, hash_pair h) noexcept -> bool {
+			const std::uint64_t bits = n * block_bits;
+			for (std::uint32_t i = 0; i != k; ++i, h.h1 += h.h2) {
+				const auto bit = reduce(h.h1, bits);
+				if (not (blocks[bit / block_bits].words[bit % block_bits / 64]
+				         & (std::uint64_t{1} << (bit % 64)))) {
+					return false;
+				}
+			}
+			return true;
+		}
+		static auto prefetch(const block* blocks, std::size_t n,
+		                     hash_pair h) noexcept -> void {
+			// Only the first probe; the rest are usually never reached for
+			// absent keys
+			detail_bloom::prefetch(blocks + reduce(h.h1, n * block_bits)
+			                                    / block_bits);
+		}
+	};
+
+	/**
+	 * @brief The split block layout: h1 selects one 512-bit block, and the key
+	 * sets one bit in each of its eight words, chosen by the top six bits of
+	 * h2 times a per-word odd constant. The words are independent, so insert
+	 * and contains are branch-free and compile to a few vector instructions,
+	 * and each key costs at most one cache miss. k is always 8.
+	 */
+	struct blocked_layout {
+		KBLIB_CONSTANT_M std::uint32_t id = 1;
+
+		static auto masks(std::uint64_t h2, std::uint64_t (&m)[block_words]) noexcept
+		    -> void {
+			constexpr std::uint64_t salt[block_words]
+			    = {0x47b6137b44974d91u, 0x8824ad5ba2b7289du, 0x705495c72df1424bu,
+			       0x9efc49475c6bfb31u, 0x2df1424b705495c7u, 0x5c6bfb319efc4947u,
+			       0xa2b7289d8824ad5bu, 0x44974d9147b6137bu};
+			for (std::size_t i = 0; i != block_words; ++i) {
+				m[i] = std::uint64_t{1} << ((h2 * salt[i]) >> 58u);
+			}
+		}
+		static auto insert(block* blocks, std::size_t n, std::uint32_t,
+		                   hash_pair h) noexcept -> void {
+			auto& b = blocks[reduce(h.h1, n)];
+			std::uint64_t m[block_words];
+			masks(h.h2, m);
+			for (std::size_t i = 0; i != block_words; ++i) {
+				b.words[i] |= m[i];
+			}
+		}
+		static auto contains(const block* blocks, std::size_t n, std::uint32_t,
+		                     hash_pair h) noexcept -> bool {
+			const auto& b = blocks[reduce(h.h1, n)];
+			std::uint64_t m[block_words];
+			masks(h.h2, m);
+			std::uint64_t missing = 0;
+			for (std::size_t i = 0; i != block_words; ++i) {
+				missing |= m[i] & ~b.words[i];
+			}
+			return missing == 0;
+		}
+		static auto prefetch(const block* blocks, std::size_t n,
+		                     hash_pair h) noexcept -> void {
+			detail_bloom::prefetch(blocks + reduce(h.h1, n));
+		}
+	};
+
+	inline auto read_le32(const unsigned char* p) noexcept -> std::uint32_t {
+		return std::uint32_t{p[0]} | std::uint32_t{p[1]} << 8u
+		       | std::uint32_t{p[2]} << 16u | std::uint32_t{p[3]} << 24u;
+	}
+	inline auto write_le32(unsigned char* p, std::uint32_t v) noexcept -> void {
+		for (int i = 0; i != 4; ++i) {
+			p[i] = static_cast<unsigned char>(v >> (8 * i));
+		}
+	}
+	inline auto write_le64(unsigned char* p, std::uint64_t v) noexcept -> void {
+		for (int i = 0; i != 8; ++i) {
+			p[i] = static_cast<unsigned char>(v >> (8 * i));
+		}
+	}
+
+	/**
+	 * @brief The parameters stored in a serialized filter's header.
+	 */
+	struct header {
+		std::uint32_t k;
+		std::uint64_t block_count;
+	};
+
+	/**
+	 * @brief Validates a serialized filter of the given layout, and returns its
+	 * parameters.
+	 *
+	 * @throw std::invalid_argument if the buffer is not such a filter.
+	 */
+	inline auto parse_header(const unsigned char* p, std::size_t size,
+	                         std::uint32_t layout_id) -> header {
+		if (size < header_size
+		    or std::memcmp(p, magic, sizeof(magic)) != 0) {
+			throw std::invalid_argument("bloom_filter: not a serialized filter");
+		}
+		if (read_le32(p + 8) != 1 or read_le32(p + 12) != layout_id) {
+			throw std::invalid_argument(
+			    "bloom_filter: unsupported version or layout");
+		}
+		const header h{read_le32(p + 16),
+		               std::uint64_t{read_le32(p + 24)}
+		                   | std::uint64_t{read_le32(p + 28)} << 32u};
+		if (h.k == 0 or h.block_count == 0
+		    or (size - header_size) / sizeof(block) < h.block_count) {
+			throw std::invalid_argument("bloom_filter: truncated filter");
+		}
+		return h;
+	}
+
+	/**
+	 * @brief The lookup operations shared by filters and views. Derived
+	 * provides blocks() and block_count().
+	 */
+	template <typename Derived, typename T, typename Hash, typename Layout>
+	class filter_base {
+	 public:
+		using key_type = T;
+		using hasher = Hash;
+
+		/**
+		 * @brief Returns false if key was definitely never inserted, and true if
+		 * it probably was.
+		 */
+		KBLIB_NODISCARD auto contains(const T& key) const noexcept -> bool {
+			return Layout::contains(self().blocks(), self().block_count(), k,
+			                        hash_of(key));
+		}
+
+		/**
+		 * @brief Writes contains(*it) to out for each it in [first, last). Much
+		 * faster than separate calls for large filters, as the memory accesses
+		 * of a batch of keys are overlapped.
+		 */
+		template <typename InputIt, typename OutputIt>
+		auto contains(InputIt first, InputIt last, OutputIt out) const
+		    -> OutputIt {
+			const block* blocks = self().blocks();
+			const std::size_t n = self().block_count();
+			hash_pair hashes[batch_size];
+			while (first != last) {
+				const std::size_t count = hash_batch(first, last, hashes);
+				for (std::size_t i = 0; i != count; ++i) {
+					Layout::prefetch(blocks, n, hashes[i]);
+				}
+				for (std::size_t i = 0; i != count; ++i) {
+					*out++ = Layout::contains(blocks, n, k, hashes[i]);
+				}
+			}
+			return out;
+		}
+
+		/**
+		 * @brief The number of bits set per key.
+		 */
+		KBLIB_NODISCARD auto hash_count() const noexcept -> std::size_t {
+			return k;
+		}
+		KBLIB_NODISCARD auto bit_count() const noexcept -> std::size_t {
+			return self().block_count() * block_bits;
+		}
+		KBLIB_NODISCARD auto hash_function() const -> hasher { return hash; }
+
+		/**
+		 * @brief Writes the filter in the format read by deserialize and by
+		 * views: a 64-byte header followed by the bits, as little-endian 64-bit
+		 * words.
+		 */
+		KBLIB_NODISCARD auto serialize() const -> std::vector<unsigned char> {
+			const std::size_t n = self().block_count();
+			std::vector<unsigned char> out(header_size + n * sizeof(block));
+			std::memcpy(out.data(), magic, sizeof(magic));
+			write_le32(out.data() + 8, 1);
+			write_le32(out.data() + 12, Layout::id);
+			write_le32(out.data() + 16, k);
+			write_le64(out.data() + 24, n);
+			auto* p = out.data() + header_size;
+			const block* blocks = self().blocks();
+			for (std::size_t b = 0; b != n; ++b) {
+				for (auto word : blocks[b].words) {
+					write_le64(p, word);
+					p += 8;
+				}
+			}
+			return out;
+		}
+
+	 protected:
+		filter_base(std::uint32_t hashes, const Hash& h)
+		    : hash(h)
+		    , k(hashes) {}
+
+		auto hash_of(const T& key) const noexcept -> hash_pair {
+			return split(static_cast<std::uint64_t>(hash(key)));
+		}
+
+		/**
+		 * @brief Hashes up to batch_size keys from first, advancing it, and
+		 * returns how many were hashed.
+		 */
+		template <typename InputIt>
+		auto hash_batch(InputIt& first, InputIt last,
+		                hash_pair (&out)[batch_size]) const -> std::size_t {
+			std::size_t count = 0;
+			for (; count != batch_size and first != last; ++count, ++first) {
+				out[count] = hash_of(*first);
+			}
+			return count;
+		}
+		/**
+		 * @brief Contiguous keys are hashed with hash_many, which is several
+		 * times faster for fixed-size keys.
+		 */
+		auto hash_batch(const T*& first, const T* last,
+		                hash_pair (&out)[batch_size]) const -> std::size_t {
+			const auto count = std::min(batch_size, to_unsigned(last - first));
+			std::uint64_t raw[batch_size];
+			kblib::hash_many(hash, first, count, raw);
+			for (std::size_t i = 0; i != count; ++i) {
+				out[i] = split(raw[i]);
+			}
+			first += count;
+			return count;
+		}
+		auto hash_batch(T*& first, T* last, hash_pair (&out)[batch_size]) const
+		    -> std::size_t {
+			const T* cfirst = first;
+			const auto count = hash_batch(cfirst, last, out);
+			first += count;
+			return count;
+		}
+
+		Hash hash;
+		std::uint32_t k;
+
+	 private:
+		auto self() const noexcept -> const Derived& {
+			return static_cast<const Derived&>(*this);
+		}
+	};
+
+} // namespace detail_bloom
+
+/**
+ * @brief A Bloom filter: a set that may report false positives but never
+ * false negatives, in a fixed number of bits per key.
+ *
+ * Layout selects between the classic bit layout (bloom_filter), which needs
+ * the fewest bits for a given false positive rate, and the cache-line-blocked
+ * layout (blocked_bloom_filter), which takes one cache miss per key instead of
+ * up to k, at the cost of a few percent more bits. The blocked layout always
+ * sets 8 bits per key, so it is sized for false positive rates near 1%.
+ *
+ * Keys are hashed once with Hash, which must produce at least 64 bits.
+ */
+template <typename T, typename Hash, typename Layout>
+class basic_bloom_filter
+    : public detail_bloom::filter_base<basic_bloom_filter<T, Hash, Layout>, T,
+                                       Hash, Layout> {
+	using base = detail_bloom::filter_base<basic_bloom_filter, T, Hash, Layout>;
+	friend base;
+
+ public:
+	/**
+	 * @brief Sizes the filter to hold expected_items keys with the given false
+	 * positive rate.
+	 */
+	explicit basic_bloom_filter(std::size_t expected_items,
+	                            double false_positive_rate = 0.01,
+	                            const Hash& h = Hash{})
+	    : base(hash_count_for(expected_items, false_positive_rate), h)
+	    , storage(block_count_for(expected_items, false_positive_rate)) {}
+
+	/**
+	 * @brief Reads a filter written by serialize. The buffer is copied, and
+	 * need not be aligned.
+	 *
+	 * @throw std::invalid_argument if data does not hold a filter of this
+	 * layout.
+	 */
+	KBLIB_NODISCARD static auto deserialize(const void* data, std::size_t size,
+	                                        const Hash& h = Hash{})
+	    -> basic_bloom_filter {
+		const auto* p = static_cast<const unsigned char*>(data);
+		const auto header = detail_bloom::parse_header(p, size, Layout::id);
+		basic_bloom_filter f(header.k,
+		                     static_cast<std::size_t>(header.block_count), h);
+		p += detail_bloom::header_size;
+		for (auto& b : f.storage) {
+			for (auto& word : b.words) {
+				word = std::uint64_t{detail_bloom::read_le32(p)}
+				       | std::uint64_t{detail_bloom::read_le32(p + 4)} << 32u;
+				p += 8;
+			}
+		}
+		return f;
+	}
+
+	auto insert(const T& key) noexcept -> void {
+		Layout::insert(storage.data(), storage.size(), this->k,
+		               this->hash_of(key));
+	}
+
+	/**
+	 * @brief Inserts every key in [first, last), overlapping the memory
+	 * accesses of a batch of keys.
+	 */
+	template <typename InputIt>
+	auto insert(InputIt first, InputIt last) -> void {
+		detail_bloom::hash_pair hashes[detail_bloom::batch_size];
+		while (first != last) {
+			const std::size_t count = this->hash_batch(first, last, hashes);
+			for (std::size_t i = 0; i != count; ++i) {
+				Layout::prefetch(storage.data(), storage.size(), hashes[i]);
+			}
+			for (std::size_t i = 0; i != count; ++i) {
+				Layout::insert(storage.data(), storage.size(), this->k, hashes[i]);
+			}
+		}
+	}
+
+	/**
+	 * @brief Adds all of other's keys to this filter. other must have been
+	 * created with the same parameters.
+	 */
+	auto merge(const basic_bloom_filter& other) -> void {
+		if (other.storage.size() != storage.size() or other.k != this->k) {
+			throw std::invalid_argument("bloom_filter: incompatible filters");
+		}
+		for (std::size_t b = 0; b != storage.size(); ++b) {
+			for (std::size_t w = 0; w != detail_bloom::block_words; ++w) {
+				storage[b].words[w] |= other.storage[b].words[w];
+			}
+		}
+	}
+
+	auto clear() noexcept -> void {
+		std::fill(storage.begin(), storage.end(), detail_bloom::block{});
+	}
+
+ private:
+	basic_bloom_filter(std::uint32_t hashes, std::size_t blocks, const Hash& h)
+	    : base(hashes, h)
+	    , storage(blocks) {}
+
+	static auto bits_for(std::size_t n, double p) -> double {
+		if (not (p > 0 and p < 1)) {
+			throw std::invalid_argument(
+			    "bloom_filter: false positive rate must be in (0, 1)");
+		}
+		const double ln2 = std::log(2.0);
+		const double bits
+		    = -static_cast<double>(std::max(n, std::size_t{1})) * std::log(p)
+		      / (ln2 * ln2);
+		// Blocks fill unevenly, which is made up for with extra bits
+		return std::is_same<Layout, detail_bloom::blocked_layout>::value
+		           ? bits * 1.08
+		           : bits;
+	}
+	static auto block_count_for(std::size_t n, double p) -> std::size_t {
+		return static_cast<std::size_t>(
+		    std::ceil(bits_for(n, p) / detail_bloom::block_bits));
+	}
+	static auto hash_count_for(std::size_t n, double p) -> std::uint32_t {
+		if (std::is_same<Layout, detail_bloom::blocked_layout>::value) {
+			return detail_bloom::block_words;
+		}
+		const double k = bits_for(n, p) / static_cast<double>(std::max(
+		                     n, std::size_t{1})) * std::log(2.0);
+		return static_cast<std::uint32_t>(
+		    std::min(std::max(std::round(k), 1.0), 32.0));
+	}
+
+	auto blocks() const noexcept -> const detail_bloom::block* {
+		return storage.data();
+	}
+	auto block_count() const noexcept -> std::size_t { return storage.size(); }
+
+	std::vector<detail_bloom::block> storage;
+};
+
+/**
+ * @brief A read-only Bloom filter over a buffer written by
+ * basic_bloom_filter::serialize, such as a memory-mapped file, without
+ * copying it. The buffer must outlive the view.
+ */
+template <typename T, typename Hash, typename Layout>
+class basic_bloom_filter_view
+    : public detail_bloom::filter_base<basic_bloom_filter_view<T, Hash, Layout>,
+                                       T, Hash, Layout> {
+	using base
+	    = detail_bloom::filter_base<basic_bloom_filter_view, T, Hash, Layout>;
+	friend base;
+
+ public:
+	/**
+	 * @param data The serialized filter. Its bits are read in place as
+	 * cache-line-aligned blocks, so data must be aligned to 64 bytes, as
+	 * mapped files and page-aligned allocations are.
+	 *
+	 * @throw std::invalid_argument if data does not hold a filter of this
+	 * layout, is not aligned to 64 bytes, or if this is not a little-endian
+	 * system.
+	 */
+	basic_bloom_filter_view(const void* data, std::size_t size,
+	                        const Hash& h = Hash{})
+	    : basic_bloom_filter_view(parse(data, size), data, h) {}
+
+ private:
+	basic_bloom_filter_view(detail_bloom::header header, const void* data,
+	                        const Hash& h)
+	    : base(header.k, h)
+	    , _blocks(reinterpret_cast<const detail_bloom::block*>(
+	          static_cast<const unsigned char*>(data)
+	          + detail_bloom::header_size))
+	    , _block_count(static_cast<std::size_t>(header.block_count)) {}
+
+	static auto parse(const void* data, std::size_t size)
+	    -> detail_bloom::header {
+		if (system_endian != endian::little) {
+			throw std::invalid_argument(
+			    "bloom_filter_view: requires a little-endian system");
+		}
+		const auto bits = static_cast<const unsigned char*>(data)
+		                  + detail_bloom::header_size;
+		if (reinterpret_cast<std::uintptr_t>(bits)
+		        % alignof(detail_bloom::block)
+		    != 0) {
+			throw std::invalid_argument("bloom_filter_view: misaligned buffer");
+		}
+		return detail_bloom::parse_header(
+		    static_cast<const unsigned char*>(data), size, Layout::id);
+	}
+
+	auto blocks() const noexcept -> const detail_bloom::block* {
+		return _blocks;
+	}
+	auto block_count() const noexcept -> std::size_t { return _block_count; }
+
+	const detail_bloom::block* _blocks;
+	std::size_t _block_count;
+};
+
+template <typename T, typename Hash = FNV_hash<T, std::uint64_t>>
+using bloom_filter = basic_bloom_filter<T, Hash, detail_bloom::plain_layout>;
+template <typename T, typename Hash = FNV_hash<T, std::uint64_t>>
+using blocked_bloom_filter
+    = basic_bloom_filter<T, Hash, detail_bloom::blocked_layout>;
+
+template <typename T, typename Hash = FNV_hash<T, std::uint64_t>>
+using bloom_filter_view
+    = basic_bloom_filter_view<T, Hash, detail_bloom::plain_layout>;
+template <typename T, typename Hash = FNV_hash<T, std::uint64_t>>
+using blocked_bloom_filter_view
+    = basic_bloom_filter_view<T, Hash, detail_bloom::blocked_layout>;
+
+} // namespace KBLIB_NS
+
+#endif // BLOOM_FILTER_H
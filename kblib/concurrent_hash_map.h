@@ -0,0 +1,346 @@
+/* *****************************************************************************
+ * kblib is a general utility library for C++14 and C++17, intended to provide
+ * performant high-level abstractions and more expressive ways to do simple
+ * things.
+ *
+ * Copyright (c) 2021 killerbee
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/**
+ * @file
+ * @brief Provides concurrent_hash_map, a hash map that many threads can
+ * read and write at once.
+ *
+ * @author killerbee
+ * @date 2019-2021
+ * @copyright GNU General Public Licence v3.0
+ */
+
+#ifndef CONCURRENT_HASH_MAP_H
+#define CONCURRENT_HASH_MAP_H
+
+#include "flat_hash_map.h"
+#include "hash.h"
+#include "tdecl.h"
+
+#if KBLIB_USE_CXX17
+
+#	include <memory>
+#	include <mutex>
+#	include <optional>
+#	include <shared_mutex>
+#	include <thread>
+
+namespace KBLIB_NS {
+
+namespace detail_concurrent {
+
+	/**
+	 * @brief Shards are aligned to this, so that threads locking neighbouring
+	 * shards do not contend for one cache line.
+	 */
+	KBLIB_CONSTANT std::size_t cache_line = 64;
+
+	/**
+	 * @brief The default number of shards: a power of two at least four times
+	 * the number of hardware threads, so that threads rarely meet on a shard.
+	 */
+	inline auto default_shard_count() -> std::size_t {
+		const std::size_t want
+		    = 4 * std::max(std::thread::hardware_concurrency(), 1u);
+		std::size_t n = 1;
+		while (n < want) {
+			n *= 2;
+		}
+		return n;
+	}
+
+} // namespace detail_concurrent
+
+/**
+ * @brief A hash map that can be used by many threads at once, by striping it
+ * into independently locked shards.
+ *
+ * Each shard is a flat_hash_map guarded by a reader-writer lock, and a key's
+ * hash selects its shard, so operations on keys in different shards never
+ * wait for each other and lookups never wait for other lookups. With enough
+ * shards, throughput scales nearly linearly with the number of threads.
+ *
+ * Because another thread may erase an element at any time, no references or
+ * iterators to elements are handed out. Elements are instead read by copy
+ * (find), or accessed in place while their shard is locked (visit, cvisit,
+ * visit_all). Visitors must not call back into the same map.
+ *
+ * Operations that cover the whole map (size, clear, visit_all) lock one
+ * shard at a time, so they are not atomic with respect to other threads.
+ */
+template <typename Key, typename T, typename Hash = FNV_hash<>,
+          typename KeyEqual = std::equal_to<>>
+class concurrent_hash_map {
+	using map_type = flat_hash_map<Key, T, Hash, KeyEqual>;
+
+ public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using size_type = std::size_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+
+	/**
+	 * @param shard_count The number of independently locked shards. Rounded
+	 * up to a power of two.
+	 */
+	explicit concurrent_hash_map(
+	    size_type shard_count = detail_concurrent::default_shard_count(),
+	    const Hash& h = Hash{}, const KeyEqual& eq = KeyEqual{})
+	    : hash(h) {
+		size_type n = 1;
+		while (n < shard_count) {
+			n *= 2;
+		}
+		shard_mask = n - 1;
+		shards = std::make_unique<shard[]>(n);
+		for (size_type i = 0; i != n; ++i) {
+			shards[i].map = map_type(0, h, eq);
+		}
+	}
+
+	concurrent_hash_map(const concurrent_hash_map&) = delete;
+	auto operator=(const concurrent_hash_map&) -> concurrent_hash_map& = delete;
+
+	KBLIB_NODISCARD auto shard_count() const noexcept -> size_type {
+		return shard_mask + 1;
+	}
+
+	/**
+	 * @brief Reserves room for count elements in total, spread evenly over the
+	 * shards.
+	 */
+	auto reserve(size_type count) -> void {
+		const auto per_shard = (count + shard_mask) / shard_count();
+		for_each_shard([&](map_type& m) { m.reserve(per_shard); });
+	}
+
+	/**
+	 * @brief Inserts T(args...) under key if key is not present.
+	 *
+	 * @return bool Whether the element was inserted.
+	 */
+	template <typename K, typename... Args>
+	auto try_emplace(K&& key, Args&&... args) -> bool {
+		auto& s = shard_of(key);
+		std::unique_lock<std::shared_mutex> lock(s.mutex);
+		return s.map.try_emplace(std::forward<K>(key), std::forward<Args>(args)...)
+		    .second;
+	}
+
+	/**
+	 * @brief Inserts or replaces the value of key.
+	 *
+	 * @return bool Whether the element was inserted, rather than assigned.
+	 */
+	template <typename K, typename M>
+	auto insert_or_assign(K&& key, M&& obj) -> bool {
+		auto& s = shard_of(key);
+		std::unique_lock<std::shared_mutex> lock(s.mutex);
+		return s.map.insert_or_assign(std::forward<K>(key), std::forward<M>(obj))
+		    .second;
+	}
+
+	/**
+	 * @brief Inserts T(args...) under key if key is not present, and otherwise
+	 * calls f(T&) on the existing value, all under one lock. This is the
+	 * building block for concurrent accumulation, e.g. counting words:
+	 *
+	 * @code
+	 * counts.try_emplace_or_visit(word, [](int& c) { ++c; }, 1);
+	 * @endcode
+	 *
+	 * @return bool Whether the element was inserted.
+	 */
+	template <typename K, typename F, typename... Args>
+	auto try_emplace_or_visit(K&& key, F&& f, Args&&... args) -> bool {
+		auto& s = shard_of(key);
+		std::unique_lock<std::shared_mutex> lock(s.mutex);
+		auto r = s.map.try_emplace(std::forward<K>(key),
+		                           std::forward<Args>(args)...);
+		if (not r.second) {
+			std::forward<F>(f)(r.first->second);
+		}
+		return r.second;
+	}
+
+	/**
+	 * @brief Returns a copy of the value of key, if present.
+	 */
+	template <typename K>
+	KBLIB_NODISCARD auto find(const K& key) const -> std::optional<T> {
+		auto& s = shard_of(key);
+		std::shared_lock<std::shared_mutex> lock(s.mutex);
+		auto it = s.map.find(key);
+		if (it == s.map.end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	template <typename K>
+	KBLIB_NODISCARD auto contains(const K& key) const -> bool {
+		auto& s = shard_of(key);
+		std::shared_lock<std::shared_mutex> lock(s.mutex);
+		return s.map.contains(key);
+	}
+	template <typename K>
+	KBLIB_NODISCARD auto count(const K& key) const -> size_type {
+		return contains(key);
+	}
+
+	/**
+	 * @brief Calls f(T&) on the value of key, if present, while holding its
+	 * shard's lock exclusively.
+	 *
+	 * @return bool Whether key was present.
+	 */
+	template <typename K, typename F>
+	auto visit(const K& key, F&& f) -> bool {
+		auto& s = shard_of(key);
+		std::unique_lock<std::shared_mutex> lock(s.mutex);
+		auto it = s.map.find(key);
+		if (it == s.map.end()) {
+			return false;
+		}
+		std::forward<F>(f)(it->second);
+		return true;
+	}
+
+	/**
+	 * @brief Calls f(const T&) on the value of key, if present, while holding
+	 * its shard's lock shared, so that other readers are not blocked.
+	 *
+	 * @return bool Whether key was present.
+	 */
+	template <typename K, typename F>
+	auto cvisit(const K& key, F&& f) const -> bool {
+		auto& s = shard_of(key);
+		std::shared_lock<std::shared_mutex> lock(s.mutex);
+		auto it = s.map.find(key);
+		if (it == s.map.end()) {
+			return false;
+		}
+		std::forward<F>(f)(static_cast<const T&>(it->second));
+		return true;
+	}
+
+	/**
+	 * @brief Calls f(value_type&) on every element, locking one shard at a
+	 * time.
+	 */
+	template <typename F>
+	auto visit_all(F f) -> void {
+		for_each_shard([&](map_type& m) {
+			for (auto& v : m) {
+				f(v);
+			}
+		});
+	}
+	/**
+	 * @brief Calls f(const value_type&) on every element, locking one shard at
+	 * a time.
+	 */
+	template <typename F>
+	auto cvisit_all(F f) const -> void {
+		for (size_type i = 0; i != shard_count(); ++i) {
+			auto& s = shards[i];
+			std::shared_lock<std::shared_mutex> lock(s.mutex);
+			for (const auto& v : s.map) {
+				f(v);
+			}
+		}
+	}
+
+	/**
+	 * @return size_type The number of elements removed (0 or 1).
+	 */
+	template <typename K>
+	auto erase(const K& key) -> size_type {
+		auto& s = shard_of(key);
+		std::unique_lock<std::shared_mutex> lock(s.mutex);
+		return s.map.erase(key);
+	}
+
+	auto clear() -> void {
+		for_each_shard([](map_type& m) { m.clear(); });
+	}
+
+	/**
+	 * @brief The number of elements. Only exact if no other thread is modifying
+	 * the map.
+	 */
+	KBLIB_NODISCARD auto size() const -> size_type {
+		size_type n = 0;
+		for (size_type i = 0; i != shard_count(); ++i) {
+			auto& s = shards[i];
+			std::shared_lock<std::shared_mutex> lock(s.mutex);
+			n += s.map.size();
+		}
+		return n;
+	}
+	KBLIB_NODISCARD auto empty() const -> bool { return size() == 0; }
+
+	KBLIB_NODISCARD auto hash_function() const -> hasher { return hash; }
+
+ private:
+	struct alignas(detail_concurrent::cache_line) shard {
+		mutable std::shared_mutex mutex;
+		map_type map;
+	};
+
+	template <typename K>
+	auto shard_of(const K& key) const -> shard& {
+		// Arguments that the shard's map would convert to Key, such as string
+		// literals, must be hashed the same way
+		if constexpr (not std::is_same_v<K, Key>
+		              and std::is_convertible_v<const K&, Key>) {
+			return shard_of(static_cast<Key>(key));
+		} else {
+			// The top bits of a remixed hash, as the shard's own table uses the
+			// low bits of its hash
+			const auto h = detail_hash::mum(
+			    static_cast<std::uint64_t>(hash(key)), mix::secret1);
+			return shards[static_cast<size_type>(h >> 32u) & shard_mask];
+		}
+	}
+
+	template <typename F>
+	auto for_each_shard(F f) -> void {
+		for (size_type i = 0; i != shard_count(); ++i) {
+			auto& s = shards[i];
+			std::unique_lock<std::shared_mutex> lock(s.mutex);
+			f(s.map);
+		}
+	}
+
+	Hash hash;
+	size_type shard_mask{};
+	std::unique_ptr<shard[]> shards;
+};
+
+} // namespace KBLIB_NS
+
+#endif // KBLIB_USE_CXX17
+
+#endif // CONCURRENT_HASH_MAP_H
@@ -0,0 +1,458 @@
+/* *****************************************************************************
+ * kblib is a general utility library for C++14 and C++17, intended to provide
+ * performant high-level abstractions and more expressive ways to do simple
+ * things.
+ *
+ * Copyright (c) 2021 killerbee
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/**
+ * @file
+ * @brief Provides an external (out-of-core) merge sort, for sorting data which
+ * does not fit in memory.
+ *
+ * @author killerbee
+ * @date 2021
+ * @copyright GNU General Public Licence v3.0
+ */
+
+#ifndef KBLIB_EXTERNAL_SORT_H
+#define KBLIB_EXTERNAL_SORT_H
+
+#include "io.h"
+#include "sort.h"
+
+#if KBLIB_USE_CXX17
+
+#	include <atomic>
+#	include <cstring>
+#	include <filesystem>
+#	include <fstream>
+#	include <random>
+#	include <string>
+
+namespace KBLIB_NS {
+
+/**
+ * @brief Describes how external_sort stores records of type T in its
+ * temporary files. Specialize it to external sort other types.
+ *
+ * A specialization provides:
+ * - size(x): the number of bytes x is stored in,
+ * - write(x, out): stores x into the size(x) bytes at out,
+ * - read(in, avail, x): loads x from the avail bytes at in, and returns the
+ * number of bytes used, or 0 if they do not hold a whole record,
+ * - footprint(x): an estimate of the memory used by x, counted against the
+ * memory budget.
+ *
+ * The primary template handles trivially copyable types, and linear containers
+ * (such as std::string) of them.
+ */
+template <typename T, typename = void>
+struct record_io;
+
+template <typename T>
+struct record_io<T, enable_if_t<std::is_trivially_copyable<T>::value>> {
+	static auto size(const T&) noexcept -> std::size_t { return sizeof(T); }
+	static auto write(const T& x, char* out) noexcept -> void {
+		std::memcpy(out, &x, sizeof(T));
+	}
+	static auto read(const char* in, std::size_t avail, T& x) noexcept
+	    -> std::size_t {
+		if (avail < sizeof(T)) {
+			return 0;
+		}
+		std::memcpy(&x, in, sizeof(T));
+		return sizeof(T);
+	}
+	static auto footprint(const T&) noexcept -> std::size_t {
+		return sizeof(T);
+	}
+};
+
+template <typename T>
+struct record_io<
+    T, enable_if_t<is_linear_container_v<T>
+                   and std::is_trivially_copyable<typename T::value_type>::value
+                   and not std::is_trivially_copyable<T>::value>> {
+	using value_type = typename T::value_type;
+	using length_type = std::uint64_t;
+
+	static auto size(const T& x) noexcept -> std::size_t {
+		return sizeof(length_type) + x.size() * sizeof(value_type);
+	}
+	static auto write(const T& x, char* out) noexcept -> void {
+		const auto length = static_cast<length_type>(x.size());
+		std::memcpy(out, &length, sizeof(length));
+		if (length) {
+			std::memcpy(out + sizeof(length), x.data(),
+			            x.size() * sizeof(value_type));
+		}
+	}
+	static auto read(const char* in, std::size_t avail, T& x) -> std::size_t {
+		length_type length;
+		if (avail < sizeof(length)) {
+			return 0;
+		}
+		std::memcpy(&length, in, sizeof(length));
+		const auto bytes = sizeof(length) + length * sizeof(value_type);
+		if (avail < bytes) {
+			return 0;
+		}
+		x.resize(static_cast<std::size_t>(length));
+		if (length) {
+			std::memcpy(&x[0], in + sizeof(length), bytes - sizeof(length));
+		}
+		return bytes;
+	}
+	static auto footprint(const T& x) noexcept -> std::size_t {
+		return sizeof(T) + x.size() * sizeof(value_type);
+	}
+};
+
+/**
+ * @brief Tuning parameters for external_sort.
+ */
+struct external_sort_options {
+	/**
+	 * @brief The approximate amount of memory, in bytes, to use for records
+	 * and I/O buffers. Half of it holds the records of each initial run, and
+	 * the rest is scratch space for sorting them.
+	 */
+	std::size_t memory_budget = std::size_t{256} << 20u;
+	/**
+	 * @brief The size in bytes of the buffer through which each temporary file
+	 * is read or written. While merging, memory_budget / io_buffer_size - 1
+	 * runs (but at least 2) are merged at once, leaving room for the buffer of
+	 * the run being written.
+	 */
+	std::size_t io_buffer_size = std::size_t{1} << 20u;
+	/**
+	 * @brief Where to create the temporary files. They are removed when they
+	 * are no longer needed. If empty, std::filesystem::temp_directory_path()
+	 * is used, which is only looked up once a temporary file is needed.
+	 */
+	std::filesystem::path temp_directory;
+};
+
+namespace detail_sort {
+
+	/**
+	 * @brief Creates a new temporary file in options.temp_directory, which is
+	 * removed when it is closed.
+	 */
+	inline auto make_run_file(const external_sort_options& options) {
+		static std::atomic<unsigned long long> counter{};
+		thread_local std::mt19937_64 rng{std::random_device{}()};
+		const auto name = "kblib-sort-" + std::to_string(rng()) + '-'
+		                  + std::to_string(counter++) + ".tmp";
+		const auto path = (options.temp_directory.empty()
+		                       ? std::filesystem::temp_directory_path()
+		                       : options.temp_directory)
+		                  / name;
+		auto file = kblib::tmpfile<std::fstream>(
+		    path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc
+		              | std::ios_base::binary);
+		if (not *file) {
+			throw std::ios_base::failure("could not create temporary file "
+			                             + path.string());
+		}
+		return file;
+	}
+
+	using run_file
+	    = decltype(make_run_file(std::declval<const external_sort_options&>()));
+
+	/**
+	 * @brief Writes records to a run file in large sequential blocks.
+	 */
+	template <typename T>
+	class run_writer {
+	 public:
+		run_writer(run_file& file, std::size_t buffer_size)
+		    : file_(file) {
+			buffer_.reserve(buffer_size);
+		}
+
+		auto push(const T& x) -> void {
+			const auto size = record_io<T>::size(x);
+			if (buffer_.size() + size > buffer_.capacity()) {
+				flush();
+				// Records larger than the buffer grow it
+				buffer_.reserve(size);
+			}
+			const auto pos = buffer_.size();
+			buffer_.resize(pos + size);
+			record_io<T>::write(x, buffer_.data() + pos);
+		}
+
+		/**
+		 * @brief Writes out any buffered records and rewinds the file, so that
+		 * it can be read back by a run_reader.
+		 */
+		auto finish() -> void {
+			flush();
+			file_->flush();
+			file_->seekg(0);
+			if (not *file_) {
+				throw std::ios_base::failure("could not write temporary file");
+			}
+		}
+
+	 private:
+		auto flush() -> void {
+			file_->write(buffer_.data(), to_signed(buffer_.size()));
+			if (not *file_) {
+				throw std::ios_base::failure("could not write temporary file");
+			}
+			buffer_.clear();
+		}
+
+		run_file& file_;
+		std::vector<char> buffer_;
+	};
+
+	/**
+	 * @brief Reads records back from a run file in large sequential blocks.
+	 */
+	template <typename T>
+	class run_reader {
+	 public:
+		run_reader(run_file file, std::size_t buffer_size)
+		    : file_(std::move(file))
+		    , buffer_(buffer_size) {}
+
+		/**
+		 * @brief Reads the next record into x.
+		 *
+		 * @return false if the run is exhausted.
+		 */
+		auto next(T& x) -> bool {
+			while (true) {
+				const auto used
+				    = record_io<T>::read(buffer_.data() + pos_, size_ - pos_, x);
+				if (used) {
+					pos_ += used;
+					return true;
+				} else if (eof_) {
+					if (pos_ != size_) {
+						throw std::ios_base::failure("truncated temporary file");
+					}
+					return false;
+				}
+				fill();
+			}
+		}
+
+	 private:
+		auto fill() -> void {
+			std::copy(buffer_.begin() + to_signed(pos_),
+			          buffer_.begin() + to_signed(size_), buffer_.begin());
+			size_ -= pos_;
+			pos_ = 0;
+			if (size_ == buffer_.size()) {
+				// A record larger than the buffer
+				buffer_.resize(buffer_.size() * 2);
+			}
+			file_->read(buffer_.data() + size_, to_signed(buffer_.size() - size_));
+			const auto got = to_unsigned(file_->gcount());
+			if (file_->bad()) {
+				throw std::ios_base::failure("could not read temporary file");
+			}
+			size_ += got;
+			eof_ = (got == 0);
+			file_->clear();
+		}
+
+		run_file file_;
+		std::vector<char> buffer_;
+		std::size_t pos_{};
+		std::size_t size_{};
+		bool eof_{};
+	};
+
+	/**
+	 * @brief Merges the given runs with a loser tree, passing each record in
+	 * order to out. Equivalent records are taken from earlier runs first.
+	 *
+	 * The current record of each run is kept in a default constructed T,
+	 * which record_io<T>::read overwrites.
+	 */
+	template <typename T, typename UnaryOperation, typename BinaryPredicate,
+	          typename Out>
+	auto merge_runs(std::vector<run_file> runs, UnaryOperation& transform,
+	                BinaryPredicate& compare, std::size_t buffer_size, Out out)
+	    -> void {
+		const auto k = runs.size();
+		std::vector<run_reader<T>> readers;
+		readers.reserve(k);
+		for (auto& r : runs) {
+			readers.emplace_back(std::move(r), buffer_size);
+		}
+		std::vector<T> heads(k);
+		std::vector<bool> live(k);
+		for (auto i : range(k)) {
+			live[i] = readers[i].next(heads[i]);
+		}
+		auto beats = [&](std::size_t a, std::size_t b) {
+			if (not live[a]) {
+				return false;
+			} else if (not live[b]) {
+				return true;
+			}
+			const auto& x = kblib::invoke(transform, heads[a]);
+			const auto& y = kblib::invoke(transform, heads[b]);
+			if (kblib::invoke(compare, x, y)) {
+				return true;
+			} else if (kblib::invoke(compare, y, x)) {
+				return false;
+			} else {
+				return a < b;
+			}
+		};
+		loser_tree<decltype(beats)> tree(k, beats);
+		while (live[tree.top()]) {
+			const auto t = tree.top();
+			out(std::move(heads[t]));
+			live[t] = readers[t].next(heads[t]);
+			tree.replay();
+		}
+	}
+
+} // namespace detail_sort
+
+/**
+ * @brief Sorts the records of an input range after applying a transformation,
+ * using temporary files so that the input may be larger than memory, and
+ * writes them in order to an output iterator.
+ *
+ * The input is read in runs which fit in half of options.memory_budget. Each
+ * run is sorted in memory with stable_sort_transform (so radix sortable keys
+ * are radix sorted) and written to a temporary file. The runs are then
+ * combined by k-way merges, in as many passes as the memory budget requires.
+ * If the whole input fits in one run, no files are created.
+ *
+ * The sort is stable. Records are stored in the temporary files as described
+ * by record_io<value_type>, and must be default constructible, because they
+ * are read back into existing objects. Merging holds one record per run in
+ * memory on top of the I/O buffers.
+ *
+ * @param begin,end The records to sort. They are only read once, so input
+ * iterators (such as std::istream_iterator) are sufficient.
+ * @param d_begin Where to write the sorted records
+ * @param transform A transformer which will be applied to each record before
+ * comparing it
+ * @param compare A comparison predicate which returns true if the first
+ * argument shall be ordered before the second
+ * @param options The memory budget and location of the temporary files
+ * @return The end of the output range
+ * @throws std::ios_base::failure if a temporary file cannot be created,
+ * written, or read back.
+ */
+template <typename InputIt, typename OutputIt, typename UnaryOperation,
+          typename BinaryPredicate>
+auto external_sort_transform(InputIt begin, InputIt end, OutputIt d_begin,
+                             UnaryOperation transform, BinaryPredicate compare,
+                             const external_sort_options& options = {})
+    -> OutputIt {
+	using T = typename std::iterator_traits<InputIt>::value_type;
+	static_assert(std::is_default_constructible<T>::value,
+	              "external_sort requires default constructible records");
+	using io = record_io<T>;
+	const auto run_budget = std::max(options.memory_budget / 2, std::size_t{1});
+	const auto buffer_size = std::max(options.io_buffer_size, std::size_t{64});
+	// An intermediate merge pass also writes its output through a buffer
+	const auto fan_in
+	    = std::max(options.memory_budget / buffer_size, std::size_t{3}) - 1;
+
+	if (begin == end) {
+		return d_begin;
+	}
+	std::vector<detail_sort::run_file> runs;
+	std::vector<T> chunk;
+	std::vector<T> scratch;
+	bool more = true;
+	while (more) {
+		std::size_t used{};
+		while (begin != end and used < run_budget) {
+			chunk.push_back(*begin);
+			used += io::footprint(chunk.back());
+			++begin;
+		}
+		more = begin != end;
+		kblib::stable_sort_transform(chunk.begin(), chunk.end(), transform,
+		                             compare, scratch);
+		if (runs.empty() and not more) {
+			return std::move(chunk.begin(), chunk.end(), d_begin);
+		}
+		runs.push_back(detail_sort::make_run_file(options));
+		detail_sort::run_writer<T> w(runs.back(), buffer_size);
+		for (const auto& x : chunk) {
+			w.push(x);
+		}
+		w.finish();
+		chunk.clear();
+	}
+	chunk = {};
+	scratch = {};
+
+	// Reduce the number of runs until they can all be merged at once
+	while (runs.size() > fan_in) {
+		std::vector<detail_sort::run_file> merged;
+		for (std::size_t first = 0; first < runs.size(); first += fan_in) {
+			const auto last = std::min(first + fan_in, runs.size());
+			std::vector<detail_sort::run_file> group(
+			    std::make_move_iterator(runs.begin() + to_signed(first)),
+			    std::make_move_iterator(runs.begin() + to_signed(last)));
+			merged.push_back(detail_sort::make_run_file(options));
+			detail_sort::run_writer<T> w(merged.back(), buffer_size);
+			detail_sort::merge_runs<T>(std::move(group), transform, compare,
+			                           buffer_size,
+			                           [&](const T& x) { w.push(x); });
+			w.finish();
+		}
+		runs = std::move(merged);
+	}
+	detail_sort::merge_runs<T>(std::move(runs), transform, compare, buffer_size,
+	                           [&](T&& x) { *d_begin++ = std::move(x); });
+	return d_begin;
+}
+
+/**
+ * @brief Sorts the records of an input range using temporary files, and
+ * writes them in order to an output iterator.
+ *
+ * @param begin,end The records to sort
+ * @param d_begin Where to write the sorted records
+ * @param compare The comparison predicate
+ * @param options The memory budget and location of the temporary files
+ * @return The end of the output range
+ * @see external_sort_transform
+ */
+template <typename InputIt, typename OutputIt,
+          typename BinaryPredicate = std::less<>>
+auto external_sort(InputIt begin, InputIt end, OutputIt d_begin,
+                   BinaryPredicate compare = {},
+                   const external_sort_options& options = {}) -> OutputIt {
+	return kblib::external_sort_transform(begin, end, d_begin, identity{},
+	                                      std::move(compare), options);
+}
+
+} // namespace KBLIB_NS
+
+#endif // KBLIB_USE_CXX17
+
+#endif // KBLIB_EXTERNAL_SORT_H
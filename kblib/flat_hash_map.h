@@ -0,0 +1,1508 @@
+/* *****************************************************************************
+ * kblib is a general utility library for C++14 and C++17, intended to provide
+ * performant high-level abstractions and more expressive ways to do simple
+ * things.
+ *
+ * Copyright (c) 2021 killerbee
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/**
+ * @file
+ * @brief Provides flat_hash_map, flat_hash_set and flat_hash_multimap,
+ * open-addressing hash containers that store their elements in a single array.
+ *
+ * @author killerbee
+ * @date 2019-2021
+ * @copyright GNU General Public Licence v3.0
+ */
+
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include "hash.h"
+#include "tdecl.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @def KBLIB_FLAT_HASH_SSE2
+ * @brief Whether flat hash tables scan control bytes with SSE2, 16 at a time,
+ * or with plain 64-bit arithmetic, 8 at a time. Defaults to SSE2 where it is
+ * available.
+ */
+#ifndef KBLIB_FLAT_HASH_SSE2
+#	if defined(__SSE2__) or defined(_M_X64) \
+	    or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+#		define KBLIB_FLAT_HASH_SSE2 1
+#	else
+#		define KBLIB_FLAT_HASH_SSE2 0
+#	endif
+#endif
+#if KBLIB_FLAT_HASH_SSE2
+#	include <emmintrin.h>
+#endif
+
+namespace KBLIB_NS {
+
+/**
+ * @namespace detail_flat_hash
+ * @internal
+ */
+namespace detail_flat_hash {
+
+	/**
+	 * @brief Each slot of a table has one control byte. A full slot stores the
+	 * low 7 bits of the hash of its key, so that almost all non-matching
+	 * slots are rejected without touching the slot itself. The special values
+	 * all have the high bit set.
+	 */
+	using ctrl_t = signed char;
+	KBLIB_CONSTANT ctrl_t ctrl_empty = -128;
+	KBLIB_CONSTANT ctrl_t ctrl_deleted = -2;
+	KBLIB_CONSTANT ctrl_t ctrl_sentinel = -1;
+
+	KBLIB_NODISCARD constexpr auto is_full(ctrl_t c) noexcept -> bool {
+		return c >= 0;
+	}
+	KBLIB_NODISCARD constexpr auto is_empty_or_deleted(ctrl_t c) noexcept
+	    -> bool {
+		return c < ctrl_sentinel;
+	}
+
+	KBLIB_NODISCARD inline auto countr_zero(std::uint64_t x) noexcept
+	    -> unsigned {
+#if defined(__GNUC__) or defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctzll(x));
+#else
+		unsigned n = 0;
+		for (; not (x & 1u); x >>= 1u) {
+			++n;
+		}
+		return n;
+#endif
+	}
+	KBLIB_NODISCARD inline auto countl_zero(std::uint64_t x) noexcept
+	    -> unsigned {
+#if defined(__GNUC__) or defined(__clang__)
+		return static_cast<unsigned>(__builtin_clzll(x));
+#else
+		unsigned n = 0;
+		for (; not (x >> 63u); x <<= 1u) {
+			++n;
+		}
+		return n;
+#endif
+	}
+
+	/**
+	 * @brief A set of slot positions within a group, one per Shift-sized
+	 * chunk of mask, iterated from the lowest position up.
+	 */
+	template <typename UInt, unsigned Width, unsigned Shift>
+	struct bitmask {
+		UInt mask;
+
+		explicit operator bool() const noexcept { return mask != 0; }
+
+		KBLIB_NODISCARD auto lowest() const noexcept -> unsigned {
+			return countr_zero(mask) >> Shift;
+		}
+		auto clear_lowest() noexcept -> void { mask &= mask - 1; }
+
+		KBLIB_NODISCARD auto trailing_zeros() const noexcept -> unsigned {
+			return mask ? lowest() : Width;
+		}
+		KBLIB_NODISCARD auto leading_zeros() const noexcept -> unsigned {
+			constexpr unsigned unused = 64 - (Width << Shift);
+			return mask ? (countl_zero(mask) - unused) >> Shift : Width;
+		}
+	};
+
+#if KBLIB_FLAT_HASH_SSE2
+	/**
+	 * @brief Compares 16 control bytes at once with SSE2.
+	 */
+	struct group {
+		KBLIB_CONSTANT_M std::size_t width = 16;
+		using mask_type = bitmask<std::uint64_t, width, 0>;
+
+		__m128i ctrl;
+
+		explicit group(const ctrl_t* pos) noexcept
+		    : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+		KBLIB_NODISCARD auto match(std::uint8_t h2) const noexcept -> mask_type {
+			return {to_mask(
+			    _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), ctrl))};
+		}
+		KBLIB_NODISCARD auto mask_empty() const noexcept -> mask_type {
+			return {to_mask(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), ctrl))};
+		}
+		KBLIB_NODISCARD auto mask_empty_or_deleted() const noexcept
+		    -> mask_type {
+			return {to_mask(_mm_cmpgt_epi8(_mm_set1_epi8(ctrl_sentinel), ctrl))};
+		}
+		KBLIB_NODISCARD auto count_leading_empty_or_deleted() const noexcept
+		    -> unsigned {
+			return countr_zero(mask_empty_or_deleted().mask + 1);
+		}
+
+	 private:
+		static auto to_mask(__m128i m) noexcept -> std::uint64_t {
+			return static_cast<std::uint16_t>(_mm_movemask_epi8(m));
+		}
+	};
+#else
+	/**
+	 * @brief Compares 8 control bytes at once in a 64-bit integer. match()
+	 * may report false positives, which are rejected by the key comparison.
+	 */
+	struct group {
+		KBLIB_CONSTANT_M std::size_t width = 8;
+		using mask_type = bitmask<std::uint64_t, width, 3>;
+
+		std::uint64_t ctrl{};
+
+		explicit group(const ctrl_t* pos) noexcept {
+			for (std::size_t i = 0; i != width; ++i) {
+				ctrl |= static_cast<std::uint64_t>(static_cast<unsigned char>(pos[i]))
+				        << (8u * i);
+			}
+		}
+
+		KBLIB_NODISCARD auto match(std::uint8_t h2) const noexcept -> mask_type {
+			const auto x = ctrl ^ (lsbs * h2);
+			return {(x - lsbs) & ~x & msbs};
+		}
+		KBLIB_NODISCARD auto mask_empty() const noexcept -> mask_type {
+			return {(ctrl & (~ctrl << 6u)) & msbs};
+		}
+		KBLIB_NODISCARD auto mask_empty_or_deleted() const noexcept
+		    -> mask_type {
+			return {(ctrl & (~ctrl << 7u)) & msbs};
+		}
+		KBLIB_NODISCARD auto count_leading_empty_or_deleted() const noexcept
+		    -> unsigned {
+			return mask_type{~mask_empty_or_deleted().mask & msbs}
+			    .trailing_zeros();
+		}
+
+	 private:
+		KBLIB_CONSTANT_M std::uint64_t lsbs = 0x0101010101010101u;
+		KBLIB_CONSTANT_M std::uint64_t msbs = 0x8080808080808080u;
+	};
+#endif
+
+	/**
+	 * @brief The control bytes of a table with no slots. Lookups stop at the
+	 * empty bytes, and iteration stops at the sentinel.
+	 */
+	inline auto empty_group() noexcept -> ctrl_t* {
+		alignas(16) static const ctrl_t bytes[16]
+		    = {ctrl_sentinel, ctrl_empty, ctrl_empty, ctrl_empty,
+		       ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty,
+		       ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty,
+		       ctrl_empty,    ctrl_empty, ctrl_empty, ctrl_empty};
+		// Never written to: an empty table has no room, so it reallocates
+		// before any insertion
+		return const_cast<ctrl_t*>(bytes);
+	}
+
+	/**
+	 * @brief Capacities are always one less than a power of 2, and at least
+	 * one less than the group width, so that a group load starting at any
+	 * slot stays inside the control bytes.
+	 */
+	KBLIB_NODISCARD constexpr auto normalize_capacity(std::size_t n) noexcept
+	    -> std::size_t {
+		std::size_t cap = group::width - 1;
+		while (cap < n) {
+			cap = cap * 2 + 1;
+		}
+		return cap;
+	}
+
+	/**
+	 * @brief The number of elements that fit in a table of capacity cap: 7/8
+	 * of it, leaving at least one empty slot to end unsuccessful lookups.
+	 */
+	KBLIB_NODISCARD constexpr auto capacity_to_growth(std::size_t cap) noexcept
+	    -> std::size_t {
+		return cap - (cap + 1) / 8;
+	}
+
+	KBLIB_NODISCARD constexpr auto growth_to_capacity(std::size_t n) noexcept
+	    -> std::size_t {
+		return normalize_capacity(n + (n + 6) / 7);
+	}
+
+	/**
+	 * @brief Visits the groups of a table in triangular order, which reaches
+	 * every group when the number of slots is a power of 2.
+	 */
+	class probe_seq {
+	 public:
+		probe_seq(std::size_t hash, std::size_t cap) noexcept
+		    : mask(cap)
+		    , pos(hash & cap) {}
+
+		KBLIB_NODISCARD auto offset() const noexcept -> std::size_t {
+			return pos;
+		}
+		KBLIB_NODISCARD auto offset(std::size_t i) const noexcept
+		    -> std::size_t {
+			return (pos + i) & mask;
+		}
+		auto next() noexcept -> void {
+			index += group::width;
+			pos = (pos + index) & mask;
+		}
+
+	 private:
+		std::size_t mask;
+		std::size_t pos;
+		std::size_t index{};
+	};
+
+	template <typename T, typename = void>
+	struct is_transparent : std::false_type {};
+	// std uses a member type, kblib's hashers a member constant
+	template <typename T>
+	struct is_transparent<T, fakestd::void_t<typename T::is_transparent>>
+	    : std::true_type {};
+	template <typename T>
+	struct is_transparent<T, void_if_t<T::is_transparent>> : std::true_type {};
+
+	/**
+	 * @brief How raw_table stores the elements of a map.
+	 *
+	 * Elements are exposed as std::pair<const Key, T>, whose key can not be
+	 * moved from. Where std::pair<Key, T> has the same layout, each slot is a
+	 * union of the two and elements are created as the mutable pair, so that
+	 * rehashing can move keys; the const pair is read through the common
+	 * initial sequence of the two. Otherwise, keys are copied when elements
+	 * are relocated.
+	 */
+	template <typename Key, typename T>
+	struct map_policy {
+		using key_type = Key;
+		using value_type = std::pair<const Key, T>;
+		using mutable_value_type = std::pair<Key, T>;
+
+		union slot_type {
+			slot_type() noexcept {}
+			~slot_type() {}
+
+			value_type value;
+			mutable_value_type mutable_value;
+		};
+
+		KBLIB_CONSTANT_MV mutable_keys
+		    = std::is_standard_layout<value_type>::value
+		      and std::is_standard_layout<mutable_value_type>::value
+		      and sizeof(value_type) == sizeof(mutable_value_type)
+		      and alignof(value_type) == alignof(mutable_value_type);
+
+		KBLIB_NODISCARD static auto key(const value_type& v) noexcept
+		    -> const Key& {
+			return v.first;
+		}
+		KBLIB_NODISCARD static auto element(slot_type* s) noexcept
+		    -> value_type& {
+			return s->value;
+		}
+
+		template <typename... Args>
+		static auto construct(slot_type* s, Args&&... args) -> void {
+			construct(bool_constant<mutable_keys>{}, s,
+			          std::forward<Args>(args)...);
+		}
+		static auto destroy(slot_type* s) noexcept -> void {
+			destroy(bool_constant<mutable_keys>{}, s);
+		}
+
+		/**
+		 * @brief Moves an element to an unused slot, leaving from unused.
+		 */
+		static auto relocate(slot_type* to, slot_type* from) noexcept -> void {
+			relocate(bool_constant<mutable_keys>{}, to, from);
+		}
+		KBLIB_CONSTANT_MV nothrow_relocate
+		    = (mutable_keys ? std::is_nothrow_move_constructible<Key>::value
+		                    : std::is_nothrow_copy_constructible<Key>::value)
+		      and std::is_nothrow_move_constructible<T>::value;
+
+	 private:
+		template <typename... Args>
+		static auto construct(std::true_type, slot_type* s, Args&&... args)
+		    -> void {
+			::new (static_cast<void*>(&s->mutable_value))
+			    mutable_value_type(std::forward<Args>(args)...);
+		}
+		template <typename... Args>
+		static auto construct(std::false_type, slot_type* s, Args&&... args)
+		    -> void {
+			::new (static_cast<void*>(&s->value))
+			    value_type(std::forward<Args>(args)...);
+		}
+
+		static auto destroy(std::true_type, slot_type* s) noexcept -> void {
+			s->mutable_value.~mutable_value_type();
+		}
+		static auto destroy(std::false_type, slot_type* s) noexcept -> void {
+			s->value.~value_type();
+		}
+
+		static auto relocate(std::true_type, slot_type* to,
+		                     slot_type* from) noexcept -> void {
+			construct(std::true_type{}, to, std::move(from->mutable_value));
+			destroy(std::true_type{}, from);
+		}
+		static auto relocate(std::false_type, slot_type* to,
+		                     slot_type* from) noexcept -> void {
+			// Copies the key
+			construct(std::false_type{}, to, std::move(from->value));
+			destroy(std::false_type{}, from);
+		}
+	};
+
+	template <typename Key>
+	struct set_policy {
+		using key_type = Key;
+		using value_type = Key;
+
+		using slot_type = value_type;
+
+		KBLIB_NODISCARD static auto key(const value_type& v) noexcept
+		    -> const Key& {
+			return v;
+		}
+		KBLIB_NODISCARD static auto element(slot_type* s) noexcept
+		    -> value_type& {
+			return *s;
+		}
+
+		template <typename... Args>
+		static auto construct(slot_type* s, Args&&... args) -> void {
+			::new (static_cast<void*>(s)) value_type(std::forward<Args>(args)...);
+		}
+		static auto destroy(slot_type* s) noexcept -> void { s->~value_type(); }
+
+		static auto relocate(slot_type* to, slot_type* from) noexcept -> void {
+			construct(to, std::move(*from));
+			destroy(from);
+		}
+		KBLIB_CONSTANT_MV nothrow_relocate
+		    = std::is_nothrow_move_constructible<Key>::value;
+	};
+
+	/**
+	 * @brief The open-addressing table shared by flat_hash_map and
+	 * flat_hash_set.
+	 *
+	 * Elements live directly in an array of slots, with a parallel array of
+	 * control bytes. Lookup hashes the key once, then scans the control bytes
+	 * a whole group at a time for the 7 bit tag of the hash, so it usually
+	 * compares only the key it is looking for. Erasure leaves a tombstone only
+	 * when the slot's group has been full since the last rehash; otherwise
+	 * the slot becomes empty again, and tombstones are reclaimed in place
+	 * instead of growing the table when they fill it.
+	 */
+	template <typename Policy, typename Hash, typename KeyEqual>
+	class raw_table {
+	 public:
+		using key_type = typename Policy::key_type;
+		using value_type = typename Policy::value_type;
+		using slot_type = typename Policy::slot_type;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using pointer = value_type*;
+		using const_pointer = const value_type*;
+
+	 private:
+		template <typename V>
+		class iter {
+		 public:
+			using value_type = typename raw_table::value_type;
+			using difference_type = std::ptrdiff_t;
+			using reference = V&;
+			using pointer = V*;
+			using iterator_category = std::forward_iterator_tag;
+
+			iter() = default;
+			// iterator converts to const_iterator
+			template <typename W,
+			          enable_if_t<std::is_same<const W, V>::value
+			                          and not std::is_same<W, V>::value,
+			                      int> = 0>
+			iter(const iter<W>& o) noexcept
+			    : ctrl(o.ctrl)
+			    , slot(o.slot) {}
+
+			KBLIB_NODISCARD auto operator*() const noexcept -> reference {
+				return Policy::element(slot);
+			}
+			KBLIB_NODISCARD auto operator->() const noexcept -> pointer {
+				return &Policy::element(slot);
+			}
+
+			auto operator++() noexcept -> iter& {
+				++ctrl;
+				++slot;
+				skip_empty_or_deleted();
+				return *this;
+			}
+			auto operator++(int) noexcept -> iter {
+				iter it = *this;
+				++*this;
+				return it;
+			}
+
+			KBLIB_NODISCARD friend auto operator==(const iter& l,
+			                                       const iter& r) noexcept
+			    -> bool {
+				return l.slot == r.slot;
+			}
+			KBLIB_NODISCARD friend auto operator!=(const iter& l,
+			                                       const iter& r) noexcept
+			    -> bool {
+				return l.slot != r.slot;
+			}
+
+		 private:
+			friend class raw_table;
+			template <typename>
+			friend class iter;
+
+			iter(ctrl_t* c, slot_type* s) noexcept
+			    : ctrl(c)
+			    , slot(s) {}
+
+			auto skip_empty_or_deleted() noexcept -> void {
+				// The sentinel after the last slot ends the scan
+				while (is_empty_or_deleted(*ctrl)) {
+					const auto shift = group{ctrl}.count_leading_empty_or_deleted();
+					ctrl += shift;
+					slot += shift;
+				}
+			}
+
+			ctrl_t* ctrl{};
+			slot_type* slot{};
+		};
+
+	 protected:
+		/**
+		 * @brief Lookup with a K that is not a Key is only done directly when
+		 * both Hash and KeyEqual are transparent, and K does not implicitly
+		 * convert to Key. The latter keeps string literals from being hashed
+		 * as pointers or arrays by FNV_hash<>.
+		 */
+		template <typename H, typename K>
+		struct heterogeneous
+		    : bool_constant<is_transparent<H>::value
+		                    and is_transparent<KeyEqual>::value
+		                    and not std::is_convertible<const K&, key_type>::value> {
+		};
+
+	 public:
+		using iterator = iter<
+		    std::conditional_t<std::is_same<key_type, value_type>::value,
+		                  const value_type, value_type>>;
+		using const_iterator = iter<const value_type>;
+
+		raw_table() noexcept(std::is_nothrow_default_constructible<Hash>::value
+		                         and std::is_nothrow_default_constructible<
+		                             KeyEqual>::value) = default;
+
+		explicit raw_table(size_type bucket_count, const Hash& h = Hash{},
+		                   const KeyEqual& e = KeyEqual{})
+		    : hash(h)
+		    , eq(e) {
+			if (bucket_count) {
+				resize(normalize_capacity(bucket_count));
+			}
+		}
+
+		raw_table(const raw_table& other)
+		    : hash(other.hash)
+		    , eq(other.eq) {
+			reserve(other.size());
+			for (const auto& v : other) {
+				emplace_new(hash_of(Policy::key(v)), v);
+			}
+		}
+
+		raw_table(raw_table&& other) noexcept
+		    : ctrl(std::exchange(other.ctrl, empty_group()))
+		    , slots(std::exchange(other.slots, nullptr))
+		    , cap(std::exchange(other.cap, 0))
+		    , _size(std::exchange(other._size, 0))
+		    , growth_left(std::exchange(other.growth_left, 0))
+		    , hash(other.hash)
+		    , eq(other.eq) {}
+
+		auto operator=(const raw_table& other) -> raw_table& {
+			if (this != &other) {
+				raw_table tmp(other);
+				swap(tmp);
+			}
+			return *this;
+		}
+		auto operator=(raw_table&& other) noexcept -> raw_table& {
+			if (this != &other) {
+				destroy_and_deallocate();
+				ctrl = std::exchange(other.ctrl, empty_group());
+				slots = std::exchange(other.slots, nullptr);
+				cap = std::exchange(other.cap, 0);
+				_size = std::exchange(other._size, 0);
+				growth_left = std::exchange(other.growth_left, 0);
+				hash = other.hash;
+				eq = other.eq;
+			}
+			return *this;
+		}
+
+		~raw_table() { destroy_and_deallocate(); }
+
+		KBLIB_NODISCARD auto begin() noexcept -> iterator {
+			iterator it{ctrl, slots};
+			it.skip_empty_or_deleted();
+			return it;
+		}
+		KBLIB_NODISCARD auto begin() const noexcept -> const_iterator {
+			return const_cast<raw_table*>(this)->begin();
+		}
+		KBLIB_NODISCARD auto cbegin() const noexcept -> const_iterator {
+			return begin();
+		}
+		KBLIB_NODISCARD auto end() noexcept -> iterator {
+			return {ctrl + cap, slots + cap};
+		}
+		KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+			return const_cast<raw_table*>(this)->end();
+		}
+		KBLIB_NODISCARD auto cend() const noexcept -> const_iterator {
+			return end();
+		}
+
+		KBLIB_NODISCARD auto empty() const noexcept -> bool { return _size == 0; }
+		KBLIB_NODISCARD auto size() const noexcept -> size_type { return _size; }
+		KBLIB_NODISCARD auto max_size() const noexcept -> size_type {
+			return std::numeric_limits<difference_type>::max() / sizeof(value_type);
+		}
+		/**
+		 * @brief The number of slots. size() may grow to 7/8 of this before the
+		 * table reallocates.
+		 */
+		KBLIB_NODISCARD auto capacity() const noexcept -> size_type { return cap; }
+		KBLIB_NODISCARD auto load_factor() const noexcept -> float {
+			return cap ? static_cast<float>(_size) / static_cast<float>(cap) : 0.f;
+		}
+		KBLIB_NODISCARD auto max_load_factor() const noexcept -> float {
+			return 7.f / 8.f;
+		}
+
+		KBLIB_NODISCARD auto hash_function() const -> hasher { return hash; }
+		KBLIB_NODISCARD auto key_eq() const -> key_equal { return eq; }
+
+		auto clear() noexcept -> void {
+			if (cap) {
+				destroy_elements();
+				reset_ctrl();
+				_size = 0;
+				growth_left = capacity_to_growth(cap);
+			}
+		}
+
+		/**
+		 * @brief Makes room for n elements in total, without further
+		 * reallocation.
+		 */
+		auto reserve(size_type n) -> void {
+			if (n > _size + growth_left) {
+				resize(growth_to_capacity(n));
+			}
+		}
+		/**
+		 * @brief Reallocates to at least n slots, and enough for size()
+		 * elements, which may shrink the table. Also clears out tombstones.
+		 */
+		auto rehash(size_type n) -> void {
+			if (n == 0 and _size == 0) {
+				deallocate(ctrl, slots, cap);
+				ctrl = empty_group();
+				slots = nullptr;
+				cap = growth_left = 0;
+			} else {
+				resize((std::max)(normalize_capacity(n), growth_to_capacity(_size)));
+			}
+		}
+
+		auto insert(const value_type& v) -> std::pair<iterator, bool> {
+			return emplace_key(Policy::key(v), v);
+		}
+		auto insert(value_type&& v) -> std::pair<iterator, bool> {
+			return emplace_key(Policy::key(v), std::move(v));
+		}
+		auto insert(const_iterator, const value_type& v) -> iterator {
+			return insert(v).first;
+		}
+		auto insert(const_iterator, value_type&& v) -> iterator {
+			return insert(std::move(v)).first;
+		}
+		template <typename InputIt>
+		auto insert(InputIt first, InputIt last) -> void {
+			for (; first != last; ++first) {
+				emplace(*first);
+			}
+		}
+		auto insert(std::initializer_list<value_type> il) -> void {
+			insert(il.begin(), il.end());
+		}
+
+		/**
+		 * @brief Constructs an element from args and inserts it if its key is
+		 * not already present. The element is constructed before the lookup,
+		 * so prefer try_emplace for maps.
+		 */
+		template <typename... Args>
+		auto emplace(Args&&... args) -> std::pair<iterator, bool> {
+			value_type v(std::forward<Args>(args)...);
+			return emplace_key(Policy::key(v), std::move(v));
+		}
+		template <typename... Args>
+		auto emplace_hint(const_iterator, Args&&... args) -> iterator {
+			return emplace(std::forward<Args>(args)...).first;
+		}
+
+		auto erase(const_iterator pos) noexcept -> iterator {
+			iterator it{pos.ctrl, pos.slot};
+			erase_at(static_cast<size_type>(it.ctrl - ctrl));
+			++it;
+			return it;
+		}
+		auto erase(const_iterator first, const_iterator last) noexcept
+		    -> iterator {
+			while (first != last) {
+				first = erase(first);
+			}
+			return {const_cast<ctrl_t*>(last.ctrl), last.slot};
+		}
+		auto erase(const key_type& key) -> size_type {
+			return erase_key(key);
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value
+		                          and not std::is_convertible<K, const_iterator>::value,
+		                      int> = 0>
+		auto erase(const K& key) -> size_type {
+			return erase_key(key);
+		}
+
+		auto swap(raw_table& other) noexcept -> void {
+			using std::swap;
+			swap(ctrl, other.ctrl);
+			swap(slots, other.slots);
+			swap(cap, other.cap);
+			swap(_size, other._size);
+			swap(growth_left, other.growth_left);
+			swap(hash, other.hash);
+			swap(eq, other.eq);
+		}
+		friend auto swap(raw_table& a, raw_table& b) noexcept -> void {
+			a.swap(b);
+		}
+
+		KBLIB_NODISCARD auto find(const key_type& key) -> iterator {
+			return find_key(key);
+		}
+		KBLIB_NODISCARD auto find(const key_type& key) const -> const_iterator {
+			return const_cast<raw_table*>(this)->find_key(key);
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value, int> = 0>
+		KBLIB_NODISCARD auto find(const K& key) -> iterator {
+			return find_key(key);
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value, int> = 0>
+		KBLIB_NODISCARD auto find(const K& key) const -> const_iterator {
+			return const_cast<raw_table*>(this)->find_key(key);
+		}
+
+		KBLIB_NODISCARD auto contains(const key_type& key) const -> bool {
+			return find(key) != end();
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value, int> = 0>
+		KBLIB_NODISCARD auto contains(const K& key) const -> bool {
+			return find(key) != end();
+		}
+
+		KBLIB_NODISCARD auto count(const key_type& key) const -> size_type {
+			return contains(key);
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value, int> = 0>
+		KBLIB_NODISCARD auto count(const K& key) const -> size_type {
+			return contains(key);
+		}
+
+		KBLIB_NODISCARD auto equal_range(const key_type& key)
+		    -> std::pair<iterator, iterator> {
+			return range_of(find(key));
+		}
+		KBLIB_NODISCARD auto equal_range(const key_type& key) const
+		    -> std::pair<const_iterator, const_iterator> {
+			return const_cast<raw_table*>(this)->equal_range(key);
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value, int> = 0>
+		KBLIB_NODISCARD auto equal_range(const K& key)
+		    -> std::pair<iterator, iterator> {
+			return range_of(find(key));
+		}
+		template <typename K, typename H = Hash,
+		          enable_if_t<heterogeneous<H, K>::value, int> = 0>
+		KBLIB_NODISCARD auto equal_range(const K& key) const
+		    -> std::pair<const_iterator, const_iterator> {
+			return const_cast<raw_table*>(this)->equal_range(key);
+		}
+
+	 protected:
+		/**
+		 * @brief The hash used to place key. The user's hash is mixed again by
+		 * a full-width multiply, because the control bytes use its low 7 bits
+		 * and FNV leaves them poorly mixed.
+		 */
+		template <typename K>
+		KBLIB_NODISCARD auto hash_of(const K& key) const -> std::size_t {
+			return static_cast<std::size_t>(detail_hash::mum(
+			    static_cast<std::uint64_t>(hash(key)), mix::secret0));
+		}
+		KBLIB_NODISCARD static auto h1(std::size_t h) noexcept -> std::size_t {
+			return h >> 7u;
+		}
+		KBLIB_NODISCARD static auto h2(std::size_t h) noexcept -> std::uint8_t {
+			return static_cast<std::uint8_t>(h & 0x7fu);
+		}
+
+		template <typename K>
+		KBLIB_NODISCARD auto find_key(const K& key) -> iterator {
+			const auto h = hash_of(key);
+			probe_seq seq(h1(h), cap);
+			while (true) {
+				const group g{ctrl + seq.offset()};
+				for (auto m = g.match(h2(h)); m; m.clear_lowest()) {
+					const auto i = seq.offset(m.lowest());
+					if (eq(Policy::key(Policy::element(slots + i)), key)) {
+						return {ctrl + i, slots + i};
+					}
+				}
+				if (g.mask_empty()) {
+					return end();
+				}
+				seq.next();
+			}
+		}
+
+		/**
+		 * @brief Returns the position of key, or of an empty or deleted slot
+		 * it can be inserted into (second = true). The table must have room.
+		 */
+		template <typename K>
+		KBLIB_NODISCARD auto find_or_prepare_insert(const K& key, std::size_t h)
+		    -> std::pair<size_type, bool> {
+			probe_seq seq(h1(h), cap);
+			while (true) {
+				const group g{ctrl + seq.offset()};
+				for (auto m = g.match(h2(h)); m; m.clear_lowest()) {
+					const auto i = seq.offset(m.lowest());
+					if (eq(Policy::key(Policy::element(slots + i)), key)) {
+						return {i, false};
+					}
+				}
+				if (g.mask_empty()) {
+					break;
+				}
+				seq.next();
+			}
+			return {prepare_insert(h), true};
+		}
+
+		/**
+		 * @brief Inserts value_type(args...) under key if key is not present.
+		 */
+		template <typename K, typename... Args>
+		auto emplace_key(const K& key, Args&&... args)
+		    -> std::pair<iterator, bool> {
+			const auto h = hash_of(key);
+			const auto r = find_or_prepare_insert(key, h);
+			if (not r.second) {
+				return {iterator{ctrl + r.first, slots + r.first}, false};
+			}
+			return {construct_at(r.first, h, std::forward<Args>(args)...), true};
+		}
+
+		/**
+		 * @brief Inserts an element known not to be present.
+		 */
+		template <typename... Args>
+		auto emplace_new(std::size_t h, Args&&... args) -> iterator {
+			return construct_at(prepare_insert(h), h, std::forward<Args>(args)...);
+		}
+
+		template <typename K>
+		auto erase_key(const K& key) -> size_type {
+			auto it = find_key(key);
+			if (it == end()) {
+				return 0;
+			}
+			erase_at(static_cast<size_type>(it.ctrl - ctrl));
+			return 1;
+		}
+
+	 private:
+		/**
+		 * @brief Finds a free slot for hash h, rehashing first if the table is
+		 * out of room. Does not yet mark the slot as used.
+		 */
+		auto prepare_insert(std::size_t h) -> size_type {
+			auto target = find_first_non_full(h);
+			if (growth_left == 0 and ctrl[target] != ctrl_deleted) {
+				rehash_and_grow_if_necessary();
+				target = find_first_non_full(h);
+			}
+			return target;
+		}
+
+		template <typename... Args>
+		auto construct_at(size_type i, std::size_t h, Args&&... args)
+		    -> iterator {
+			// Construct before touching the metadata, for exception safety
+			Policy::construct(slots + i, std::forward<Args>(args)...);
+			growth_left -= (ctrl[i] == ctrl_empty);
+			set_ctrl(i, static_cast<ctrl_t>(h2(h)));
+			++_size;
+			return {ctrl + i, slots + i};
+		}
+
+		KBLIB_NODISCARD auto find_first_non_full(std::size_t h) const noexcept
+		    -> size_type {
+			probe_seq seq(h1(h), cap);
+			while (true) {
+				const auto m = group{ctrl + seq.offset()}.mask_empty_or_deleted();
+				if (m) {
+					return seq.offset(m.lowest());
+				}
+				seq.next();
+			}
+		}
+
+		/**
+		 * @brief Sets a control byte, and its copy after the sentinel if it is
+		 * one of the first group::width - 1.
+		 */
+		auto set_ctrl(size_type i, ctrl_t c) noexcept -> void {
+			ctrl[i] = c;
+			ctrl[((i - (group::width - 1)) & cap) + (group::width - 1)] = c;
+		}
+
+		auto erase_at(size_type i) noexcept -> void {
+			Policy::destroy(slots + i);
+			--_size;
+			// If there has never been a full group around i, no probe sequence
+			// has passed over i, so it can be marked empty instead of deleted.
+			const auto before = (i - group::width) & cap;
+			const auto empty_after = group{ctrl + i}.mask_empty();
+			const auto empty_before = group{ctrl + before}.mask_empty();
+			const bool was_never_full
+			    = empty_before and empty_after
+			      and empty_after.trailing_zeros() + empty_before.leading_zeros()
+			              < group::width;
+			set_ctrl(i, was_never_full ? ctrl_empty : ctrl_deleted);
+			growth_left += was_never_full;
+		}
+
+		auto rehash_and_grow_if_necessary() -> void {
+			if (cap > group::width and _size * 32 <= cap * 25) {
+				// Mostly tombstones: reclaim them without growing
+				resize(cap);
+			} else {
+				resize(normalize_capacity(cap * 2 + 1));
+			}
+		}
+
+		auto allocate_ctrl(size_type new_cap) -> ctrl_t* {
+			return static_cast<ctrl_t*>(
+			    ::operator new(new_cap + group::width));
+		}
+		auto allocate_slots(size_type new_cap) -> slot_type* {
+			return static_cast<slot_type*>(
+			    ::operator new(new_cap * sizeof(slot_type)));
+		}
+
+		auto reset_ctrl() noexcept -> void {
+			std::memset(ctrl, static_cast<unsigned char>(ctrl_empty),
+			            cap + group::width);
+			ctrl[cap] = ctrl_sentinel;
+		}
+
+		auto resize(size_type new_cap) -> void {
+			auto new_ctrl = allocate_ctrl(new_cap);
+			slot_type* new_slots;
+			try {
+				new_slots = allocate_slots(new_cap);
+			} catch (...) {
+				::operator delete(new_ctrl);
+				throw;
+			}
+			const auto old_ctrl = ctrl;
+			const auto old_slots = slots;
+			const auto old_cap = cap;
+			ctrl = new_ctrl;
+			slots = new_slots;
+			cap = new_cap;
+			reset_ctrl();
+			growth_left = capacity_to_growth(cap) - _size;
+			transfer(old_ctrl, old_slots, old_cap,
+			         bool_constant<Policy::nothrow_relocate>{});
+		}
+
+		auto transfer(ctrl_t* old_ctrl, slot_type* old_slots, size_type old_cap,
+		              std::true_type) noexcept -> void {
+			for (size_type i = 0; i != old_cap; ++i) {
+				if (is_full(old_ctrl[i])) {
+					const auto h
+					    = hash_of(Policy::key(Policy::element(old_slots + i)));
+					const auto target = find_first_non_full(h);
+					set_ctrl(target, static_cast<ctrl_t>(h2(h)));
+					Policy::relocate(slots + target, old_slots + i);
+				}
+			}
+			deallocate(old_ctrl, old_slots, old_cap);
+		}
+
+		// Copies instead of moving, so that the old table is intact if a copy
+		// throws
+		auto transfer(ctrl_t* old_ctrl, slot_type* old_slots, size_type old_cap,
+		              std::false_type) -> void {
+			try {
+				for (size_type i = 0; i != old_cap; ++i) {
+					if (is_full(old_ctrl[i])) {
+						const auto& v = Policy::element(old_slots + i);
+						const auto h = hash_of(Policy::key(v));
+						const auto target = find_first_non_full(h);
+						Policy::construct(slots + target, v);
+						set_ctrl(target, static_cast<ctrl_t>(h2(h)));
+					}
+				}
+			} catch (...) {
+				destroy_and_deallocate();
+				ctrl = old_ctrl;
+				slots = old_slots;
+				cap = old_cap;
+				growth_left = 0; // forces another attempt at the next insertion
+				throw;
+			}
+			for (size_type i = 0; i != old_cap; ++i) {
+				if (is_full(old_ctrl[i])) {
+					Policy::destroy(old_slots + i);
+				}
+			}
+			deallocate(old_ctrl, old_slots, old_cap);
+		}
+
+		static auto deallocate(ctrl_t* c, slot_type* s, size_type n) noexcept
+		    -> void {
+			if (n) {
+				::operator delete(c);
+				::operator delete(s);
+			}
+		}
+
+		auto destroy_elements() noexcept -> void {
+			if (not std::is_trivially_destructible<value_type>::value) {
+				for (size_type i = 0; i != cap; ++i) {
+					if (is_full(ctrl[i])) {
+						Policy::destroy(slots + i);
+					}
+				}
+			}
+		}
+
+		auto destroy_and_deallocate() noexcept -> void {
+			destroy_elements();
+			deallocate(ctrl, slots, cap);
+		}
+
+		template <typename It>
+		auto range_of(It it) -> std::pair<It, It> {
+			if (it == end()) {
+				return {it, it};
+			}
+			return {it, std::next(it)};
+		}
+
+		ctrl_t* ctrl = empty_group();
+		slot_type* slots = nullptr;
+		size_type cap = 0;
+		size_type _size = 0;
+		size_type growth_left = 0;
+		Hash hash;
+		KeyEqual eq;
+	};
+
+} // namespace detail_flat_hash
+
+/**
+ * @brief An open-addressing hash map with the interface of
+ * std::unordered_map, minus the bucket interface.
+ *
+ * Elements are stored directly in one array, so inserting does not allocate
+ * unless the table grows, and a successful lookup usually touches one group
+ * of control bytes and one element. In exchange, inserting and rehashing
+ * invalidate all iterators, pointers and references, and erasing invalidates
+ * those to the erased element.
+ *
+ * Like hash_map, lookup is transparent when both Hash and KeyEqual are,
+ * which is the case for the defaults: find, contains, count, equal_range,
+ * erase and at accept any key type that hashes and compares equal the same
+ * way as Key.
+ */
+template <typename Key, typename T, typename Hash = FNV_hash<>,
+          typename KeyEqual = std::equal_to<>>
+class flat_hash_map
+    : public detail_flat_hash::raw_table<detail_flat_hash::map_policy<Key, T>,
+                                         Hash, KeyEqual> {
+	using base
+	    = detail_flat_hash::raw_table<detail_flat_hash::map_policy<Key, T>, Hash,
+	                                  KeyEqual>;
+
+ public:
+	using mapped_type = T;
+	using typename base::const_iterator;
+	using typename base::iterator;
+	using typename base::key_type;
+	using typename base::size_type;
+	using typename base::value_type;
+
+	using base::base;
+	flat_hash_map() = default;
+
+	template <typename InputIt>
+	flat_hash_map(InputIt first, InputIt last, size_type bucket_count = 0,
+	              const Hash& h = Hash{}, const KeyEqual& e = KeyEqual{})
+	    : base(bucket_count, h, e) {
+		this->insert(first, last);
+	}
+	flat_hash_map(std::initializer_list<value_type> il,
+	              size_type bucket_count = 0, const Hash& h = Hash{},
+	              const KeyEqual& e = KeyEqual{})
+	    : flat_hash_map(il.begin(), il.end(), bucket_count, h, e) {}
+
+	auto operator=(std::initializer_list<value_type> il) -> flat_hash_map& {
+		this->clear();
+		this->insert(il);
+		return *this;
+	}
+
+	using base::insert;
+	template <typename P>
+	auto insert(P&& value)
+	    -> enable_if_t<std::is_constructible<value_type, P&&>::value,
+	                   std::pair<iterator, bool>> {
+		return this->emplace(std::forward<P>(value));
+	}
+
+	template <typename... Args>
+	auto try_emplace(const key_type& key, Args&&... args)
+	    -> std::pair<iterator, bool> {
+		return this->emplace_key(key, std::piecewise_construct,
+		                         std::forward_as_tuple(key),
+		                         std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+	template <typename... Args>
+	auto try_emplace(key_type&& key, Args&&... args)
+	    -> std::pair<iterator, bool> {
+		return this->emplace_key(key, std::piecewise_construct,
+		                         std::forward_as_tuple(std::move(key)),
+		                         std::forward_as_tuple(std::forward<Args>(args)...));
+	}
+
+	template <typename M>
+	auto insert_or_assign(const key_type& key, M&& obj)
+	    -> std::pair<iterator, bool> {
+		auto r = try_emplace(key, std::forward<M>(obj));
+		if (not r.second) {
+			r.first->second = std::forward<M>(obj);
+		}
+		return r;
+	}
+	template <typename M>
+	auto insert_or_assign(key_type&& key, M&& obj)
+	    -> std::pair<iterator, bool> {
+		auto r = try_emplace(std::move(key), std::forward<M>(obj));
+		if (not r.second) {
+			r.first->second = std::forward<M>(obj);
+		}
+		return r;
+	}
+
+	auto operator[](const key_type& key) -> T& {
+		return try_emplace(key).first->second;
+	}
+	auto operator[](key_type&& key) -> T& {
+		return try_emplace(std::move(key)).first->second;
+	}
+
+	KBLIB_NODISCARD auto at(const key_type& key) -> T& {
+		return at_impl(*this, key);
+	}
+	KBLIB_NODISCARD auto at(const key_type& key) const -> const T& {
+		return at_impl(*this, key);
+	}
+	template <typename K, typename H = Hash,
+	          enable_if_t<base::template heterogeneous<H, K>::value, int> = 0>
+	KBLIB_NODISCARD auto at(const K& key) -> T& {
+		return at_impl(*this, key);
+	}
+	template <typename K, typename H = Hash,
+	          enable_if_t<base::template heterogeneous<H, K>::value, int> = 0>
+	KBLIB_NODISCARD auto at(const K& key) const -> const T& {
+		return at_impl(*this, key);
+	}
+
+	KBLIB_NODISCARD friend auto operator==(const flat_hash_map& l,
+	                                       const flat_hash_map& r) -> bool {
+		if (l.size() != r.size()) {
+			return false;
+		}
+		for (const auto& v : l) {
+			auto it = r.find(v.first);
+			if (it == r.end() or not (it->second == v.second)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	KBLIB_NODISCARD friend auto operator!=(const flat_hash_map& l,
+	                                       const flat_hash_map& r) -> bool {
+		return not (l == r);
+	}
+
+ private:
+	template <typename Self, typename K>
+	static auto at_impl(Self& self, const K& key) -> decltype(auto) {
+		auto it = self.find(key);
+		if (it == self.end()) {
+			throw std::out_of_range("flat_hash_map: key not found");
+		}
+		return (it->second);
+	}
+};
+
+/**
+ * @brief An open-addressing hash set with the interface of
+ * std::unordered_set, minus the bucket interface. See flat_hash_map for the
+ * storage and invalidation rules.
+ */
+template <typename Key, typename Hash = FNV_hash<>,
+          typename KeyEqual = std::equal_to<>>
+class flat_hash_set
+    : public detail_flat_hash::raw_table<detail_flat_hash::set_policy<Key>,
+                                         Hash, KeyEqual> {
+	using base = detail_flat_hash::raw_table<detail_flat_hash::set_policy<Key>,
+	                                         Hash, KeyEqual>;
+
+ public:
+	using typename base::size_type;
+	using typename base::value_type;
+
+	using base::base;
+	flat_hash_set() = default;
+
+	template <typename InputIt>
+	flat_hash_set(InputIt first, InputIt last, size_type bucket_count = 0,
+	              const Hash& h = Hash{}, const KeyEqual& e = KeyEqual{})
+	    : base(bucket_count, h, e) {
+		this->insert(first, last);
+	}
+	flat_hash_set(std::initializer_list<value_type> il,
+	              size_type bucket_count = 0, const Hash& h = Hash{},
+	              const KeyEqual& e = KeyEqual{})
+	    : flat_hash_set(il.begin(), il.end(), bucket_count, h, e) {}
+
+	auto operator=(std::initializer_list<value_type> il) -> flat_hash_set& {
+		this->clear();
+		this->insert(il);
+		return *this;
+	}
+
+	KBLIB_NODISCARD friend auto operator==(const flat_hash_set& l,
+	                                       const flat_hash_set& r) -> bool {
+		if (l.size() != r.size()) {
+			return false;
+		}
+		for (const auto& v : l) {
+			if (not r.contains(v)) {
+				return false;
+			}
+		}
+		return true;
+	}
+	KBLIB_NODISCARD friend auto operator!=(const flat_hash_set& l,
+	                                       const flat_hash_set& r) -> bool {
+		return not (l == r);
+	}
+};
+
+/**
+ * @brief A hash multimap that stores all of the values for one key together
+ * in one contiguous array, in insertion order.
+ *
+ * equal_range returns a range over the values of a single array, so visiting
+ * every value of a key is a single hash lookup followed by a linear scan,
+ * instead of a walk along a bucket's nodes. The keys are held in a
+ * flat_hash_map, which gives the lookup and invalidation rules. Appending a
+ * value to a key invalidates only that key's value iterators, unless the key
+ * is new.
+ *
+ * Unlike std::unordered_multimap, iteration is over groups, whose value_type
+ * is std::pair<const Key, std::vector<T>>, and equal_range, insert and
+ * emplace deal in iterators to T rather than to key-value pairs.
+ */
+template <typename Key, typename T, typename Hash = FNV_hash<>,
+          typename KeyEqual = std::equal_to<>>
+class flat_hash_multimap {
+	using map_type = flat_hash_map<Key, std::vector<T>, Hash, KeyEqual>;
+
+ public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using group_type = typename map_type::value_type;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using hasher = Hash;
+	using key_equal = KeyEqual;
+
+	using iterator = typename map_type::const_iterator;
+	using const_iterator = typename map_type::const_iterator;
+	using mapped_iterator = typename std::vector<T>::iterator;
+	using const_mapped_iterator = typename std::vector<T>::const_iterator;
+
+	flat_hash_multimap() = default;
+
+	explicit flat_hash_multimap(size_type key_count, const Hash& h = Hash{},
+	                            const KeyEqual& e = KeyEqual{})
+	    : groups(key_count, h, e) {}
+
+	template <typename InputIt>
+	flat_hash_multimap(InputIt first, InputIt last, size_type key_count = 0,
+	                   const Hash& h = Hash{}, const KeyEqual& e = KeyEqual{})
+	    : groups(key_count, h, e) {
+		insert(first, last);
+	}
+	flat_hash_multimap(std::initializer_list<value_type> il,
+	                   size_type key_count = 0, const Hash& h = Hash{},
+	                   const KeyEqual& e = KeyEqual{})
+	    : flat_hash_multimap(il.begin(), il.end(), key_count, h, e) {}
+
+	KBLIB_NODISCARD auto begin() const noexcept -> const_iterator {
+		return groups.begin();
+	}
+	KBLIB_NODISCARD auto cbegin() const noexcept -> const_iterator {
+		return groups.begin();
+	}
+	KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+		return groups.end();
+	}
+	KBLIB_NODISCARD auto cend() const noexcept -> const_iterator {
+		return groups.end();
+	}
+
+	KBLIB_NODISCARD auto empty() const noexcept -> bool { return _size == 0; }
+	/**
+	 * @brief The total number of values, over all keys.
+	 */
+	KBLIB_NODISCARD auto size() const noexcept -> size_type { return _size; }
+	/**
+	 * @brief The number of distinct keys.
+	 */
+	KBLIB_NODISCARD auto key_count() const noexcept -> size_type {
+		return groups.size();
+	}
+
+	KBLIB_NODISCARD auto hash_function() const -> hasher {
+		return groups.hash_function();
+	}
+	KBLIB_NODISCARD auto key_eq() const -> key_equal { return groups.key_eq(); }
+
+	auto clear() noexcept -> void {
+		groups.clear();
+		_size = 0;
+	}
+	/**
+	 * @brief Makes room for key_count distinct keys.
+	 */
+	auto reserve(size_type key_count) -> void { groups.reserve(key_count); }
+
+	/**
+	 * @brief Appends T(args...) to the values of key.
+	 *
+	 * @return mapped_iterator An iterator to the new value.
+	 */
+	template <typename K, typename... Args>
+	auto emplace(K&& key, Args&&... args) -> mapped_iterator {
+		auto& group = groups.try_emplace(std::forward<K>(key)).first->second;
+		group.emplace_back(std::forward<Args>(args)...);
+		++_size;
+		return std::prev(group.end());
+	}
+	auto insert(const value_type& v) -> mapped_iterator {
+		return emplace(v.first, v.second);
+	}
+	auto insert(value_type&& v) -> mapped_iterator {
+		return emplace(v.first, std::move(v.second));
+	}
+	template <typename InputIt>
+	auto insert(InputIt first, InputIt last) -> void {
+		for (; first != last; ++first) {
+			emplace(first->first, first->second);
+		}
+	}
+	auto insert(std::initializer_list<value_type> il) -> void {
+		insert(il.begin(), il.end());
+	}
+
+	/**
+	 * @brief Removes key and all of its values.
+	 *
+	 * @return size_type The number of values removed.
+	 */
+	template <typename K>
+	auto erase(const K& key) -> size_type {
+		auto it = groups.find(key);
+		if (it == groups.end()) {
+			return 0;
+		}
+		const auto n = it->second.size();
+		groups.erase(it);
+		_size -= n;
+		return n;
+	}
+	/**
+	 * @brief Removes one value of key, shifting the later ones down. key must
+	 * be present, and pos must be one of its values.
+	 *
+	 * @return mapped_iterator The value after the removed one, or a
+	 * value-initialized iterator if it was the last value of key.
+	 */
+	template <typename K>
+	auto erase(const K& key, const_mapped_iterator pos) -> mapped_iterator {
+		auto it = groups.find(key);
+		auto& group = it->second;
+		--_size;
+		if (group.size() == 1) {
+			groups.erase(it);
+			return {};
+		}
+		const auto next = group.erase(pos);
+		return next == group.end() ? mapped_iterator{} : next;
+	}
+
+	/**
+	 * @brief Finds the group of a key.
+	 */
+	template <typename K>
+	KBLIB_NODISCARD auto find(const K& key) const -> const_iterator {
+		return groups.find(key);
+	}
+	template <typename K>
+	KBLIB_NODISCARD auto contains(const K& key) const -> bool {
+		return groups.contains(key);
+	}
+	/**
+	 * @brief The number of values of key, in constant time.
+	 */
+	template <typename K>
+	KBLIB_NODISCARD auto count(const K& key) const -> size_type {
+		auto it = groups.find(key);
+		return it == groups.end() ? 0 : it->second.size();
+	}
+
+	/**
+	 * @brief The values of key, in insertion order. Empty if key is absent.
+	 */
+	template <typename K>
+	KBLIB_NODISCARD auto equal_range(const K& key)
+	    -> std::pair<mapped_iterator, mapped_iterator> {
+		auto it = groups.find(key);
+		if (it == groups.end()) {
+			return {};
+		}
+		return {it->second.begin(), it->second.end()};
+	}
+	template <typename K>
+	KBLIB_NODISCARD auto equal_range(const K& key) const
+	    -> std::pair<const_mapped_iterator, const_mapped_iterator> {
+		auto it = groups.find(key);
+		if (it == groups.end()) {
+			return {};
+		}
+		return {it->second.begin(), it->second.end()};
+	}
+
+	auto swap(flat_hash_multimap& other) noexcept -> void {
+		groups.swap(other.groups);
+		std::swap(_size, other._size);
+	}
+
+	KBLIB_NODISCARD friend auto operator==(const flat_hash_multimap& l,
+	                                       const flat_hash_multimap& r) -> bool {
+		return l._size == r._size and l.groups == r.groups;
+	}
+	KBLIB_NODISCARD friend auto operator!=(const flat_hash_multimap& l,
+	                                       const flat_hash_multimap& r) -> bool {
+		return not (l == r);
+	}
+
+ private:
+	// Groups are only exposed as const, so that their sizes stay in sync
+	// with _size
+	map_type groups;
+	size_type _size = 0;
+};
+
+} // namespace KBLIB_NS
+
+#endif // FLAT_HASH_MAP_H
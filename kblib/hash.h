@@ -39,6 +39,7 @@
 
 #include <climits>
 #include <cstdint>
+#include <iosfwd>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -254,6 +255,133 @@ KBLIB_NODISCARD constexpr auto FNV32a_s(
 	return hval;
 }
 
+namespace fnv {
+
+	/**
+	 * @brief Inputs at least this long are hashed by FNVa_lanes instead of
+	 * FNVa_s in FNVa_bulk.
+	 */
+	KBLIB_CONSTANT std::size_t bulk_threshold = 256;
+
+	/**
+	 * @brief The number of independent FNVa lanes used by FNVa_lanes, and the
+	 * number of consecutive bytes each lane takes in turn.
+	 */
+	KBLIB_CONSTANT std::size_t lane_count = 4;
+	KBLIB_CONSTANT std::size_t lane_stride = 8;
+
+	/**
+	 * @brief The number of keys hashed side by side by FNV_hash::hash_many,
+	 * when the target can multiply vectors of the hash type.
+	 */
+	KBLIB_CONSTANT std::size_t batch_width = 16;
+
+} // namespace fnv
+
+namespace detail_hash {
+
+	/**
+	 * @brief Implements FNVa_lanes over the bytes returned by byte_at(i) for
+	 * i in [0, length).
+	 */
+	template <typename HashInt, typename ByteAt>
+	KBLIB_NODISCARD constexpr auto fnva_lanes(ByteAt byte_at,
+	                                          std::size_t length,
+	                                          HashInt hval) noexcept -> HashInt {
+		constexpr std::size_t stride = fnv::lane_stride;
+		constexpr std::size_t block = fnv::lane_count * stride;
+		const HashInt prime = fnv::fnv_prime<HashInt>::value;
+		// Each lane is a separate FNVa, so the multiplications do not wait for
+		// each other. Kept in separate variables so they stay in registers.
+		HashInt l0 = static_cast<HashInt>((hval ^ 0u) * prime);
+		HashInt l1 = static_cast<HashInt>((hval ^ 1u) * prime);
+		HashInt l2 = static_cast<HashInt>((hval ^ 2u) * prime);
+		HashInt l3 = static_cast<HashInt>((hval ^ 3u) * prime);
+		std::size_t pos = 0;
+		for (; length - pos >= block; pos += block) {
+			for (std::size_t b = 0; b != stride; ++b) {
+				l0 = static_cast<HashInt>((l0 ^ byte_at(pos + b)) * prime);
+				l1 = static_cast<HashInt>((l1 ^ byte_at(pos + stride + b)) * prime);
+				l2 = static_cast<HashInt>(
+				    (l2 ^ byte_at(pos + 2 * stride + b)) * prime);
+				l3 = static_cast<HashInt>(
+				    (l3 ^ byte_at(pos + 3 * stride + b)) * prime);
+			}
+		}
+		// Combine the lanes by hashing their bytes, then hash the remainder
+		for (HashInt lane : {l0, l1, l2, l3}) {
+			for (std::size_t b = 0; b != sizeof(HashInt); ++b) {
+				hval ^= static_cast<HashInt>(
+				    static_cast<unsigned char>(lane >> (CHAR_BIT * b)));
+				hval *= prime;
+			}
+		}
+		for (; pos != length; ++pos) {
+			hval ^= static_cast<HashInt>(byte_at(pos));
+			hval *= prime;
+		}
+		return hval;
+	}
+
+} // namespace detail_hash
+
+/**
+ * @brief A throughput-oriented variant of FNVa, for long inputs.
+ *
+ * The input is split into blocks of fnv::lane_count * fnv::lane_stride bytes,
+ * and each of fnv::lane_count independent FNVa accumulators hashes its own
+ * fnv::lane_stride bytes of every block. The accumulators are then hashed
+ * together, followed by the bytes of any incomplete final block. Because the
+ * lanes do not depend on each other, this runs several times faster than
+ * FNVa_s on long inputs, but it does not produce the standard FNV-1a hash.
+ *
+ * @tparam HashInt The unsigned integer type to use as the hash result. Must be
+ * either std::uint32_t or std::uint64_t.
+ * @param begin The beginning of the data to hash. Any char-like type.
+ * @param length The number of bytes to hash.
+ * @param hval The initial value for the hash accumulator.
+ * @return HashInt The lane-parallel FNVa hash of the input range.
+ */
+template <typename HashInt, typename CharT>
+KBLIB_NODISCARD constexpr auto FNVa_lanes(
+    const CharT* begin, std::size_t length,
+    HashInt hval = fnv::fnv_offset<HashInt>::value) noexcept -> HashInt {
+	static_assert(sizeof(CharT) == 1, "Can only hash char-like objects.");
+	return detail_hash::fnva_lanes(
+	    [begin](std::size_t i) {
+		    return static_cast<HashInt>(static_cast<unsigned char>(begin[i]));
+	    },
+	    length, hval);
+}
+
+/**
+ * @brief Hashes a contiguous range of bytes, using FNVa_s for short inputs and
+ * FNVa_lanes for inputs of at least fnv::bulk_threshold bytes. This is what
+ * FNV_hash uses for contiguous containers of trivially hashable elements.
+ *
+ * @tparam HashInt The unsigned integer type to use as the hash result. Must be
+ * either std::uint32_t or std::uint64_t.
+ * @param begin The beginning of the data to hash. Any char-like type.
+ * @param length The number of bytes to hash.
+ * @param hval The initial value for the hash accumulator.
+ * @return HashInt The hash of the input range.
+ */
+template <typename HashInt, typename CharT>
+KBLIB_NODISCARD constexpr auto FNVa_bulk(
+    const CharT* begin, std::size_t length,
+    HashInt hval = fnv::fnv_offset<HashInt>::value) noexcept -> HashInt {
+	static_assert(sizeof(CharT) == 1, "Can only hash char-like objects.");
+	if (length >= fnv::bulk_threshold) {
+		return FNVa_lanes(begin, length, hval);
+	}
+	const HashInt prime = fnv::fnv_prime<HashInt>::value;
+	for (const CharT* pos = begin; pos != begin + length; ++pos) {
+		hval ^= static_cast<HashInt>(static_cast<unsigned char>(*pos));
+		hval *= prime;
+	}
+	return hval;
+}
+
 inline namespace literals {
 	/**
 	 * @brief A literal suffix that produces the FNV32a hash of a string literal.
@@ -290,6 +418,120 @@ inline namespace literals {
 
 } // namespace literals
 
+#if KBLIB_USE_CXX17
+template <typename T>
+class multi_span;
+#endif
+
+/**
+ * @brief An incremental FNVa hasher, for input that arrives in pieces.
+ *
+ * Any sequence of update calls produces the same digest as a single call to
+ * FNVa_s over the concatenation of their inputs, which is the standard FNV-1a
+ * hash. Note that FNV_hash uses FNVa_bulk for long contiguous containers, so
+ * the digest of more than fnv::bulk_threshold bytes differs from FNV_hash of
+ * the same string.
+ *
+ * @tparam HashInt The unsigned integer type to use as the hash result. Must be
+ * either std::uint32_t or std::uint64_t.
+ */
+template <typename HashInt = std::size_t>
+class fnv_hasher {
+ public:
+	using result_type = HashInt;
+
+	/**
+	 * @brief The size of the buffer used to read from streams.
+	 */
+	KBLIB_CONSTANT_M std::size_t stream_chunk_size = 16 * 1024;
+
+	constexpr fnv_hasher() noexcept = default;
+	/**
+	 * @brief Starts from a previous hash value instead of the FNV offset, to
+	 * continue hashing a range that was hashed with FNVa.
+	 */
+	constexpr explicit fnv_hasher(HashInt init) noexcept
+	    : hval(init) {}
+
+	/**
+	 * @brief Hashes length bytes starting at begin.
+	 */
+	template <typename CharT>
+	constexpr auto update(const CharT* begin, std::size_t length) noexcept
+	    -> fnv_hasher& {
+		static_assert(sizeof(CharT) == 1, "Can only hash char-like objects.");
+		const HashInt prime = fnv::fnv_prime<HashInt>::value;
+		// Kept in a local so that it stays in a register
+		HashInt h = hval;
+		for (const CharT* pos = begin; pos != begin + length; ++pos) {
+			h ^= static_cast<HashInt>(static_cast<unsigned char>(*pos));
+			h *= prime;
+		}
+		hval = h;
+		return *this;
+	}
+
+	/**
+	 * @brief Hashes a range of char-like objects, as FNVa does.
+	 */
+	template <typename Range,
+	          typename = decltype(std::begin(std::declval<const Range&>()))>
+	constexpr auto update(const Range& r) noexcept -> fnv_hasher& {
+		hval = FNVa(r, hval);
+		return *this;
+	}
+
+#if KBLIB_USE_CXX17
+	/**
+	 * @brief Hashes the elements of a multi_span, one underlying span at a time.
+	 */
+	template <typename T>
+	auto update(const multi_span<T>& s) -> fnv_hasher& {
+		s.for_each_span([this](const auto& sub) {
+			update(sub.data(), static_cast<std::size_t>(sub.size()));
+		});
+		return *this;
+	}
+#endif
+
+	/**
+	 * @brief Hashes everything remaining in the stream, reading it in chunks
+	 * of stream_chunk_size so that the whole input is never held in memory.
+	 *
+	 * Stops at the end of the stream or on a read error, leaving the stream
+	 * state set accordingly.
+	 */
+	template <typename CharT, typename Traits>
+	auto update(std::basic_istream<CharT, Traits>& is) -> fnv_hasher& {
+		static_assert(sizeof(CharT) == 1, "Can only hash char-like streams.");
+		CharT buf[stream_chunk_size];
+		do {
+			is.read(buf, static_cast<decltype(is.gcount())>(stream_chunk_size));
+			update(buf, static_cast<std::size_t>(is.gcount()));
+		} while (is);
+		return *this;
+	}
+
+	/**
+	 * @brief Returns the hash of all input so far. Further updates continue
+	 * from this value.
+	 */
+	KBLIB_NODISCARD constexpr auto digest() const noexcept -> HashInt {
+		return hval;
+	}
+
+	/**
+	 * @brief Discards all input, as if newly constructed.
+	 */
+	constexpr auto reset(HashInt init = fnv::fnv_offset<HashInt>::value) noexcept
+	    -> void {
+		hval = init;
+	}
+
+ private:
+	HashInt hval = fnv::fnv_offset<HashInt>::value;
+};
+
 #if KBLIB_USE_CXX17
 /**
  * @brief Get the number of padding bits in an integral type.
@@ -437,6 +679,115 @@ KBLIB_CONSTANT_V is_trivially_hashable_v
 template <typename T>
 struct is_trivially_hashable : bool_constant<is_trivially_hashable_v<T>> {};
 
+namespace detail_hash {
+
+#if defined(__AVX512DQ__)
+	KBLIB_CONSTANT bool vector_multiply_64 = true;
+#else
+	KBLIB_CONSTANT bool vector_multiply_64 = false;
+#endif
+#if defined(__SSE4_1__) or defined(__ARM_NEON)
+	KBLIB_CONSTANT bool vector_multiply_32 = true;
+#else
+	KBLIB_CONSTANT bool vector_multiply_32 = false;
+#endif
+
+	/**
+	 * @brief Whether the target has a SIMD multiply for HashInt, so that a
+	 * block of keys hashed in lockstep is auto-vectorized.
+	 */
+	template <typename HashInt>
+	KBLIB_CONSTANT_V vector_multiply_v
+	    = sizeof(HashInt) <= 4 ? vector_multiply_32 : vector_multiply_64;
+
+	/**
+	 * @brief FNVa of the Size bytes byte_of(key, b), spelled out so that the
+	 * key is not spilled to memory between bytes.
+	 */
+	template <typename HashInt, typename Key, typename ByteOf,
+	          std::size_t... Bytes>
+	KBLIB_NODISCARD constexpr auto fnva_fixed(const Key& key, HashInt hval,
+	                                          ByteOf byte_of,
+	                                          std::index_sequence<Bytes...>)
+	    -> HashInt {
+		const HashInt prime = fnv::fnv_prime<HashInt>::value;
+		int expand[] = {0, ((hval = static_cast<HashInt>(
+		                         (hval ^ byte_of(key, Bytes)) * prime)),
+		                    0)...};
+		static_cast<void>(expand);
+		return hval;
+	}
+
+	/**
+	 * @brief Hashes fnv::batch_width keys in lockstep: each byte position is
+	 * folded into every key's hash before moving to the next, which the
+	 * compiler turns into vector multiplies.
+	 */
+	template <typename HashInt, typename Key, typename ByteOf,
+	          std::size_t... Bytes>
+	auto fnva_block(const Key* keys, HashInt* out, HashInt hval, ByteOf byte_of,
+	                std::index_sequence<Bytes...>) noexcept -> void {
+		constexpr std::size_t width = fnv::batch_width;
+		const HashInt prime = fnv::fnv_prime<HashInt>::value;
+		HashInt h[width];
+		for (std::size_t j = 0; j != width; ++j) {
+			h[j] = hval;
+		}
+		const auto step = [&](std::size_t b) {
+			for (std::size_t j = 0; j != width; ++j) {
+				h[j] = static_cast<HashInt>((h[j] ^ byte_of(keys[j], b)) * prime);
+			}
+		};
+		int expand[] = {0, (step(Bytes), 0)...};
+		static_cast<void>(expand);
+		for (std::size_t j = 0; j != width; ++j) {
+			out[j] = h[j];
+		}
+	}
+
+	/**
+	 * @brief Implements FNV_hash::hash_many for keys of Size bytes, where
+	 * byte_of(key, b) returns the b'th byte that operator() would hash.
+	 *
+	 * Consecutive keys do not depend on each other, so hashing each with
+	 * straight-line code lets the CPU overlap their multiply chains; on
+	 * targets with a vector multiply for HashInt, blocks of integer keys are
+	 * additionally hashed in SIMD lanes. Lockstep hashing is not used for
+	 * other keys, as gathering their bytes costs more than it saves.
+	 */
+	template <std::size_t Size, bool IntegerKey, typename HashInt, typename Key,
+	          typename ByteOf>
+	auto fnva_many(const Key* keys, std::size_t n, HashInt* out, HashInt hval,
+	               ByteOf byte_of) noexcept -> void {
+		constexpr std::size_t width = fnv::batch_width;
+		std::size_t i = 0;
+		if (IntegerKey and vector_multiply_v<HashInt>) {
+			for (; n - i >= width; i += width) {
+				fnva_block(keys + i, out + i, hval, byte_of,
+				           std::make_index_sequence<Size>{});
+			}
+		}
+		for (; i != n; ++i) {
+			out[i] = fnva_fixed(keys[i], hval, byte_of,
+			                    std::make_index_sequence<Size>{});
+		}
+	}
+
+	/**
+	 * @brief Returns the b'th byte of an integer in hash_order, as to_bytes
+	 * produces it.
+	 */
+	template <typename HashInt, typename UInt>
+	KBLIB_NODISCARD constexpr auto int_byte(UInt key, std::size_t b) noexcept
+	    -> HashInt {
+		return static_cast<HashInt>(static_cast<unsigned char>(
+		    key >> (CHAR_BIT
+		            * (hash_order == endian::little ? b
+		                                            : sizeof(UInt) - 1 - b))));
+	}
+
+} // namespace detail_hash
+
 /**
  * @brief Hasher for any integral type without padding type not explicitly
  * mentioned above.
@@ -453,6 +804,19 @@ struct FNV_hash<
 		to_bytes(key, tmp);
 		return FNVa_a(tmp, offset);
 	}
+
+	/**
+	 * @brief Hashes n keys into out, much faster than calling operator() for
+	 * each of them. out[i] is equal to (*this)(keys[i], offset).
+	 */
+	auto hash_many(const T* keys, std::size_t n, HashInt* out,
+	               HashInt offset
+	               = fnv::fnv_offset<HashInt>::value) const noexcept -> void {
+		detail_hash::fnva_many<sizeof(T), true>(
+		    keys, n, out, offset, [](T key, std::size_t b) {
+			    return detail_hash::int_byte<HashInt>(to_unsigned(key), b);
+		    });
+	}
 };
 
 /**
@@ -470,6 +834,20 @@ struct FNV_hash<T, HashInt, void_if_t<std::is_pointer<T>::value>> {
 		return FNV_hash<std::uintptr_t, HashInt>{}(
 		    reinterpret_cast<std::uintptr_t>(key_in), offset);
 	}
+
+	/**
+	 * @brief Hashes n keys into out, much faster than calling operator() for
+	 * each of them. out[i] is equal to (*this)(keys[i], offset).
+	 */
+	auto hash_many(const T* keys, std::size_t n, HashInt* out,
+	               HashInt offset
+	               = fnv::fnv_offset<HashInt>::value) const noexcept -> void {
+		detail_hash::fnva_many<sizeof(std::uintptr_t), true>(
+		    keys, n, out, offset, [](T key, std::size_t b) {
+			    return detail_hash::int_byte<HashInt>(
+			        reinterpret_cast<std::uintptr_t>(key), b);
+		    });
+	}
 };
 
 /**
@@ -517,6 +895,9 @@ namespace asserts {
 /**
  * @brief Container hasher, for contiguously-stored trivial elements
  *
+ * The bytes of the container are hashed by FNVa_bulk, so long containers
+ * do not get the standard FNV-1a hash.
+ *
  */
 template <typename Container, typename HashInt>
 struct FNV_hash<
@@ -527,8 +908,8 @@ struct FNV_hash<
 
 	KBLIB_NODISCARD auto hash_fast(const Container& key,
 	                               HashInt offset) const noexcept -> HashInt {
-		return FNVa_s<HashInt>(reinterpret_cast<const char*>(key.data()),
-		                       key.size() * sizeof(*key.begin()), offset);
+		return FNVa_bulk<HashInt>(reinterpret_cast<const char*>(key.data()),
+		                          key.size() * sizeof(*key.begin()), offset);
 	}
 
 	KBLIB_NODISCARD constexpr auto operator()(
@@ -537,10 +918,23 @@ struct FNV_hash<
 	    -> HashInt {
 #if KBLIB_USE_CXX20
 		if (std::is_constant_evaluated()) {
+			// Must agree with hash_fast, so the bytes are taken in hash_order
 			using T = typename Container::value_type;
-			for (const auto& e : key) {
-				offset = FNV_hash<T>{}(e, offset);
+			const auto length = key.size() * sizeof(T);
+			auto byte_at = [&key](std::size_t i) {
+				unsigned char tmp[sizeof(T)]{};
+				to_bytes(key[i / sizeof(T)], tmp);
+				return static_cast<HashInt>(tmp[i % sizeof(T)]);
+			};
+			if (length >= fnv::bulk_threshold) {
+				return detail_hash::fnva_lanes(byte_at, length, offset);
+			}
+			const HashInt prime = fnv::fnv_prime<HashInt>::value;
+			for (std::size_t i = 0; i != length; ++i) {
+				offset ^= byte_at(i);
+				offset *= prime;
 			}
+			return offset;
 		} else {
 			return hash_fast(key, offset);
 		}
@@ -576,8 +970,62 @@ struct FNV_hash<
 		return FNVa_a(tmp, offset);
 #endif
 	}
+
+	/**
+	 * @brief Hashes n keys into out, much faster than calling operator() for
+	 * each of them. out[i] is equal to (*this)(keys[i], offset).
+	 */
+	auto hash_many(const T* keys, std::size_t n, HashInt* out,
+	               HashInt offset
+	               = fnv::fnv_offset<HashInt>::value) const noexcept -> void {
+		detail_hash::fnva_many<sizeof(T), false>(
+		    keys, n, out, offset, [](const T& key, std::size_t b) {
+			    return static_cast<HashInt>(
+			        reinterpret_cast<const unsigned char*>(std::addressof(key))[b]);
+		    });
+	}
 };
 
+namespace detail_hash {
+
+	template <typename Hasher, typename Key, typename HashInt, typename = void>
+	struct has_hash_many : std::false_type {};
+
+	template <typename Hasher, typename Key, typename HashInt>
+	struct has_hash_many<
+	    Hasher, Key, HashInt,
+	    void_t<decltype(std::declval<const Hasher&>().hash_many(
+	        std::declval<const Key*>(), std::size_t{},
+	        std::declval<HashInt*>()))>> : std::true_type {};
+
+	template <typename Hasher, typename Key, typename HashInt>
+	auto hash_many(const Hasher& hasher, const Key* keys, std::size_t n,
+	               HashInt* out, std::true_type) -> void {
+		hasher.hash_many(keys, n, out);
+	}
+
+	template <typename Hasher, typename Key, typename HashInt>
+	auto hash_many(const Hasher& hasher, const Key* keys, std::size_t n,
+	               HashInt* out, std::false_type) -> void {
+		for (std::size_t i = 0; i != n; ++i) {
+			out[i] = static_cast<HashInt>(hasher(keys[i]));
+		}
+	}
+
+} // namespace detail_hash
+
+/**
+ * @brief Hashes n keys into out, using hasher.hash_many if it exists, and
+ * calling hasher on each key otherwise. Lets bulk operations such as the
+ * probe phase of a join take the batched path whenever the hasher has one.
+ */
+template <typename Hasher, typename Key, typename HashInt>
+auto hash_many(const Hasher& hasher, const Key* keys, std::size_t n,
+               HashInt* out) -> void {
+	detail_hash::hash_many(hasher, keys, n, out,
+	                       detail_hash::has_hash_many<Hasher, Key, HashInt>{});
+}
+
 /**
  * @brief Container hasher, for non-trivial elements (or non-contiguous storage)
  *
@@ -760,15 +1208,550 @@ struct FNV_hash<void, HashInt, void> {
 	}
 };
 
-template <typename Key, typename Value>
-using hash_map = std::unordered_map<Key, Value, FNV_hash<>, std::equal_to<>>;
-template <typename Key, typename Value>
+namespace mix {
+
+	/**
+	 * @brief The seed mix_hash uses when none is given.
+	 */
+	KBLIB_CONSTANT std::uint64_t default_seed = 0;
+
+	/**
+	 * @brief The odd constants mixed into the input by mix_hash. These are
+	 * the default secret of wyhash.
+	 */
+	KBLIB_CONSTANT std::uint64_t secret0 = 0xa0761d6478bd642full;
+	KBLIB_CONSTANT std::uint64_t secret1 = 0xe7037ed1a0b428dbull;
+	KBLIB_CONSTANT std::uint64_t secret2 = 0x8ebc6af09c88c6e3ull;
+	KBLIB_CONSTANT std::uint64_t secret3 = 0x589965cc75374cc3ull;
+
+} // namespace mix
+
+namespace detail_hash {
+
+	/**
+	 * @brief Multiplies a and b to 128 bits, leaving the low half in a and the
+	 * high half in b.
+	 */
+	constexpr auto mul128(std::uint64_t& a, std::uint64_t& b) noexcept -> void {
+#ifdef __SIZEOF_INT128__
+		__extension__ using u128 = unsigned __int128;
+		const auto r = static_cast<u128>(a) * b;
+		a = static_cast<std::uint64_t>(r);
+		b = static_cast<std::uint64_t>(r >> 64u);
+#else
+		const std::uint64_t ha = a >> 32u, hb = b >> 32u;
+		const std::uint64_t la = a & 0xffffffffu, lb = b & 0xffffffffu;
+		const std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la,
+		                    rl = la * lb;
+		const std::uint64_t t = rl + (rm0 << 32u);
+		const std::uint64_t lo = t + (rm1 << 32u);
+		b = rh + (rm0 >> 32u) + (rm1 >> 32u) + (t < rl) + (lo < t);
+		a = lo;
+#endif
+	}
+
+	/**
+	 * @brief Multiplies a and b to 128 bits and folds the two halves of the
+	 * product together with xor.
+	 */
+	KBLIB_NODISCARD constexpr auto mum(std::uint64_t a, std::uint64_t b) noexcept
+	    -> std::uint64_t {
+		mul128(a, b);
+		return a ^ b;
+	}
+
+	/**
+	 * @brief Adapts a function from byte index to byte value to the pointer
+	 * interface mix_bytes reads through, for inputs that cannot be addressed
+	 * as bytes, such as integers and constant-evaluated containers.
+	 */
+	template <typename ByteAt>
+	struct indexed_bytes {
+		ByteAt byte_at;
+		std::size_t base;
+
+		KBLIB_NODISCARD constexpr auto operator[](std::size_t i) const noexcept
+		    -> unsigned char {
+			return static_cast<unsigned char>(byte_at(base + i));
+		}
+		KBLIB_NODISCARD constexpr auto operator+(std::size_t n) const noexcept
+		    -> indexed_bytes {
+			return {byte_at, base + n};
+		}
+	};
+
+	template <typename ByteAt>
+	KBLIB_NODISCARD constexpr auto make_indexed_bytes(ByteAt byte_at) noexcept
+	    -> indexed_bytes<ByteAt> {
+		return {byte_at, 0};
+	}
+
+	template <typename CharT>
+	KBLIB_NODISCARD constexpr auto byte_value(CharT c) noexcept -> std::uint64_t {
+		return static_cast<unsigned char>(c);
+	}
+
+	/**
+	 * @brief Reads 4 bytes as a little-endian integer.
+	 *
+	 * Spelled out instead of looping, so that the compiler recognizes it as a
+	 * single load.
+	 */
+	template <typename Bytes>
+	KBLIB_NODISCARD constexpr auto read_le4(const Bytes& p) noexcept
+	    -> std::uint64_t {
+		return byte_value(p[0])
+		       | byte_value(p[1]) << 8u
+		       | byte_value(p[2]) << 16u
+		       | byte_value(p[3]) << 24u;
+	}
+
+	/**
+	 * @brief Reads 8 bytes as a little-endian integer.
+	 */
+	template <typename Bytes>
+	KBLIB_NODISCARD constexpr auto read_le8(const Bytes& p) noexcept
+	    -> std::uint64_t {
+		return byte_value(p[0])
+		       | byte_value(p[1]) << 8u
+		       | byte_value(p[2]) << 16u
+		       | byte_value(p[3]) << 24u
+		       | byte_value(p[4]) << 32u
+		       | byte_value(p[5]) << 40u
+		       | byte_value(p[6]) << 48u
+		       | byte_value(p[7]) << 56u;
+	}
+
+	/**
+	 * @brief Implements mix_s over bytes[0] to bytes[length - 1], where bytes
+	 * is a pointer to a char-like type or an indexed_bytes.
+	 *
+	 * Inputs of up to 16 bytes are read as two overlapping words and take a
+	 * single multiply besides seeding and finalization. When length is a
+	 * constant, as for integers and trivially hashable structs, the branches
+	 * fold away and 8, 16 and 32 byte keys are hashed by straight-line code.
+	 */
+	template <typename Bytes>
+	KBLIB_NODISCARD constexpr auto mix_bytes(const Bytes& bytes,
+	                                         std::size_t length,
+	                                         std::uint64_t seed) noexcept
+	    -> std::uint64_t {
+		seed ^= mum(seed ^ mix::secret0, mix::secret1);
+		std::uint64_t a{}, b{};
+		if (length <= 16) {
+			if (length >= 4) {
+				const std::size_t shift = (length >> 3u) << 2u;
+				a = (read_le4(bytes) << 32u) | read_le4(bytes + shift);
+				b = (read_le4(bytes + (length - 4)) << 32u)
+				    | read_le4(bytes + (length - 4 - shift));
+			} else if (length > 0) {
+				a = (byte_value(bytes[0]) << 16u)
+				    | (byte_value(bytes[length >> 1u]) << 8u)
+				    | byte_value(bytes[length - 1]);
+			}
+		} else {
+			std::size_t pos = 0;
+			if (length - pos > 48) {
+				// Three independent accumulators, as in fnva_lanes
+				std::uint64_t see1 = seed, see2 = seed;
+				do {
+					seed = mum(read_le8(bytes + pos) ^ mix::secret1,
+					           read_le8(bytes + pos + 8) ^ seed);
+					see1 = mum(read_le8(bytes + pos + 16) ^ mix::secret2,
+					           read_le8(bytes + pos + 24) ^ see1);
+					see2 = mum(read_le8(bytes + pos + 32) ^ mix::secret3,
+					           read_le8(bytes + pos + 40) ^ see2);
+					pos += 48;
+				} while (length - pos > 48);
+				seed ^= see1 ^ see2;
+			}
+			while (length - pos > 16) {
+				seed = mum(read_le8(bytes + pos) ^ mix::secret1,
+				           read_le8(bytes + pos + 8) ^ seed);
+				pos += 16;
+			}
+			// The last 16 bytes, which may overlap the ones already read
+			a = read_le8(bytes + (length - 16));
+			b = read_le8(bytes + (length - 8));
+		}
+		a ^= mix::secret1;
+		b ^= seed;
+		mul128(a, b);
+		return mum(a ^ mix::secret0 ^ length, b ^ mix::secret1);
+	}
+
+} // namespace detail_hash
+
+/**
+ * @brief A 64-bit multiply-mix hash function in the style of wyhash, for raw
+ * byte ranges.
+ *
+ * Unlike FNVa, every input word passes through a full 64x64->128 bit multiply,
+ * so the hash avalanches well even for small integer keys, and long inputs
+ * are consumed 48 bytes per step.
+ *
+ * @param begin The beginning of the data to hash. Any char-like type.
+ * @param length The number of bytes to hash.
+ * @param seed The seed. Pass in another hash value to chain hashes.
+ * @return std::uint64_t The hash of the input range.
+ */
+template <typename CharT>
+KBLIB_NODISCARD constexpr auto mix_s(const CharT* begin, std::size_t length,
+                                     std::uint64_t seed
+                                     = mix::default_seed) noexcept
+    -> std::uint64_t {
+	static_assert(sizeof(CharT) == 1, "Can only hash char-like objects.");
+	return detail_hash::mix_bytes(begin, length, seed);
+}
+
+/**
+ * @brief A hasher with the same specializations as FNV_hash, using the
+ * multiply-mix hash of mix_s instead of FNVa. The primary template is not
+ * constructible, in order to be compatible with std::hash.
+ *
+ * Trivially hashable keys are hashed as their object representation, and
+ * composite keys hash each part in turn, feeding each hash in as the seed of
+ * the next.
+ *
+ */
+template <typename Key = void, typename = void>
+struct mix_hash {
+	mix_hash() = delete;
+	mix_hash(const mix_hash&) = delete;
+	mix_hash(mix_hash&&) = delete;
+	mix_hash& operator=(const mix_hash&) = delete;
+	mix_hash& operator=(mix_hash&&) = delete;
+};
+
+template <typename Key, typename = void>
+struct is_mix_hashable : std::false_type {};
+
+template <typename Key>
+struct is_mix_hashable<Key,
+                       void_if_t<std::is_constructible<mix_hash<Key>>::value>>
+    : std::true_type {};
+
+template <typename Key>
+KBLIB_CONSTANT_V is_mix_hashable_v = is_mix_hashable<Key>::value;
+
+/**
+ * @brief An empty type is treated as if it were a single null byte.
+ */
+template <typename T>
+struct mix_hash<T, void_if_t<std::is_empty<T>::value>> {
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const T&, std::uint64_t seed = mix::default_seed) const noexcept
+	    -> std::uint64_t {
+		return detail_hash::mix_bytes(
+		    detail_hash::make_indexed_bytes([](std::size_t) { return 0u; }), 1,
+		    seed);
+	}
+};
+
+/**
+ * @brief Hasher for integral types of up to 64 bits, including bool and the
+ * character types.
+ *
+ */
+template <typename T>
+struct mix_hash<T, void_if_t<std::is_integral<T>::value
+                             and sizeof(T) <= sizeof(std::uint64_t)>> {
+	KBLIB_NODISCARD constexpr auto operator()(
+	    T key, std::uint64_t seed = mix::default_seed) const noexcept
+	    -> std::uint64_t {
+		// Sign extension only changes bytes beyond sizeof(T)
+		const auto value = static_cast<std::uint64_t>(key);
+		return detail_hash::mix_bytes(
+		    detail_hash::make_indexed_bytes([value](std::size_t i) {
+			    return static_cast<unsigned char>(value >> (8u * i));
+		    }),
+		    sizeof(T), seed);
+	}
+};
+
+/**
+ * @brief Hasher for any pointer type.
+ *
+ * @note Unfortunately, this specialization cannot be constexpr
+ *
+ */
+template <typename T>
+struct mix_hash<T, void_if_t<std::is_pointer<T>::value>> {
+	KBLIB_NODISCARD auto operator()(
+	    T key_in, std::uint64_t seed = mix::default_seed) const noexcept
+	    -> std::uint64_t {
+		return mix_hash<std::uintptr_t>{}(
+		    reinterpret_cast<std::uintptr_t>(key_in), seed);
+	}
+};
+
+/**
+ * @brief Hasher for any forward iterator type.
+ *
+ * @note Unfortunately, this specialization cannot be constexpr.
+ *
+ */
+template <typename T>
+struct mix_hash<T,
+                void_if_t<(std::is_base_of<std::forward_iterator_tag,
+                                           typename std::iterator_traits<
+                                               T>::iterator_category>::value and
+                           not std::is_pointer<T>::value and
+                           not is_trivially_hashable_v<T> and
+                           std::is_pointer<typename fakestd::invoke_result<
+                               decltype(&T::operator->), T>::type>::value)>> {
+	KBLIB_NODISCARD auto operator()(
+	    T key_in, std::uint64_t seed = mix::default_seed) const noexcept
+	    -> std::uint64_t {
+		if (key_in
+		    == T{}) { // avoid calling to_pointer on a value-initialized iterator
+			return mix_hash<std::uintptr_t>{}(0, seed);
+		} else {
+			return mix_hash<std::uintptr_t>{}(
+			    reinterpret_cast<std::uintptr_t>(to_pointer(key_in)), seed);
+		}
+	}
+};
+
+/**
+ * @brief Container hasher, for contiguously-stored trivial elements
+ *
+ */
+template <typename Container>
+struct mix_hash<
+    Container,
+    void_if_t<(
+        is_contiguous_v<
+            Container> and is_trivially_hashable_v<typename Container::value_type>)>> {
+
+	KBLIB_NODISCARD auto hash_fast(const Container& key,
+	                               std::uint64_t seed) const noexcept
+	    -> std::uint64_t {
+		return mix_s(reinterpret_cast<const unsigned char*>(key.data()),
+		             key.size() * sizeof(*key.begin()), seed);
+	}
+
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const Container& key,
+	    std::uint64_t seed = mix::default_seed) const noexcept -> std::uint64_t {
+#if KBLIB_USE_CXX20
+		if (std::is_constant_evaluated()) {
+			using T = typename Container::value_type;
+			return detail_hash::mix_bytes(
+			    detail_hash::make_indexed_bytes([&key](std::size_t i) {
+				    return std::bit_cast<std::array<unsigned char, sizeof(T)>>(
+				        key[i / sizeof(T)])[i % sizeof(T)];
+			    }),
+			    key.size() * sizeof(T), seed);
+		} else {
+			return hash_fast(key, seed);
+		}
+#else
+		return hash_fast(key, seed);
+#endif
+	}
+};
+
+/**
+ * @brief Hasher for any other trivially copyable type that has no padding.
+ *
+ * @note Unfortunately, this specialization cannot be constexpr until C++20
+ * brings std::bit_cast.
+ *
+ */
+template <typename T>
+struct mix_hash<
+    T, void_if_t<not is_contiguous_v<T>
+                 and not (std::is_integral<T>::value
+                          and sizeof(T) <= sizeof(std::uint64_t))
+                 and not std::is_pointer<T>::value
+                 and is_trivially_hashable_v<T>>> {
+	KBLIB_NODISCARD KBLIB_CXX20(constexpr) auto operator()(
+	    T key, std::uint64_t seed = mix::default_seed) const noexcept
+	    -> std::uint64_t {
+#if KBLIB_USE_CXX20
+		const auto tmp = std::bit_cast<std::array<unsigned char, sizeof(T)>>(key);
+#else
+		unsigned char tmp[sizeof(T)];
+		std::memcpy(tmp, &key, sizeof(T));
+#endif
+		return detail_hash::mix_bytes(
+		    detail_hash::make_indexed_bytes([&tmp](std::size_t i) { return tmp[i]; }),
+		    sizeof(T), seed);
+	}
+};
+
+/**
+ * @brief Container hasher, for non-trivial elements (or non-contiguous storage)
+ *
+ */
+template <typename Container>
+struct mix_hash<
+    Container,
+    void_if_t<
+        value_detected<Container>::value
+        and is_mix_hashable_v<
+            value_detected_t<Container>> and not hash_detected<Container>::value
+        and is_iterable<Container>::value
+        and not (is_contiguous<Container>::value
+                 and is_trivially_hashable_v<typename Container::value_type>)
+        and not is_iterator_v<Container>>> {
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const Container& key,
+	    std::uint64_t seed = mix::default_seed) const noexcept -> std::uint64_t {
+		using Elem = typename Container::value_type;
+		return std::accumulate(cbegin(key), cend(key), seed,
+		                       [](std::uint64_t seed_, const Elem& elem) {
+			                       return mix_hash<Elem>{}(elem, seed_);
+		                       });
+	}
+};
+
+namespace detail_hash {
+
+	template <typename Tuple, std::size_t I>
+	constexpr auto mix_tuple_impl(const Tuple& tuple, std::uint64_t seed,
+	                              std::index_sequence<I>) noexcept
+	    -> std::uint64_t {
+		return mix_hash<typename std::tuple_element<I, Tuple>::type>{}(
+		    std::get<I>(tuple), seed);
+	}
+
+	template <typename Tuple, std::size_t I, std::size_t I2, std::size_t... Is>
+	constexpr auto mix_tuple_impl(const Tuple& tuple, std::uint64_t seed,
+	                              std::index_sequence<I, I2, Is...>) noexcept
+	    -> std::uint64_t {
+		return mix_tuple_impl(
+		    tuple,
+		    mix_hash<typename std::tuple_element<I, Tuple>::type>{}(
+		        std::get<I>(tuple), seed),
+		    std::index_sequence<I2, Is...>{});
+	}
+
+#if KBLIB_USE_CXX17
+	template <typename Tuple, std::size_t... Is>
+	constexpr auto all_mix_hashable_impl(std::index_sequence<Is...>) -> bool {
+		return (... and is_mix_hashable_v<
+		                    typename std::tuple_element<Is, Tuple>::type>);
+	}
+#else
+
+	template <typename Tuple, typename IS>
+	struct all_mix_hashable_impl_t;
+
+	template <typename Tuple, std::size_t I, std::size_t... Is>
+	struct all_mix_hashable_impl_t<Tuple, std::index_sequence<I, Is...>>
+	    : bool_constant<(
+	          is_mix_hashable_v<
+	              typename std::tuple_element<I, Tuple>::
+	                  type> and all_mix_hashable_impl_t<Tuple, std::index_sequence<Is...>>::value)> {
+	};
+
+	template <typename Tuple, std::size_t I>
+	struct all_mix_hashable_impl_t<Tuple, std::index_sequence<I>>
+	    : bool_constant<
+	          is_mix_hashable_v<typename std::tuple_element<I, Tuple>::type>> {};
+
+	template <typename Tuple, std::size_t... Is>
+	constexpr auto all_mix_hashable_impl(std::index_sequence<Is...>) -> bool {
+		return all_mix_hashable_impl_t<Tuple, std::index_sequence<Is...>>::value;
+	}
+#endif
+
+	template <
+	    typename Tuple,
+	    typename std::enable_if<(std::tuple_size<Tuple>::value > 0u), int>::type
+	    = 0>
+	constexpr auto all_mix_hashable() -> bool {
+		return all_mix_hashable_impl<Tuple>(
+		    std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+	}
+
+} // namespace detail_hash
+
+/**
+ * @brief Tuple-like (but not array-like) type hasher
+ *
+ */
+template <typename Tuple>
+struct mix_hash<Tuple,
+                void_if_t<detail_hash::all_mix_hashable<Tuple>()
+                          and not is_trivially_hashable_v<
+                              Tuple> and (std::tuple_size<Tuple>::value > 0u)
+                          and not is_linear_container_v<Tuple>>> {
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const Tuple& key,
+	    std::uint64_t seed = mix::default_seed) const noexcept -> std::uint64_t {
+		return detail_hash::mix_tuple_impl(
+		    key, seed,
+		    std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+	}
+};
+
+#if KBLIB_USE_CXX17
+
+template <typename T>
+struct mix_hash<std::optional<T>, void> {
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const std::optional<T>& key,
+	    std::uint64_t seed = mix::default_seed) const noexcept -> std::uint64_t {
+		if (key) {
+			return mix_hash<T>{}(key.value(), seed);
+		} else {
+			return mix_hash<std::nullopt_t>{}(std::nullopt, seed);
+		}
+	}
+};
+
+template <typename... Ts>
+struct mix_hash<std::variant<Ts...>,
+                void_if_t<detail_hash::all_mix_hashable<std::tuple<Ts...>>()>> {
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const std::variant<Ts...>& key,
+	    std::uint64_t seed = mix::default_seed) const noexcept -> std::uint64_t {
+		// Variant index is hashed alongside the value
+		seed = mix_hash<std::size_t>{}(key.index(), seed);
+		// visit2_nop does nothing when the variant is valueless_by_exception
+		kblib::visit2_nop(key, [&](auto& V) {
+			seed = mix_hash<typename std::remove_reference<decltype(V)>::type>{}(
+			    V, seed);
+		});
+		return seed;
+	}
+};
+
+#endif
+
+/**
+ * @brief Transparent hasher for any hashable type.
+ *
+ */
+template <>
+struct mix_hash<void, void> {
+	KBLIB_CONSTANT_MV is_transparent = true;
+
+	template <typename T>
+	KBLIB_NODISCARD constexpr auto operator()(
+	    const T& key, std::uint64_t seed = mix::default_seed) const noexcept
+	    -> enable_if_t<is_mix_hashable_v<T>, std::uint64_t> {
+		return mix_hash<T>{}(key, seed);
+	}
+};
+
+/**
+ * @brief std::unordered_map with a transparent hasher, FNV_hash<> by default.
+ * mix_hash<> is a drop-in replacement with better avalanche for integral
+ * keys.
+ */
+template <typename Key, typename Value, typename Hasher = FNV_hash<>>
+using hash_map = std::unordered_map<Key, Value, Hasher, std::equal_to<>>;
+template <typename Key, typename Value, typename Hasher = FNV_hash<>>
 using hash_multimap
-    = std::unordered_multimap<Key, Value, FNV_hash<>, std::equal_to<>>;
-template <typename T, typename HashInt>
-using hash_set = std::unordered_set<T, FNV_hash<>, std::equal_to<>>;
-template <typename T, typename HashInt>
-using hash_multiset = std::unordered_set<T, FNV_hash<>, std::equal_to<>>;
+    = std::unordered_multimap<Key, Value, Hasher, std::equal_to<>>;
+template <typename T, typename Hasher = FNV_hash<>>
+using hash_set = std::unordered_set<T, Hasher, std::equal_to<>>;
+template <typename T, typename Hasher = FNV_hash<>>
+using hash_multiset = std::unordered_multiset<T, Hasher, std::equal_to<>>;
 
 } // namespace KBLIB_NS
 
@@ -40,9 +40,12 @@
 #include <vector>
 
 #if KBLIB_USE_CXX17
+#	include <cerrno>
 #	include <cstdio>
 #	include <filesystem>
+#	include <memory>
 #	include <optional>
+#	include <system_error>
 
 #	if ! defined(_WIN32)                        \
 	    && (defined(__unix__) || defined(__unix) \
@@ -51,6 +54,10 @@
 #		include <unistd.h>
 #		if defined(_POSIX_VERSION)
 #			define KBLIB_POSIX_TMPFILE
+#			define KBLIB_POSIX_MMAP
+#			include <fcntl.h>
+#			include <sys/mman.h>
+#			include <sys/stat.h>
 #		endif
 #	endif
 #endif
@@ -535,7 +542,7 @@ struct file_deleter {
 	std::filesystem::path path;
 	using pointer = P;
 	void operator()(P fs) {
-		static_cast<D&>(this)(fs);
+		D{}(fs);
 		std::filesystem::remove(path);
 	}
 };
@@ -556,7 +563,7 @@ template <typename File = std::fstream>
                                std::ios_base::openmode mode
                                = std::ios_base::in | std::ios_base::out) {
 	return std::unique_ptr<File, file_deleter<File>>{
-	    new std::fstream{path, mode}, {path}};
+	    new File{path, mode}, {path}};
 }
 
 template <typename File = std::fstream>
@@ -572,6 +579,112 @@ template <typename File = std::fstream>
 #	endif
 }
 
+/**
+ * @brief A read-only view of the contents of a file, mapped into memory where
+ * the platform allows it, so that opening even a large file is immediate and
+ * its pages are shared between processes and loaded only when touched.
+ * Elsewhere, the file is read into a buffer.
+ *
+ * The data is aligned at least as strictly as memory from operator new. The
+ * file should not be modified while it is mapped.
+ */
+class mapped_file {
+ public:
+	mapped_file() = default;
+
+	/**
+	 * @throw std::system_error if the file can not be opened or mapped.
+	 */
+	explicit mapped_file(const std::filesystem::path& path) {
+#	ifdef KBLIB_POSIX_MMAP
+		const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd == -1) {
+			fail(path);
+		}
+		// The mapping outlives the descriptor
+		void* p = nullptr;
+		struct ::stat st {};
+		if (::fstat(fd, &st) == 0) {
+			size_ = static_cast<std::size_t>(st.st_size);
+			// Mapping an empty file is an error
+			p = size_ == 0
+			        ? nullptr
+			        : ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+		} else {
+			p = MAP_FAILED;
+		}
+		const int error = errno;
+		::close(fd);
+		if (p == MAP_FAILED) {
+			errno = error;
+			fail(path);
+		}
+		data_ = static_cast<const char*>(p);
+#	else
+		std::ifstream in(path, std::ios::in | std::ios::binary);
+		if (not in) {
+			throw std::system_error(std::make_error_code(std::errc::io_error),
+			                        "could not open file " + path.string());
+		}
+		in.seekg(0, std::ios::end);
+		size_ = static_cast<std::size_t>(in.tellg());
+		in.seekg(0, std::ios::beg);
+		buffer_.reset(new char[size_]);
+		if (not in.read(buffer_.get(), static_cast<std::streamsize>(size_))) {
+			throw std::system_error(std::make_error_code(std::errc::io_error),
+			                        "could not read file " + path.string());
+		}
+		data_ = buffer_.get();
+#	endif
+	}
+
+	mapped_file(mapped_file&& other) noexcept
+	    : data_(std::exchange(other.data_, nullptr))
+	    , size_(std::exchange(other.size_, 0))
+#	ifndef KBLIB_POSIX_MMAP
+	    , buffer_(std::move(other.buffer_))
+#	endif
+	{
+	}
+	auto operator=(mapped_file&& other) noexcept -> mapped_file& {
+		mapped_file(std::move(other)).swap(*this);
+		return *this;
+	}
+
+	~mapped_file() {
+#	ifdef KBLIB_POSIX_MMAP
+		if (data_) {
+			::munmap(const_cast<char*>(data_), size_);
+		}
+#	endif
+	}
+
+	auto swap(mapped_file& other) noexcept -> void {
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+#	ifndef KBLIB_POSIX_MMAP
+		std::swap(buffer_, other.buffer_);
+#	endif
+	}
+
+	KBLIB_NODISCARD auto data() const noexcept -> const char* { return data_; }
+	KBLIB_NODISCARD auto size() const noexcept -> std::size_t { return size_; }
+	KBLIB_NODISCARD auto empty() const noexcept -> bool { return size_ == 0; }
+
+ private:
+#	ifdef KBLIB_POSIX_MMAP
+	[[noreturn]] static auto fail(const std::filesystem::path& path) -> void {
+		throw std::system_error(errno, std::generic_category(),
+		                        "could not map file " + path.string());
+	}
+#	else
+	std::unique_ptr<char[]> buffer_;
+#	endif
+
+	const char* data_{};
+	std::size_t size_{};
+};
+
 #endif
 
 } // namespace KBLIB_NS
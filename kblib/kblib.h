@@ -17,14 +17,19 @@
  */
 
 #include "kblib/bits.h"
+#include "kblib/bloom_filter.h"
 #include "kblib/build.h"
+#include "kblib/concurrent_hash_map.h"
 #include "kblib/containers.h"
 #include "kblib/convert.h"
+#include "kblib/external_sort.h"
 #include "kblib/fakestd.h"
+#include "kblib/flat_hash_map.h"
 #include "kblib/format.h"
 #include "kblib/hash.h"
 #include "kblib/io.h"
 #include "kblib/logic.h"
+#include "kblib/perfect_hash.h"
 #include "kblib/simple.h"
 #include "kblib/sort.h"
 #include "kblib/stats.h"
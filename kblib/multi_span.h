@@ -33,6 +33,7 @@
 
 #include "tdecl.h"
 #include <algorithm>
+#include <numeric>
 #include <vector>
 
 #if KBLIB_USE_CXX17
@@ -298,6 +299,17 @@ class multi_span {
 		return spans.back().first == 0;
 	}
 
+	/**
+	 * @brief Calls f with each underlying span, in order. This is much faster
+	 * than iterating element by element when the spans are processed in bulk.
+	 */
+	template <typename F>
+	auto for_each_span(F&& f) const -> void {
+		// see invariant on spans
+		std::for_each(spans.begin(), std::prev(spans.end()),
+		              [&](const multi_impl::subspan_t<T>& s) { f(s.second); });
+	}
+
 	auto diag(std::ostream& os) const noexcept -> void {
 		os << "Diagnostics: " << spans.size() << '\n';
 		for (auto& s : spans) {
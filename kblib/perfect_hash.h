@@ -0,0 +1,307 @@
+/* *****************************************************************************
+ * kblib is a general utility library for C++14 and C++17, intended to provide
+ * performant high-level abstractions and more expressive ways to do simple
+ * things.
+ *
+ * Copyright (c) 2021 killerbee
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+
+/**
+ * @file
+ * @brief Provides perfect_hash_map, an immutable string-keyed map whose
+ * collision-free hash function is found at compile time.
+ *
+ * @author killerbee
+ * @date 2019-2021
+ * @copyright GNU General Public Licence v3.0
+ */
+
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include "hash.h"
+#include "tdecl.h"
+
+#if KBLIB_USE_CXX17
+
+#	include <algorithm>
+#	include <array>
+#	include <cstdint>
+#	include <stdexcept>
+#	include <string_view>
+#	include <utility>
+
+namespace KBLIB_NS {
+
+namespace detail_perfect_hash {
+
+	/**
+	 * @brief The number of slots in the table for N keys: the smallest power
+	 * of two not less than N.
+	 */
+	constexpr auto table_size(std::size_t n) noexcept -> std::size_t {
+		std::size_t m = 1;
+		while (m < n) {
+			m *= 2;
+		}
+		return m;
+	}
+
+	/**
+	 * @brief Derives a slot hash from a key's FNV32a hash and the seed of its
+	 * bucket, without rehashing the key. This is the murmur3 finalizer.
+	 */
+	constexpr auto mix(std::uint32_t h, std::uint32_t seed) noexcept
+	    -> std::uint32_t {
+		h ^= seed * 0x9e3779b9u;
+		h ^= h >> 16u;
+		h *= 0x85ebca6bu;
+		h ^= h >> 13u;
+		h *= 0xc2b2ae35u;
+		h ^= h >> 16u;
+		return h;
+	}
+
+	/**
+	 * @brief Gives up on a bucket after this many seeds. Only reachable with
+	 * pathological key sets; raising it only makes compilation slower.
+	 */
+	KBLIB_CONSTANT std::uint32_t max_seed = 1u << 20u;
+
+} // namespace detail_perfect_hash
+
+/**
+ * @brief An immutable map from strings to T, built at compile time by
+ * make_perfect_hash_map.
+ *
+ * Uses the "hash and displace" scheme: each key's FNV32a hash selects a
+ * bucket, and each bucket records either the slot of its only key or a seed
+ * that maps all of its keys to distinct free slots. A lookup is therefore one
+ * FNV32a of the key, two table reads, and one string comparison.
+ *
+ * Unused slots refer to the first entry, so that a lookup which lands on one
+ * fails the comparison just like a lookup of any other absent key.
+ *
+ * @tparam T The mapped type. Must be a literal type to build the map in a
+ * constant expression.
+ * @tparam N The number of entries.
+ */
+template <typename T, std::size_t N>
+class perfect_hash_map {
+	static_assert(N > 0, "perfect_hash_map must have at least one entry");
+
+ public:
+	using key_type = std::string_view;
+	using mapped_type = T;
+	using value_type = std::pair<std::string_view, T>;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using const_reference = const value_type&;
+	using const_iterator = const value_type*;
+	using iterator = const_iterator;
+
+	/**
+	 * @brief The number of slots in the hash table.
+	 */
+	KBLIB_CONSTANT_M std::size_t table_size
+	    = detail_perfect_hash::table_size(N);
+
+	/**
+	 * @brief Finds a perfect hash function for the given entries.
+	 *
+	 * @throw std::invalid_argument if two entries have the same key, or if no
+	 * perfect hash could be found for them (which in practice requires two
+	 * keys with equal FNV32a hashes). In a constant expression, this is a
+	 * compile error.
+	 */
+	constexpr explicit perfect_hash_map(const value_type (&e)[N])
+	    : entries{} {
+		for (std::size_t i = 0; i != N; ++i) {
+			entries[i] = e[i];
+		}
+		build();
+	}
+
+	KBLIB_NODISCARD constexpr auto begin() const noexcept -> const_iterator {
+		return entries.data();
+	}
+	KBLIB_NODISCARD constexpr auto end() const noexcept -> const_iterator {
+		return entries.data() + N;
+	}
+	KBLIB_NODISCARD constexpr auto size() const noexcept -> size_type {
+		return N;
+	}
+	KBLIB_NODISCARD constexpr auto empty() const noexcept -> bool {
+		return N == 0;
+	}
+
+	/**
+	 * @brief Returns the position of key in the list the map was built from,
+	 * or size() if it is absent. Useful for switching on a key.
+	 */
+	KBLIB_NODISCARD constexpr auto index_of(std::string_view key) const noexcept
+	    -> size_type {
+		const std::uint32_t h = FNV32a(key);
+		const std::int32_t g = displacement[h & (table_size - 1)];
+		const std::size_t slot
+		    = g < 0 ? static_cast<std::size_t>(-g - 1)
+		            : detail_perfect_hash::mix(h, static_cast<std::uint32_t>(g))
+		                  & (table_size - 1);
+		const std::size_t i = slots[slot];
+		return entries[i].first == key ? i : N;
+	}
+
+	KBLIB_NODISCARD constexpr auto find(std::string_view key) const noexcept
+	    -> const_iterator {
+		return begin() + index_of(key);
+	}
+	KBLIB_NODISCARD constexpr auto contains(std::string_view key) const noexcept
+	    -> bool {
+		return index_of(key) != N;
+	}
+	KBLIB_NODISCARD constexpr auto count(std::string_view key) const noexcept
+	    -> size_type {
+		return contains(key);
+	}
+
+	/**
+	 * @throw std::out_of_range if key is not in the map.
+	 */
+	KBLIB_NODISCARD constexpr auto at(std::string_view key) const -> const T& {
+		const auto i = index_of(key);
+		if (i == N) {
+			throw std::out_of_range("perfect_hash_map: key not found");
+		}
+		return entries[i].second;
+	}
+
+ private:
+	constexpr auto build() -> void {
+		using detail_perfect_hash::mix;
+		constexpr std::size_t mask = table_size - 1;
+		std::array<std::uint32_t, N> hashes{};
+		for (std::size_t i = 0; i != N; ++i) {
+			hashes[i] = FNV32a(entries[i].first);
+			for (std::size_t j = 0; j != i; ++j) {
+				if (hashes[j] == hashes[i]) {
+					throw std::invalid_argument(
+					    entries[j].first == entries[i].first
+					        ? "perfect_hash_map: duplicate key"
+					        : "perfect_hash_map: keys have equal FNV32a hashes");
+				}
+			}
+		}
+
+		// Counting sort of the keys by bucket
+		std::array<std::size_t, table_size + 1> bucket_start{};
+		for (std::size_t i = 0; i != N; ++i) {
+			++bucket_start[(hashes[i] & mask) + 1];
+		}
+		std::size_t largest = 0;
+		for (std::size_t b = 0; b != table_size; ++b) {
+			largest = std::max(largest, bucket_start[b + 1]);
+			bucket_start[b + 1] += bucket_start[b];
+		}
+		std::array<std::size_t, N> by_bucket{};
+		{
+			auto next = bucket_start;
+			for (std::size_t i = 0; i != N; ++i) {
+				by_bucket[next[hashes[i] & mask]++] = i;
+			}
+		}
+
+		// Place the largest buckets first, while most slots are free
+		std::array<bool, table_size> used{};
+		for (std::size_t size = largest; size >= 2; --size) {
+			for (std::size_t b = 0; b != table_size; ++b) {
+				const std::size_t first = bucket_start[b];
+				if (bucket_start[b + 1] - first != size) {
+					continue;
+				}
+				std::array<std::size_t, N> placed{};
+				std::uint32_t seed = 0;
+				for (;;) {
+					if (seed == detail_perfect_hash::max_seed) {
+						throw std::invalid_argument(
+						    "perfect_hash_map: no perfect hash found");
+					}
+					std::size_t k = 0;
+					for (; k != size; ++k) {
+						const std::size_t slot
+						    = mix(hashes[by_bucket[first + k]], seed) & mask;
+						bool clash = used[slot];
+						for (std::size_t j = 0; j != k; ++j) {
+							clash = clash or placed[j] == slot;
+						}
+						if (clash) {
+							break;
+						}
+						placed[k] = slot;
+					}
+					if (k == size) {
+						break;
+					}
+					++seed;
+				}
+				displacement[b] = static_cast<std::int32_t>(seed);
+				for (std::size_t k = 0; k != size; ++k) {
+					used[placed[k]] = true;
+					slots[placed[k]]
+					    = static_cast<std::uint32_t>(by_bucket[first + k]);
+				}
+			}
+		}
+		// Singleton buckets point directly at any free slot
+		std::size_t free_slot = 0;
+		for (std::size_t b = 0; b != table_size; ++b) {
+			if (bucket_start[b + 1] - bucket_start[b] == 1) {
+				while (used[free_slot]) {
+					++free_slot;
+				}
+				used[free_slot] = true;
+				displacement[b] = -static_cast<std::int32_t>(free_slot) - 1;
+				slots[free_slot]
+				    = static_cast<std::uint32_t>(by_bucket[bucket_start[b]]);
+			}
+		}
+	}
+
+	std::array<value_type, N> entries;
+	std::array<std::int32_t, table_size> displacement{};
+	std::array<std::uint32_t, table_size> slots{};
+};
+
+/**
+ * @brief Builds a perfect_hash_map from a list of key-value pairs. Intended to
+ * be used to initialize a constexpr variable, so that the search for a perfect
+ * hash happens at compile time:
+ *
+ * @code
+ * constexpr auto keywords = kblib::make_perfect_hash_map<token>(
+ *     {{"if", token::if_}, {"else", token::else_}, {"while", token::while_}});
+ * @endcode
+ */
+template <typename T, std::size_t N>
+KBLIB_NODISCARD constexpr auto make_perfect_hash_map(
+    const std::pair<std::string_view, T> (&entries)[N]) -> perfect_hash_map<T, N> {
+	return perfect_hash_map<T, N>(entries);
+}
+
+} // namespace KBLIB_NS
+
+#endif // KBLIB_USE_CXX17
+
+#endif // PERFECT_HASH_H
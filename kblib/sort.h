@@ -36,8 +36,15 @@
 #include "fakestd.h"
 #include "simple.h"
 
+#include <array>
 #include <bitset>
+#include <exception>
+#include <memory>
 #include <numeric>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 namespace KBLIB_NS {
 
@@ -227,6 +234,13 @@ template <typename T>
 struct is_radix_sortable<T, void_if_t<std::is_enum<T>::value>>
     : std::true_type {};
 
+// Only IEEE 754 binary32 and binary64 have a known bit layout to sort by
+template <typename T>
+struct is_radix_sortable<
+    T, void_if_t<std::is_floating_point<T>::value
+                 and std::numeric_limits<T>::is_iec559
+                 and (sizeof(T) == 4 or sizeof(T) == 8)>> : std::true_type {};
+
 template <std::size_t B>
 struct is_radix_sortable<std::bitset<B>, void> : std::true_type {};
 
@@ -351,6 +365,70 @@ KBLIB_NODISCARD constexpr auto get_byte_index(const T& x,
 	                                  >> (idx % bytes_per * CHAR_BIT));
 }
 
+namespace detail_sort {
+	template <std::size_t Size>
+	struct radix_float_key;
+	template <>
+	struct radix_float_key<4> {
+		using type = std::uint32_t;
+	};
+	template <>
+	struct radix_float_key<8> {
+		using type = std::uint64_t;
+	};
+} // namespace detail_sort
+
+/**
+ * @brief Maps a radix sortable fundamental key to an unsigned integer which
+ * orders the same way under std::less, so that it may be sorted bytewise.
+ *
+ * Unsigned keys are returned unchanged.
+ */
+template <typename T, enable_if_t<std::is_integral<T>::value
+                                  and std::is_unsigned<T>::value,
+                              int> = 0>
+KBLIB_NODISCARD constexpr auto radix_key(T x) noexcept -> T {
+	return x;
+}
+/**
+ * @brief Signed keys have their sign bit flipped, so that negative numbers
+ * order before positive ones.
+ */
+template <typename T, enable_if_t<std::is_integral<T>::value
+                                  and std::is_signed<T>::value,
+                              int> = 0>
+KBLIB_NODISCARD constexpr auto radix_key(T x) noexcept ->
+    typename std::make_unsigned<T>::type {
+	using U = typename std::make_unsigned<T>::type;
+	return static_cast<U>(to_unsigned(x) ^ (U{1} << (bits_of<U> - 1)));
+}
+/**
+ * @brief Enumerations are ordered by their underlying values.
+ */
+template <typename T, enable_if_t<std::is_enum<T>::value, int> = 0>
+KBLIB_NODISCARD constexpr auto radix_key(T x) noexcept -> auto {
+	return radix_key(static_cast<typename std::underlying_type<T>::type>(x));
+}
+/**
+ * @brief IEEE 754 floating point keys have all bits flipped if negative,
+ * and only the sign bit flipped otherwise.
+ *
+ * -0.0 is mapped to the same key as 0.0, as they compare equal. NaNs order
+ * before all other values if their sign bit is set, and after them
+ * otherwise, which is consistent with (but not required by) any strict weak
+ * ordering of the non-NaN values.
+ */
+template <typename T, enable_if_t<std::is_floating_point<T>::value
+                                  and is_radix_sortable<T>::value,
+                              int> = 0>
+KBLIB_NODISCARD auto radix_key(T x) noexcept ->
+    typename detail_sort::radix_float_key<sizeof(T)>::type {
+	using U = typename detail_sort::radix_float_key<sizeof(T)>::type;
+	constexpr U sign = U{1} << (bits_of<U> - 1);
+	const auto bits = byte_cast<U>(x == T{} ? T{} : x);
+	return (bits & sign) ? static_cast<U>(~bits) : static_cast<U>(bits | sign);
+}
+
 template <typename T>
 struct is_trivial_transformation
     : bool_constant<std::is_member_object_pointer<T>::value> {};
@@ -362,23 +440,74 @@ namespace detail_sort {
 
 	template <typename RandomAccessIt, typename Compare>
 	constexpr auto sort(RandomAccessIt, const RandomAccessIt, Compare) -> void {}
-	template <typename RandomAccessIt, typename Compare>
-	constexpr auto stable_sort(RandomAccessIt, const RandomAccessIt, Compare)
-	    -> void {}
 
-	template <typename RandomAccessIt, typename Compare, std::size_t small_size>
-	constexpr auto merge_sort(RandomAccessIt begin, const RandomAccessIt end,
-	                          Compare cmp) -> void {
-		if (end - begin <= small_size) {
-			insertion_sort(begin, end, cmp);
-			return;
-		} else {
-			auto middle = begin + (end - begin) / 2;
-			merge_sort(begin, middle, cmp);
-			merge_sort(middle, end, cmp);
-			std::inplace_merge(begin, middle, end, cmp);
+	/**
+	 * @brief Stable bottom-up merge sort, which merges back and forth between
+	 * the range and buffer instead of allocating.
+	 *
+	 * Runs of small_size elements are first insertion sorted backwards, and
+	 * pairs of runs which are already in order are moved instead of merged,
+	 * so sorted input takes linear time.
+	 *
+	 * @param buffer Scratch space, which is resized to hold the whole range.
+	 * Its contents afterwards are unspecified, but its capacity is kept.
+	 * @remark Complexity: O(n log(n)) comparisons and moves, Θ(n) additional
+	 * space.
+	 */
+	template <std::size_t small_size, typename RandomAccessIt, typename Compare>
+	auto merge_sort(
+	    RandomAccessIt begin, const RandomAccessIt end, Compare cmp,
+	    std::vector<typename std::iterator_traits<RandomAccessIt>::value_type>&
+	        buffer) -> void {
+		const auto n = end - begin;
+		for (auto first = begin; first != end;) {
+			const auto last = first + std::min(end - first, to_signed(small_size));
+			for (auto pos = first + 1; pos < last; ++pos) {
+				if (not cmp(*pos, *(pos - 1))) {
+					continue;
+				}
+				auto tmp = std::move(*pos);
+				auto hole = pos;
+				do {
+					*hole = std::move(*(hole - 1));
+					--hole;
+				} while (hole != first and cmp(tmp, *(hole - 1)));
+				*hole = std::move(tmp);
+			}
+			first = last;
+		}
+		if (to_unsigned(n) <= small_size) {
 			return;
 		}
+
+		buffer.assign(std::make_move_iterator(begin),
+		              std::make_move_iterator(end));
+		bool in_buffer = true;
+		auto merge_pass = [&](auto src, auto dst, std::ptrdiff_t width) {
+			for (std::ptrdiff_t lo = 0; lo < n; lo += 2 * width) {
+				const auto mid = std::min(lo + width, n);
+				const auto hi = std::min(lo + 2 * width, n);
+				if (mid == hi or not cmp(src[mid], src[mid - 1])) {
+					std::move(src + lo, src + hi, dst + lo);
+					continue;
+				}
+				std::merge(std::make_move_iterator(src + lo),
+				           std::make_move_iterator(src + mid),
+				           std::make_move_iterator(src + mid),
+				           std::make_move_iterator(src + hi), dst + lo, cmp);
+			}
+		};
+		for (auto width = to_signed(small_size); width < n; width *= 2) {
+			if (in_buffer) {
+				merge_pass(buffer.begin(), begin, width);
+			} else {
+				merge_pass(begin, buffer.begin(), width);
+			}
+			in_buffer = not in_buffer;
+		}
+		if (in_buffer) {
+			std::move(buffer.begin(), buffer.end(), begin);
+		}
 	}
 
 	template <typename RandomAccessIt, typename Compare, std::size_t small_size>
@@ -393,34 +522,120 @@ namespace detail_sort {
 
 	enum class sort_direction { ascending, descending };
 
-	template <sort_direction dir, typename RandomAccessIt, typename Projection>
-	constexpr auto radix_sort_i(RandomAccessIt begin, const RandomAccessIt end,
-	                            Projection proj) -> void {
+	KBLIB_CONSTANT std::size_t radix_base
+	    = std::numeric_limits<unsigned char>::max() + std::size_t{1};
+
+	template <std::size_t Bytes>
+	using radix_histogram
+	    = std::array<std::array<std::size_t, radix_base>, Bytes>;
+
+	/**
+	 * @brief Performs one stable counting pass of an LSD radix sort, moving
+	 * every element of [begin, end) into place in the output range d_begin.
+	 *
+	 * @param count The histogram of the given byte over the input range.
+	 */
+	template <sort_direction dir, typename InputIt, typename OutputIt,
+	          typename Projection>
+	auto radix_scatter(InputIt begin, const InputIt end, OutputIt d_begin,
+	                   const std::array<std::size_t, radix_base>& count,
+	                   std::size_t byte, Projection& proj) -> void {
+		std::array<std::size_t, radix_base> offsets;
+		std::size_t sum{};
+		for (auto i : range(radix_base)) {
+			// Descending order simply walks the buckets backwards, which keeps
+			// equal keys in their original order.
+			const auto bucket
+			    = (dir == sort_direction::ascending) ? i : radix_base - 1 - i;
+			offsets[bucket] = sum;
+			sum += count[bucket];
+		}
+		for (; begin != end; ++begin) {
+			auto& pos = offsets[get_byte_index(proj(*begin), byte)];
+			d_begin[to_signed(pos++)] = std::move(*begin);
+		}
+	}
+
+	/**
+	 * @brief Gathers the histograms of the lowest `bytes` bytes of every key in
+	 * a single read pass, and determines which of those bytes actually vary.
+	 *
+	 * @return Whether any pass is needed at all.
+	 */
+	template <std::size_t max_bytes, typename RandomAccessIt,
+	          typename Projection>
+	auto radix_count(RandomAccessIt begin, const RandomAccessIt end,
+	                 Projection& proj, std::size_t bytes,
+	                 radix_histogram<max_bytes>& counts,
+	                 std::array<bool, max_bytes>& needed) -> bool {
 		using E = decay_t<decltype(proj(*begin))>;
-		const auto max_bytes = byte_count(E{});
-		for (const auto byte : range(max_bytes)) {
-			for (auto it = begin; it != end; ++it) {
+		const auto size = to_unsigned(end - begin);
+		counts = {};
+		for (auto it = begin; it != end; ++it) {
+			const E key = proj(*it);
+			for (auto byte : range(bytes)) {
+				++counts[byte][get_byte_index(key, byte)];
 			}
 		}
+
+		// A byte needs no pass if every key has the same value for it
+		const E first_key = proj(*begin);
+		bool any_needed = false;
+		needed = {};
+		for (auto byte : range(bytes)) {
+			needed[byte] = counts[byte][get_byte_index(first_key, byte)] != size;
+			any_needed |= needed[byte];
+		}
+		return any_needed;
 	}
-	template <sort_direction dir, typename RandomAccessIt, typename Projection>
-	constexpr auto radix_sort_s(RandomAccessIt begin, const RandomAccessIt end,
-	                            Projection proj) -> void {
-		if (begin != end) {
-			const auto max_bytes = kblib::accumulate(
-			    begin, end, std::size_t{}, [&](auto m, const auto& el) {
-				    return max(m, byte_count(proj(*el)));
-			    });
+
+	/**
+	 * @brief LSD radix sorts a cache-sized bucket by its lowest `bytes` bytes,
+	 * using the matching region of buffer as scratch space. The data starts
+	 * and ends in [begin, end).
+	 */
+	template <sort_direction dir, std::size_t max_bytes, typename RandomAccessIt,
+	          typename BufferIt, typename Projection>
+	auto radix_sort_bucket(RandomAccessIt begin, const RandomAccessIt end,
+	                       BufferIt buffer, Projection& proj, std::size_t bytes)
+	    -> void {
+		const auto size = end - begin;
+		if (size < 2) {
+			return;
 		}
-		const auto max_bytes = [&] {
-			std::size_t max_bytes{};
-			for (const auto v : indirect(begin, end)) {
-				max_bytes = max(max_bytes, byte_count(v));
+		radix_histogram<max_bytes> counts;
+		std::array<bool, max_bytes> needed;
+		if (not radix_count(begin, end, proj, bytes, counts, needed)) {
+			return;
+		}
+		bool in_buffer = false;
+		for (auto byte : range(bytes)) {
+			if (not needed[byte]) {
+				continue;
+			}
+			if (in_buffer) {
+				radix_scatter<dir>(buffer, buffer + size, begin, counts[byte], byte,
+				                   proj);
+			} else {
+				radix_scatter<dir>(begin, end, buffer, counts[byte], byte, proj);
 			}
-			return max_bytes;
-		}();
+			in_buffer = not in_buffer;
+		}
+		if (in_buffer) {
+			std::move(buffer, buffer + size, begin);
+		}
 	}
 
+	/**
+	 * @brief Inputs larger than this many bytes get one MSD pass first, so that
+	 * the remaining LSD passes run over buckets which fit in cache.
+	 */
+	KBLIB_CONSTANT std::size_t radix_msd_threshold = std::size_t{1} << 20u;
+
+	/**
+	 * @brief Histograms small enough to comfortably fit on the stack are kept
+	 * there, larger ones are allocated.
+	 */
 	template <std::size_t size>
 	constexpr auto make_array_for(std::false_type)
 	    -> kblib::containing_ptr<std::array<std::size_t, size>> {
@@ -428,96 +643,618 @@ namespace detail_sort {
 	}
 	template <std::size_t size>
 	auto make_array_for(std::true_type)
-	    -> kblib::heap_value<std::array<std::size_t, size + 1>> {
+	    -> kblib::heap_value<std::array<std::size_t, size>> {
 		return {in_place_agg};
 	}
 
+	/**
+	 * @brief Stable counting sort of [begin, end) into [d_begin, d_begin +
+	 * (end - begin)), for unsigned keys of at most 16 bits.
+	 *
+	 * The histogram of every key value is built in a single read pass. Keys
+	 * of up to 8 bits get a histogram on the stack, wider keys one on the
+	 * heap.
+	 *
+	 * @remark Complexity: Θ(n + 2^bits_of<key>) time and Θ(2^bits_of<key>)
+	 * additional space.
+	 *
+	 * @return false if all keys are equal, in which case nothing is written.
+	 */
 	template <sort_direction dir, typename RandomAccessIt1,
 	          typename RandomAccessIt2, typename Projection>
-	constexpr auto counting_sort(RandomAccessIt1 begin,
-	                             const RandomAccessIt1 end,
-	                             RandomAccessIt2 d_begin, Projection proj)
-	    -> void {
+	auto counting_sort(RandomAccessIt1 begin, const RandomAccessIt1 end,
+	                   RandomAccessIt2 d_begin, Projection proj) -> bool {
 		using E = decay_t<decltype(proj(*begin))>;
-		constexpr auto size = std::numeric_limits<std::make_unsigned_t<E>>::max();
-		auto count = make_array_for<size>(bool_constant<(size > 256)>{});
+		static_assert(std::is_unsigned<E>::value and bits_of<E> <= 16,
+		              "counting_sort requires unsigned keys of at most 16 bits");
+		constexpr auto size = std::size_t{1} << bits_of<E>;
+		if (begin == end) {
+			return false;
+		}
+		auto count = make_array_for<size>(bool_constant<(size > radix_base)>{});
 
 		for (auto cur = begin; cur != end; ++cur) {
-			++count->at(proj(*cur));
+			++(*count)[proj(*cur)];
+		}
+		if ((*count)[proj(*begin)] == to_unsigned(end - begin)) {
+			return false;
 		}
-		kblib::transform_exclusive_scan(begin(*count), end(*count), begin(*count),
-		                                std::size_t{}, std::plus<>{}, proj);
 
-		for (auto cur = end; cur != begin; --cur) {
-			auto el = std::prev(cur);
-			d_begin[--count->at(proj(*el))] = *el;
+		std::size_t sum{};
+		for (auto i : range(size)) {
+			auto& c
+			    = (*count)[(dir == sort_direction::ascending) ? i : size - 1 - i];
+			sum += std::exchange(c, sum);
 		}
 
-		return;
+		for (auto cur = begin; cur != end; ++cur) {
+			d_begin[to_signed((*count)[proj(*cur)]++)] = *cur;
+		}
+		return true;
 	}
 
 	/**
-	 * @brief Sort data after applying an arbitrary transformation to it. The
-	 * primary template handles the general case of arbitrary transformation
-	 * and arbitrary compare predicate.
+	 * @brief Counting sort beats LSD radix sort on narrow keys once there are
+	 * at least this many elements per possible key value.
+	 */
+	KBLIB_CONSTANT std::size_t counting_sort_density = 16;
+
+	/**
+	 * @brief Sorts [begin, end) with counting_sort if its keys are narrow
+	 * enough and the range is dense enough for that to pay off.
+	 *
+	 * @return true if the range was sorted.
+	 */
+	template <sort_direction dir, typename RandomAccessIt, typename Projection,
+	          typename Buffer>
+	auto try_counting_sort(RandomAccessIt begin, const RandomAccessIt end,
+	                       Projection& proj, Buffer& buffer, std::true_type)
+	    -> bool {
+		using E = decay_t<decltype(proj(*begin))>;
+		if (to_unsigned(end - begin) < counting_sort_density << bits_of<E>) {
+			return false;
+		}
+		buffer.assign(std::make_move_iterator(begin),
+		              std::make_move_iterator(end));
+		if (not counting_sort<dir>(std::make_move_iterator(buffer.begin()),
+		                           std::make_move_iterator(buffer.end()), begin,
+		                           proj)) {
+			std::move(buffer.begin(), buffer.end(), begin);
+		}
+		return true;
+	}
+	template <sort_direction dir, typename RandomAccessIt, typename Projection,
+	          typename Buffer>
+	auto try_counting_sort(RandomAccessIt, const RandomAccessIt, Projection&,
+	                       Buffer&, std::false_type) -> bool {
+		return false;
+	}
+
+	/**
+	 * @brief Below this many elements, the fixed cost of building the radix
+	 * histograms outweighs what radix sort saves over a comparison sort.
+	 */
+	KBLIB_CONSTANT std::size_t radix_sort_cutoff = 1024;
+
+	/**
+	 * @brief Detects a range which is already sorted, or sorted in the
+	 * opposite direction, and puts the latter in order in linear time.
+	 *
+	 * Unsorted input is usually rejected within the first few elements, so
+	 * this costs little when it does not apply.
+	 *
+	 * @return true if [begin, end) is now stably sorted.
+	 */
+	template <sort_direction dir, typename RandomAccessIt, typename Projection>
+	auto sort_presorted(RandomAccessIt begin, const RandomAccessIt end,
+	                    Projection& proj) -> bool {
+		const auto before = [&](const auto& a, const auto& b) {
+			return (dir == sort_direction::ascending) ? proj(a) < proj(b)
+			                                          : proj(b) < proj(a);
+		};
+		if (std::is_sorted(begin, end, before)) {
+			return true;
+		}
+		const auto after = [&](const auto& a, const auto& b) {
+			return before(b, a);
+		};
+		if (not std::is_sorted(begin, end, after)) {
+			return false;
+		}
+		// Reversing the range also reverses each run of equal keys, so those
+		// runs are reversed back to keep the sort stable
+		std::reverse(begin, end);
+		for (auto first = begin; first != end;) {
+			auto last = std::next(first);
+			while (last != end and not before(*first, *last)) {
+				++last;
+			}
+			std::reverse(first, last);
+			first = last;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Stable LSD radix sort for unsigned integral keys.
+	 *
+	 * All byte histograms are gathered in a single read pass, and passes over
+	 * bytes which are identical for every key are skipped entirely, so small
+	 * keys in wide types only pay for the bytes they actually use. Large inputs
+	 * are first partitioned on their most significant varying byte, and large
+	 * inputs with keys of at most 16 bits are counting sorted instead. Input
+	 * which is already sorted, or sorted backwards, is detected up front.
+	 *
+	 * @remark Complexity: Θ(n * byte_count(key)) time, Θ(n) additional space.
+	 *
+	 * @param buffer Scratch space, which is resized to hold the whole range.
+	 * Its contents afterwards are unspecified, but its capacity is kept, so
+	 * reusing it for later sorts avoids allocating.
+	 */
+	template <sort_direction dir, typename RandomAccessIt, typename Projection>
+	auto radix_sort_i(
+	    RandomAccessIt begin, const RandomAccessIt end, Projection proj,
+	    std::vector<typename std::iterator_traits<RandomAccessIt>::value_type>&
+	        buffer) -> void {
+		using value_type =
+		    typename std::iterator_traits<RandomAccessIt>::value_type;
+		using E = decay_t<decltype(proj(*begin))>;
+		static_assert(std::is_unsigned<E>::value,
+		              "radix_sort_i requires unsigned keys");
+		constexpr auto max_bytes = byte_count(E{});
+		const auto size = to_unsigned(end - begin);
+		if (size < 2 or sort_presorted<dir>(begin, end, proj)) {
+			return;
+		}
+		if (try_counting_sort<dir>(begin, end, proj, buffer,
+		                           bool_constant<(bits_of<E> <= 16)>{})) {
+			return;
+		}
+
+		radix_histogram<max_bytes> counts;
+		std::array<bool, max_bytes> needed;
+		if (not radix_count(begin, end, proj, max_bytes, counts, needed)) {
+			return;
+		}
+		std::size_t passes{};
+		std::size_t top{};
+		for (auto byte : range(max_bytes)) {
+			if (needed[byte]) {
+				++passes;
+				top = byte;
+			}
+		}
+
+		buffer.assign(std::make_move_iterator(begin),
+		              std::make_move_iterator(end));
+		if (passes > 2 and size * sizeof(value_type) > radix_msd_threshold) {
+			radix_scatter<dir>(buffer.begin(), buffer.end(), begin, counts[top],
+			                   top, proj);
+			// The moved-from elements of buffer serve as scratch for each bucket
+			std::ptrdiff_t pos{};
+			for (auto i : range(radix_base)) {
+				const auto bucket
+				    = (dir == sort_direction::ascending) ? i : radix_base - 1 - i;
+				const auto count = to_signed(counts[top][bucket]);
+				radix_sort_bucket<dir, max_bytes>(begin + pos, begin + pos + count,
+				                                  buffer.begin() + pos, proj, top);
+				pos += count;
+			}
+			return;
+		}
+
+		bool in_buffer = true;
+		for (auto byte : range(max_bytes)) {
+			if (not needed[byte]) {
+				continue;
+			}
+			if (in_buffer) {
+				radix_scatter<dir>(buffer.begin(), buffer.end(), begin,
+				                   counts[byte], byte, proj);
+			} else {
+				radix_scatter<dir>(begin, end, buffer.begin(), counts[byte], byte,
+				                   proj);
+			}
+			in_buffer = not in_buffer;
+		}
+		if (in_buffer) {
+			std::move(buffer.begin(), buffer.end(), begin);
+		}
+	}
+	template <sort_direction dir, typename RandomAccessIt, typename Projection>
+	auto radix_sort_i(RandomAccessIt begin, const RandomAccessIt end,
+	                  Projection proj) -> void {
+		std::vector<typename std::iterator_traits<RandomAccessIt>::value_type>
+		    buffer;
+		radix_sort_i<dir>(begin, end, std::move(proj), buffer);
+	}
+
+
+	template <typename Container, typename = void>
+	struct compares_unsigned
+	    : std::is_unsigned<typename Container::value_type> {};
+
+	// std::char_traits<char> compares characters as if they were unsigned char
+	template <typename Container>
+	struct compares_unsigned<
+	    Container, void_if_t<std::is_same<typename Container::traits_type,
+	                                      std::char_traits<char>>::value>>
+	    : std::true_type {};
+
+	/**
+	 * @brief Gets the bucket of the idx-th most significant byte of a linear
+	 * container key, in an order agreeing with std::less on the container.
+	 *
+	 * @return 0 if the key has no byte idx (so shorter keys sort first),
+	 * otherwise 1 + the byte value.
+	 */
+	template <typename Key>
+	auto radix_string_bucket(const Key& key, std::size_t idx) noexcept
+	    -> std::size_t {
+		using value_type = typename Key::value_type;
+		using U = std::make_unsigned_t<value_type>;
+		constexpr auto bytes_per = byte_count(value_type{});
+		constexpr U sign_flip = compares_unsigned<Key>::value
+		                            ? U{}
+		                            : static_cast<U>(U{1} << (bits_of<U> - 1));
+		if (idx >= byte_count(key)) {
+			return 0;
+		}
+		// Bytes within an element are read from most to least significant
+		const auto elem = static_cast<U>(
+		    static_cast<U>(key[idx / bytes_per]) ^ sign_flip);
+		return std::size_t{1}
+		       + get_byte_index(elem, bytes_per - 1 - idx % bytes_per);
+	}
+
+	/**
+	 * @brief Reorders [begin, begin + n) so that the element at position i is
+	 * the one which was at position perm[i], following each cycle of the
+	 * permutation so that every element is moved only once.
+	 *
+	 * @param perm The permutation to apply. It is left as the identity.
+	 */
+	template <typename RandomAccessIt, typename IndexIt>
+	auto apply_permutation(RandomAccessIt begin, IndexIt perm, std::size_t n)
+	    -> void {
+		for (auto i : range(n)) {
+			auto j = static_cast<std::size_t>(perm[to_signed(i)]);
+			if (j == i) {
+				continue;
+			}
+			auto tmp = std::move(begin[to_signed(i)]);
+			auto hole = i;
+			while (j != i) {
+				begin[to_signed(hole)] = std::move(begin[to_signed(j)]);
+				perm[to_signed(hole)] = hole;
+				hole = j;
+				j = static_cast<std::size_t>(perm[to_signed(j)]);
+			}
+			begin[to_signed(hole)] = std::move(tmp);
+			perm[to_signed(hole)] = hole;
+		}
+	}
+
+	/**
+	 * @brief Subranges smaller than this are not worth partitioning further.
+	 */
+	KBLIB_CONSTANT std::size_t radix_string_threshold = 64;
+
+	/**
+	 * @brief MSD radix sort for linear containers of integral elements, such
+	 * as strings. It is stable.
+	 *
+	 * Rather than the keys themselves, the sort partitions compact entries
+	 * holding the next 8 bytes of the key, so each key is only dereferenced
+	 * once every 8 levels; the resulting permutation is then applied to the
+	 * range. Bytes shared by a whole subrange (common prefixes) are skipped
+	 * without moving anything, and small subranges are finished by comparison,
+	 * with insertion_sort below small_size.
+	 *
+	 * @remark Complexity: O(n * k) time, where k is the average length of the
+	 * distinguishing prefix of each key, and O(n) additional space.
+	 */
+	template <sort_direction dir, std::size_t small_size,
+	          typename RandomAccessIt, typename Projection, typename Compare>
+	auto radix_sort_s(RandomAccessIt begin, const RandomAccessIt end,
+	                  Projection proj, Compare comp) -> void {
+		constexpr std::size_t buckets = radix_base + 1;
+		constexpr std::size_t word_bytes = sizeof(std::uint64_t);
+		const auto n = to_unsigned(end - begin);
+		if (n < small_size) {
+			insertion_sort(begin, end, comp);
+			return;
+		} else if (n < radix_string_threshold) {
+			std::stable_sort(begin, end, comp);
+			return;
+		}
+
+		struct entry {
+			// bytes [depth / word_bytes * word_bytes, +word_bytes) of the key
+			std::uint64_t word;
+			std::size_t length;
+			std::size_t index;
+		};
+		auto load = [&](entry& e, std::size_t depth) {
+			const auto& key = proj(begin[to_signed(e.index)]);
+			e.word = 0;
+			for (auto i : range(word_bytes)) {
+				// bucket 0 (end of key) conveniently pads with zeros
+				const auto b = radix_string_bucket(key, depth + i);
+				e.word = (e.word << CHAR_BIT) | (b ? b - 1 : 0);
+			}
+		};
+		auto bucket_of = [&](const entry& e, std::size_t depth) -> std::size_t {
+			if (depth >= e.length) {
+				return 0;
+			}
+			const auto shift = (word_bytes - 1 - depth % word_bytes) * CHAR_BIT;
+			return 1 + ((e.word >> shift) & 0xFFu);
+		};
+		// Entries which share a prefix and differ in their cached bytes are
+		// correctly ordered by those bytes; otherwise compare the real keys.
+		// Equivalent keys keep their original order, so the sort is stable.
+		auto entry_comp = [&](const entry& a, const entry& b) {
+			if (a.word != b.word) {
+				return (dir == sort_direction::ascending) ? a.word < b.word
+				                                          : a.word > b.word;
+			}
+			const auto& x = begin[to_signed(a.index)];
+			const auto& y = begin[to_signed(b.index)];
+			if (comp(x, y)) {
+				return true;
+			} else if (comp(y, x)) {
+				return false;
+			} else {
+				return a.index < b.index;
+			}
+		};
+
+		std::vector<entry> entries(n);
+		for (auto i : range(n)) {
+			entries[i].index = i;
+			entries[i].length = byte_count(proj(begin[to_signed(i)]));
+			load(entries[i], 0);
+		}
+
+		// Each pass scatters a subrange from one of these into the other
+		std::vector<entry> scratch(n);
+		struct subrange {
+			std::size_t begin;
+			std::size_t end;
+			std::size_t depth;
+			bool in_scratch;
+		};
+		auto finish = [&](const subrange& r) {
+			if (r.in_scratch) {
+				std::copy(scratch.begin() + to_signed(r.begin),
+				          scratch.begin() + to_signed(r.end),
+				          entries.begin() + to_signed(r.begin));
+			}
+		};
+		std::vector<subrange> todo{{0, n, 0, false}};
+		while (not todo.empty()) {
+			const auto cur = todo.back();
+			todo.pop_back();
+			auto& src = cur.in_scratch ? scratch : entries;
+			auto& dst = cur.in_scratch ? entries : scratch;
+			const auto size = cur.end - cur.begin;
+			const auto first = src.begin() + to_signed(cur.begin);
+			if (size < small_size) {
+				insertion_sort(first, first + to_signed(size), entry_comp);
+				finish(cur);
+				continue;
+			} else if (size < radix_string_threshold) {
+				std::sort(first, first + to_signed(size), entry_comp);
+				finish(cur);
+				continue;
+			}
+			if (cur.depth % word_bytes == 0 and cur.depth != 0) {
+				for (auto i : range(cur.begin, cur.end)) {
+					load(src[i], cur.depth);
+				}
+			}
+
+			std::array<std::size_t, buckets> counts{};
+			for (auto i : range(cur.begin, cur.end)) {
+				++counts[bucket_of(src[i], cur.depth)];
+			}
+			if (counts[0] == size) {
+				// every key is identical
+				finish(cur);
+				continue;
+			}
+			if (counts[bucket_of(src[cur.begin], cur.depth)] == size) {
+				// Common prefix: skip as much of it as the cached bytes show
+				const auto offset = cur.depth % word_bytes;
+				const auto head = src[cur.begin].word;
+				std::uint64_t diff{};
+				auto skip = word_bytes - offset;
+				for (auto i : range(cur.begin, cur.end)) {
+					diff |= src[i].word ^ head;
+					skip = std::min(skip, src[i].length - cur.depth);
+				}
+				// The first differing cached byte bounds the common prefix
+				for (auto i : range(offset + 1, word_bytes)) {
+					const auto shift = (word_bytes - 1 - i) * CHAR_BIT;
+					if ((diff >> shift) & 0xFFu) {
+						skip = std::min(skip, i - offset);
+						break;
+					}
+				}
+				todo.push_back(
+				    {cur.begin, cur.end, cur.depth + skip, cur.in_scratch});
+				continue;
+			}
+
+			std::array<std::size_t, buckets> next;
+			std::size_t sum = cur.begin;
+			for (auto i : range(buckets)) {
+				const auto bucket
+				    = (dir == sort_direction::ascending) ? i : buckets - 1 - i;
+				next[bucket] = sum;
+				sum += counts[bucket];
+			}
+			for (auto i : range(cur.begin, cur.end)) {
+				dst[next[bucket_of(src[i], cur.depth)]++] = src[i];
+			}
+			for (auto bucket : range(buckets)) {
+				const subrange sub{next[bucket] - counts[bucket], next[bucket],
+				                   cur.depth + 1, not cur.in_scratch};
+				// Keys in bucket 0 have ended, and are therefore all equal
+				if (bucket != 0 and counts[bucket] > 1) {
+					todo.push_back(sub);
+				} else {
+					finish(sub);
+				}
+			}
+		}
+
+		std::vector<std::size_t> perm(n);
+		for (auto i : range(n)) {
+			perm[i] = entries[i].index;
+		}
+		apply_permutation(begin, perm.begin(), n);
+	}
+
+	template <sort_direction dir, std::size_t small_size,
+	          typename RandomAccessIt, typename Projection, typename Compare>
+	auto string_sort(RandomAccessIt begin, const RandomAccessIt end,
+	                 Projection proj, Compare comp, std::true_type) -> void {
+		radix_sort_s<dir, small_size>(begin, end, proj, comp);
+	}
+	// Bitsets are not handled by the radix engine yet
+	template <sort_direction dir, std::size_t small_size,
+	          typename RandomAccessIt, typename Projection, typename Compare>
+	auto string_sort(RandomAccessIt begin, const RandomAccessIt end,
+	                 Projection, Compare comp, std::false_type) -> void {
+		std::sort(begin, end, comp);
+	}
+
+	template <typename RandomAccessIt, typename UnaryOperation>
+	using sort_key_t = decay_t<decltype(kblib::invoke(
+	    std::declval<UnaryOperation&>(), *std::declval<RandomAccessIt&>()))>;
+
+	/**
+	 * @brief A sort key cached alongside the original position of the element
+	 * it was computed from.
 	 */
+	template <typename SortKey>
+	struct key_index {
+		SortKey key;
+		std::size_t index;
+	};
+
 	template <typename RandomAccessIt, typename UnaryOperation,
 	          typename BinaryPredicate, typename SortKey,
 	          std::size_t small_size = 8,
 	          bool = is_trivial_transformation<UnaryOperation>::value,
-	          bool = std::is_fundamental<SortKey>::value,
+	          bool = std::is_fundamental<SortKey>::value
+	                 or std::is_enum<SortKey>::value,
 	          bool = is_radix_sortable_v<SortKey>,
 	          bool = std::is_integral<SortKey>::value>
+	struct sort_transform_impl;
+
+	/**
+	 * @brief Computes the sort key of every element of [begin, end) exactly
+	 * once, and sorts the cached keys together with their indices.
+	 *
+	 * The keys are sorted by dispatching back to sort_transform_impl with a
+	 * pointer to member, so radix sortable keys still get radix sorted.
+	 *
+	 * @return The decorated keys, in sorted order.
+	 */
+	template <typename SortKey, typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate>
+	auto sorted_keys(RandomAccessIt begin, const RandomAccessIt end,
+	                 UnaryOperation& transform, BinaryPredicate compare)
+	    -> std::vector<key_index<SortKey>> {
+		const auto n = to_unsigned(end - begin);
+		std::vector<key_index<SortKey>> keys;
+		keys.reserve(n);
+		for (auto i : range(n)) {
+			keys.push_back({kblib::invoke(transform, begin[to_signed(i)]), i});
+		}
+		using key_ptr = SortKey key_index<SortKey>::*;
+		using key_it = typename std::vector<key_index<SortKey>>::iterator;
+		sort_transform_impl<key_it, key_ptr, BinaryPredicate, SortKey>::inplace(
+		    keys.begin(), keys.end(), &key_index<SortKey>::key,
+		    std::move(compare));
+		return keys;
+	}
+
+	/**
+	 * @brief Sort data after applying an arbitrary transformation to it. The
+	 * primary template handles the general case of arbitrary transformation
+	 * and arbitrary compare predicate.
+	 *
+	 * Arbitrary transformations may be expensive, so instead of calling them
+	 * twice per comparison, each key is computed once into a scratch buffer
+	 * (decorate-sort-undecorate). Keys extracted by a pointer to member are
+	 * simply compared.
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate, typename SortKey, std::size_t small_size,
+	          bool trivial, bool F, bool R, bool I>
 	struct sort_transform_impl {
-		static constexpr auto inplace(RandomAccessIt begin,
-		                              const RandomAccessIt end,
-		                              UnaryOperation&& transform,
-		                              BinaryPredicate&& compare) -> void {
-			auto comp
-			    = [&compare, &transform](RandomAccessIt a, RandomAccessIt b) {
-				      return kblib::invoke(compare, kblib::invoke(transform, *a),
-				                           kblib::invoke(transform, *b));
-			      };
-			if (end - begin < small_size) {
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, BinaryPredicate compare)
+		    -> void {
+			auto comp = [&](const auto& a, const auto& b) {
+				return kblib::invoke(compare, kblib::invoke(transform, a),
+				                     kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
 				insertion_sort(begin, end, comp);
-				return;
+			} else if (trivial) {
+				std::sort(begin, end, comp);
 			} else {
-				/// TODO(killerbee13): write efficient inplace sort_transform
+				scratch(begin, end, std::move(transform), std::move(compare));
 			}
 		}
 
-		static constexpr auto scratch(RandomAccessIt begin,
-		                              const RandomAccessIt end,
-		                              UnaryOperation&& transform,
-		                              BinaryPredicate&& compare) -> void {
-			auto comp
-			    = [&compare, &transform](RandomAccessIt a, RandomAccessIt b) {
-				      return kblib::invoke(compare, kblib::invoke(transform, *a),
-				                           kblib::invoke(transform, *b));
-			      };
-			if (end - begin < small_size) {
-				insertion_sort(begin, end, comp);
+		/**
+		 * @brief Sorts [begin, end) by keys cached in a scratch buffer, then
+		 * moves each element into place by following the cycles of the
+		 * resulting permutation.
+		 *
+		 * @remark Complexity: Θ(n) calls to transform, Θ(n) element moves, and
+		 * Θ(n) additional space for the keys and their indices.
+		 */
+		static auto scratch(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, BinaryPredicate compare)
+		    -> void {
+			const auto n = to_unsigned(end - begin);
+			if (n < 2) {
 				return;
-			} else {
-				/// TODO(killerbee13): write efficient sort_transform
 			}
+			auto keys
+			    = sorted_keys<SortKey>(begin, end, transform, std::move(compare));
+			std::vector<std::size_t> perm(n);
+			for (auto i : range(n)) {
+				perm[i] = keys[i].index;
+			}
+			// Free the keys before the payloads start moving around
+			keys = {};
+			apply_permutation(begin, perm.begin(), n);
 		}
 
+		/**
+		 * @brief Copies the first (d_end - d_begin) elements of the sorted
+		 * order of [begin, end) into [d_begin, d_end), without modifying the
+		 * input.
+		 */
 		template <typename RandomAccessIt2>
-		static constexpr auto copy(RandomAccessIt begin, const RandomAccessIt end,
-		                           RandomAccessIt2 d_begin, RandomAccessIt2 d_end,
-		                           UnaryOperation&& transform,
-		                           BinaryPredicate&& compare) -> void {
-			auto comp
-			    = [&compare, &transform](RandomAccessIt a, RandomAccessIt b) {
-				      return kblib::invoke(compare, kblib::invoke(transform, *a),
-				                           kblib::invoke(transform, *b));
-			      };
-			if (end - begin < small_size) {
-				insertion_sort_copy(begin, end, d_begin, d_end, comp);
-				return;
-			} else {
-				/// TODO(killerbee13): write efficent sort_transform_copy
+		static auto copy(RandomAccessIt begin, const RandomAccessIt end,
+		                 RandomAccessIt2 d_begin, RandomAccessIt2 d_end,
+		                 UnaryOperation transform, BinaryPredicate compare)
+		    -> void {
+			auto keys
+			    = sorted_keys<SortKey>(begin, end, transform, std::move(compare));
+			auto out = d_begin;
+			for (auto it = keys.begin(); it != keys.end() and out != d_end;
+			     ++it, ++out) {
+				*out = begin[to_signed(it->index)];
 			}
 		}
 	};
@@ -532,171 +1269,820 @@ namespace detail_sort {
 	          typename BinaryPredicate, typename SortKey, std::size_t small_size>
 	struct sort_transform_impl<RandomAccessIt, UnaryOperation, BinaryPredicate,
 	                           SortKey, small_size, true, false, false, false> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED BinaryPredicate&& compare)
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, BinaryPredicate compare)
 		    -> void {
-			auto comp
-			    = [&compare, &transform](RandomAccessIt a, RandomAccessIt b) {
-				      return kblib::invoke(compare, kblib::invoke(transform, *a),
-				                           kblib::invoke(transform, *b));
-			      };
-			/// TODO(killerbee13): write efficient sort_transform
+			auto comp = [&](const auto& a, const auto& b) {
+				return kblib::invoke(compare, kblib::invoke(transform, a),
+				                     kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else {
+				std::sort(begin, end, comp);
+			}
 		}
 	};
 #endif
 
 	/**
 	 * @brief Sort implementation for pointer to member object of fundamental
-	 * non-integral type with default sorting, so sort keys are constant time
-	 * to extract and compare
+	 * type which cannot be radix sorted (such as long double), so sort keys are
+	 * constant time to extract and compare
 	 */
-	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
-	          typename SortKey, std::size_t small_size>
-	struct sort_transform_impl<RandomAccessIt, UnaryOperation, std::less<LessT>,
+	template <typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate, typename SortKey, std::size_t small_size>
+	struct sort_transform_impl<RandomAccessIt, UnaryOperation, BinaryPredicate,
 	                           SortKey, small_size, true, true, false, false> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED std::less<LessT>&& compare)
-		    -> void {
-			/// TODO(killerbee13): write efficient inplace sort_transform
-		}
-	};
-	/**
-	 * @brief Sort implementation for pointer to member object of fundamental
-	 * non-integral type with reverse sorting, so sort keys are constant time
-	 * to extract and compare
-	 */
-	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
-	          typename SortKey, std::size_t small_size>
-	struct sort_transform_impl<RandomAccessIt, UnaryOperation,
-	                           std::greater<LessT>, SortKey, small_size, true,
-	                           true, false, false> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED std::greater<LessT>&& compare)
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, BinaryPredicate compare)
 		    -> void {
-			/// TODO(killerbee13): write efficient inplace sort_transform
+			auto comp = [&](const auto& a, const auto& b) {
+				return kblib::invoke(compare, kblib::invoke(transform, a),
+				                     kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else {
+				std::sort(begin, end, comp);
+			}
 		}
 	};
 
 	/**
-	 * @brief Sort implementation for pointer to member object of integral
-	 * type with default sorting, so we can do radix sort
+	 * @brief Sort implementation for pointer to member object of integral,
+	 * enumeration, or floating point type with default sorting, so we can do
+	 * radix sort on radix_key of the key
 	 */
 	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
-	          typename SortKey, std::size_t small_size>
+	          typename SortKey, std::size_t small_size, bool I>
 	struct sort_transform_impl<RandomAccessIt, UnaryOperation, std::less<LessT>,
-	                           SortKey, small_size, true, true, true, true> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED std::less<LessT>&& compare)
+	                           SortKey, small_size, true, true, true, I> {
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::less<LessT> compare)
 		    -> void {
-			/// TODO(killerbee13): write efficient inplace radix sort_transform
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else if (to_unsigned(end - begin) < radix_sort_cutoff) {
+				std::sort(begin, end, comp);
+			} else {
+				radix_sort_i<sort_direction::ascending>(
+				    begin, end, [&](const auto& v) {
+					    return radix_key(SortKey(kblib::invoke(transform, v)));
+				    });
+			}
 		}
 	};
 	/**
-	 * @brief Sort implementation for pointer to member object of integral
-	 * type with reverse sorting, so we can do radix sort
+	 * @brief Sort implementation for pointer to member object of integral,
+	 * enumeration, or floating point type with reverse sorting, so we can do
+	 * radix sort on radix_key of the key
 	 */
 	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
-	          typename SortKey, std::size_t small_size>
+	          typename SortKey, std::size_t small_size, bool I>
 	struct sort_transform_impl<RandomAccessIt, UnaryOperation,
 	                           std::greater<LessT>, SortKey, small_size, true,
-	                           true, true, true> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED std::greater<LessT>&& compare)
+	                           true, true, I> {
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::greater<LessT> compare)
 		    -> void {
-			/// TODO(killerbee13): write efficient inplace radix sort_transform
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else if (to_unsigned(end - begin) < radix_sort_cutoff) {
+				std::sort(begin, end, comp);
+			} else {
+				radix_sort_i<sort_direction::descending>(
+				    begin, end, [&](const auto& v) {
+					    return radix_key(SortKey(kblib::invoke(transform, v)));
+				    });
+			}
 		}
 	};
 
 #if 1 // Do string radix sorting
 	/**
-	 * @brief Sort implementation for key of radix sortable type
-	 * type with default sorting
+	 * @brief Sort implementation for pointer to member object of radix sortable
+	 * container type with default sorting
 	 */
 	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
-	          typename SortKey, std::size_t small_size, bool M>
+	          typename SortKey, std::size_t small_size>
 	struct sort_transform_impl<RandomAccessIt, UnaryOperation, std::less<LessT>,
-	                           SortKey, small_size, M, false, true, false> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED std::less<LessT>&& compare)
+	                           SortKey, small_size, true, false, true, false> {
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::less<LessT> compare)
 		    -> void {
-			/// TODO(killerbee13): write efficient inplace radix sort_transform
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			string_sort<sort_direction::ascending, small_size>(
+			    begin, end,
+			    [&](const auto& v) -> decltype(auto) {
+				    return kblib::invoke(transform, v);
+			    },
+			    comp, is_linear_container<SortKey>{});
 		}
 	};
 	/**
-	 * @brief Sort implementation for key of radix sortable type
-	 * type with reverse sorting
+	 * @brief Sort implementation for pointer to member object of radix sortable
+	 * container type with reverse sorting
 	 */
 	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
-	          typename SortKey, std::size_t small_size, bool M>
+	          typename SortKey, std::size_t small_size>
 	struct sort_transform_impl<RandomAccessIt, UnaryOperation,
-	                           std::greater<LessT>, SortKey, small_size, M,
+	                           std::greater<LessT>, SortKey, small_size, true,
 	                           false, true, false> {
-		static constexpr auto inplace(KBLIB_UNUSED RandomAccessIt begin,
-		                              KBLIB_UNUSED const RandomAccessIt end,
-		                              KBLIB_UNUSED UnaryOperation&& transform,
-		                              KBLIB_UNUSED std::greater<LessT>&& compare)
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::greater<LessT> compare)
 		    -> void {
-			/// TODO(killerbee13): write efficient inplace radix sort_transform
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			string_sort<sort_direction::descending, small_size>(
+			    begin, end,
+			    [&](const auto& v) -> decltype(auto) {
+				    return kblib::invoke(transform, v);
+			    },
+			    comp, is_linear_container<SortKey>{});
 		}
 	};
 #endif
-} // namespace detail_sort
 
-/**
- * @brief Sorts a range after applying a transformation.
- *
- * Complexity: worst-case O(N log(N)), where N = std::distance(begin, end)
- * comparisons and swaps.
- *
- * @param begin,end The range to sort
- * @param transform A transformer (such as unary function or pointer to
- * member) which will be applied to each object before comparing it. A
- * transformer may not modify the object it is called with.
- *
- * @param compare A comparison predicate which returns true if the first
- * argument shall be ordered before the second. BinaryPredicate must meet the
- * requirements of the Compare named requirement.
- */
-template <typename RandomAccessIt, typename UnaryOperation,
-          typename BinaryPredicate>
-constexpr auto sort_transform(RandomAccessIt begin, RandomAccessIt end,
-                              UnaryOperation&& transform,
-                              BinaryPredicate&& compare) -> void {
+	template <sort_direction dir, std::size_t small_size,
+	          typename RandomAccessIt, typename Projection, typename Compare,
+	          typename Buffer>
+	auto stable_string_sort(RandomAccessIt begin, const RandomAccessIt end,
+	                        Projection proj, Compare comp, Buffer&,
+	                        std::true_type) -> void {
+		radix_sort_s<dir, small_size>(begin, end, proj, comp);
+	}
+	template <sort_direction dir, std::size_t small_size,
+	          typename RandomAccessIt, typename Projection, typename Compare,
+	          typename Buffer>
+	auto stable_string_sort(RandomAccessIt begin, const RandomAccessIt end,
+	                        Projection, Compare comp, Buffer& buffer,
+	                        std::false_type) -> void {
+		merge_sort<small_size>(begin, end, comp, buffer);
+	}
+
+	template <typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate, typename SortKey,
+	          std::size_t small_size = 8,
+	          bool = is_trivial_transformation<UnaryOperation>::value,
+	          bool = std::is_fundamental<SortKey>::value
+	                 or std::is_enum<SortKey>::value,
+	          bool = is_radix_sortable_v<SortKey>>
+	struct stable_sort_transform_impl;
+
+	/**
+	 * @brief Like sorted_keys, but equivalent keys keep the order of the
+	 * elements they were computed from.
+	 */
+	template <typename SortKey, typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate>
+	auto stably_sorted_keys(RandomAccessIt begin, const RandomAccessIt end,
+	                        UnaryOperation& transform, BinaryPredicate compare)
+	    -> std::vector<key_index<SortKey>> {
+		const auto n = to_unsigned(end - begin);
+		std::vector<key_index<SortKey>> keys;
+		keys.reserve(n);
+		for (auto i : range(n)) {
+			keys.push_back({kblib::invoke(transform, begin[to_signed(i)]), i});
+		}
+		using key_ptr = SortKey key_index<SortKey>::*;
+		using key_it = typename std::vector<key_index<SortKey>>::iterator;
+		std::vector<key_index<SortKey>> buffer;
+		stable_sort_transform_impl<key_it, key_ptr, BinaryPredicate, SortKey>::
+		    inplace(keys.begin(), keys.end(), &key_index<SortKey>::key,
+		            std::move(compare), buffer);
+		return keys;
+	}
+
+	/**
+	 * @brief Stably sort data after applying an arbitrary transformation to
+	 * it. The primary template handles the general case of arbitrary
+	 * transformation and arbitrary compare predicate, with a buffered merge
+	 * sort.
+	 *
+	 * As in sort_transform_impl, keys computed by an arbitrary transformation
+	 * are cached once per element, and then stably sorted with their indices.
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate, typename SortKey, std::size_t small_size,
+	          bool trivial, bool F, bool R>
+	struct stable_sort_transform_impl {
+		using buffer_type = std::vector<
+		    typename std::iterator_traits<RandomAccessIt>::value_type>;
+
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, BinaryPredicate compare,
+		                    buffer_type& buffer) -> void {
+			auto comp = [&](const auto& a, const auto& b) {
+				return kblib::invoke(compare, kblib::invoke(transform, a),
+				                     kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else if (trivial) {
+				merge_sort<small_size>(begin, end, comp, buffer);
+			} else {
+				scratch(begin, end, std::move(transform), std::move(compare));
+			}
+		}
+
+		/**
+		 * @brief Stably sorts [begin, end) by keys cached in a scratch buffer,
+		 * then moves each element into place by following the cycles of the
+		 * resulting permutation.
+		 *
+		 * @remark Complexity: Θ(n) calls to transform, Θ(n) element moves, and
+		 * Θ(n) additional space for the keys and their indices.
+		 */
+		static auto scratch(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, BinaryPredicate compare)
+		    -> void {
+			const auto n = to_unsigned(end - begin);
+			auto keys = stably_sorted_keys<SortKey>(begin, end, transform,
+			                                        std::move(compare));
+			std::vector<std::size_t> perm(n);
+			for (auto i : range(n)) {
+				perm[i] = keys[i].index;
+			}
+			// Free the keys before the payloads start moving around
+			keys = {};
+			apply_permutation(begin, perm.begin(), n);
+		}
+	};
+
+	/**
+	 * @brief Stable sort implementation for pointer to member object of
+	 * integral, enumeration, or floating point type with default sorting. LSD
+	 * radix sort and counting sort are stable by construction. Below
+	 * radix_sort_cutoff, merge_sort is faster.
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
+	          typename SortKey, std::size_t small_size>
+	struct stable_sort_transform_impl<RandomAccessIt, UnaryOperation,
+	                                  std::less<LessT>, SortKey, small_size,
+	                                  true, true, true> {
+		using buffer_type = std::vector<
+		    typename std::iterator_traits<RandomAccessIt>::value_type>;
+
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::less<LessT> compare,
+		                    buffer_type& buffer) -> void {
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else if (to_unsigned(end - begin) < radix_sort_cutoff) {
+				merge_sort<small_size>(begin, end, comp, buffer);
+			} else {
+				radix_sort_i<sort_direction::ascending>(
+				    begin, end,
+				    [&](const auto& v) {
+					    return radix_key(SortKey(kblib::invoke(transform, v)));
+				    },
+				    buffer);
+			}
+		}
+	};
+	/**
+	 * @brief Stable sort implementation for pointer to member object of
+	 * integral, enumeration, or floating point type with reverse sorting.
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
+	          typename SortKey, std::size_t small_size>
+	struct stable_sort_transform_impl<RandomAccessIt, UnaryOperation,
+	                                  std::greater<LessT>, SortKey, small_size,
+	                                  true, true, true> {
+		using buffer_type = std::vector<
+		    typename std::iterator_traits<RandomAccessIt>::value_type>;
+
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::greater<LessT> compare,
+		                    buffer_type& buffer) -> void {
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			if (to_unsigned(end - begin) < small_size) {
+				insertion_sort(begin, end, comp);
+			} else if (to_unsigned(end - begin) < radix_sort_cutoff) {
+				merge_sort<small_size>(begin, end, comp, buffer);
+			} else {
+				radix_sort_i<sort_direction::descending>(
+				    begin, end,
+				    [&](const auto& v) {
+					    return radix_key(SortKey(kblib::invoke(transform, v)));
+				    },
+				    buffer);
+			}
+		}
+	};
+
+	/**
+	 * @brief Stable sort implementation for pointer to member object of radix
+	 * sortable container type with default sorting
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
+	          typename SortKey, std::size_t small_size>
+	struct stable_sort_transform_impl<RandomAccessIt, UnaryOperation,
+	                                  std::less<LessT>, SortKey, small_size,
+	                                  true, false, true> {
+		using buffer_type = std::vector<
+		    typename std::iterator_traits<RandomAccessIt>::value_type>;
+
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::less<LessT> compare,
+		                    buffer_type& buffer) -> void {
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			stable_string_sort<sort_direction::ascending, small_size>(
+			    begin, end,
+			    [&](const auto& v) -> decltype(auto) {
+				    return kblib::invoke(transform, v);
+			    },
+			    comp, buffer, is_linear_container<SortKey>{});
+		}
+	};
+	/**
+	 * @brief Stable sort implementation for pointer to member object of radix
+	 * sortable container type with reverse sorting
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation, typename LessT,
+	          typename SortKey, std::size_t small_size>
+	struct stable_sort_transform_impl<RandomAccessIt, UnaryOperation,
+	                                  std::greater<LessT>, SortKey, small_size,
+	                                  true, false, true> {
+		using buffer_type = std::vector<
+		    typename std::iterator_traits<RandomAccessIt>::value_type>;
+
+		static auto inplace(RandomAccessIt begin, const RandomAccessIt end,
+		                    UnaryOperation transform, std::greater<LessT> compare,
+		                    buffer_type& buffer) -> void {
+			auto comp = [&](const auto& a, const auto& b) {
+				return compare(kblib::invoke(transform, a),
+				               kblib::invoke(transform, b));
+			};
+			stable_string_sort<sort_direction::descending, small_size>(
+			    begin, end,
+			    [&](const auto& v) -> decltype(auto) {
+				    return kblib::invoke(transform, v);
+			    },
+			    comp, buffer, is_linear_container<SortKey>{});
+		}
+	};
+
+	/**
+	 * @brief Writes the stable sorted order of [begin, end) into perm as the
+	 * indices of the elements, without moving the elements themselves.
+	 */
+	template <typename RandomAccessIt, typename UnaryOperation,
+	          typename BinaryPredicate, typename Index>
+	auto sort_permutation(RandomAccessIt begin, const RandomAccessIt end,
+	                      UnaryOperation transform, BinaryPredicate compare,
+	                      std::vector<Index>& perm) -> void {
+		static_assert(std::is_integral<Index>::value,
+		              "permutation indices must be integral");
+		const auto n = to_unsigned(end - begin);
+		if (n > 0 and n - 1 > to_unsigned(std::numeric_limits<Index>::max())) {
+			throw std::length_error("range too long for permutation index type");
+		}
+		auto keys = stably_sorted_keys<sort_key_t<RandomAccessIt, UnaryOperation>>(
+		    begin, end, transform, std::move(compare));
+		perm.resize(n);
+		for (auto i : range(n)) {
+			perm[i] = static_cast<Index>(keys[i].index);
+		}
+	}
+
+	/**
+	 * @brief Reorders [begin, begin + n) so that the element at position i is
+	 * the one which was at position perm[i]. Unlike apply_permutation, perm is
+	 * not modified; finished positions are tracked in done instead.
+	 */
+	template <typename RandomAccessIt, typename IndexIt>
+	auto permute_column(RandomAccessIt begin, IndexIt perm, std::size_t n,
+	                    std::vector<bool>& done) -> void {
+		done.assign(n, false);
+		for (auto i : range(n)) {
+			if (done[i]) {
+				continue;
+			}
+			auto j = static_cast<std::size_t>(perm[to_signed(i)]);
+			if (j == i) {
+				continue;
+			}
+			auto tmp = std::move(begin[to_signed(i)]);
+			auto hole = i;
+			while (j != i) {
+				begin[to_signed(hole)] = std::move(begin[to_signed(j)]);
+				done[hole] = true;
+				hole = j;
+				j = static_cast<std::size_t>(perm[to_signed(j)]);
+			}
+			begin[to_signed(hole)] = std::move(tmp);
+			done[hole] = true;
+		}
+	}
+
+	template <typename IndexIt>
+	auto permute_columns(IndexIt, std::size_t, std::vector<bool>&) -> void {}
+
+	/**
+	 * @brief Applies permute_column to each column in turn, sharing done
+	 * between them.
+	 */
+	template <typename IndexIt, typename RandomAccessIt, typename... Columns>
+	auto permute_columns(IndexIt perm, std::size_t n, std::vector<bool>& done,
+	                     RandomAccessIt column, Columns... columns) -> void {
+		permute_column(column, perm, n, done);
+		permute_columns(perm, n, done, columns...);
+	}
+} // namespace detail_sort
+
+/**
+ * @namespace kblib::execution
+ * @brief Execution policies for the parallel overloads of the sorting
+ * algorithms.
+ *
+ * These are distinct from the std::execution policies so that using them
+ * does not require a parallel backend such as TBB.
+ */
+namespace execution {
+
+	/**
+	 * @brief Requests that the algorithm run on the calling thread only.
+	 */
+	struct sequenced_policy {};
+
+	/**
+	 * @brief Requests that the algorithm split its work across threads.
+	 */
+	struct parallel_policy {
+		/**
+		 * @brief The number of threads to use, including the calling thread. 0
+		 * means to use std::thread::hardware_concurrency() threads, or fewer if
+		 * the input is too small to be worth splitting.
+		 */
+		std::size_t threads{};
+	};
+
+	KBLIB_CONSTANT sequenced_policy seq{};
+	KBLIB_CONSTANT parallel_policy par{};
+
+} // namespace execution
+
+/**
+ * @brief Detects execution policy types, to disambiguate the parallel
+ * overloads of algorithms.
+ */
+template <typename T>
+struct is_execution_policy : std::false_type {};
+template <>
+struct is_execution_policy<execution::sequenced_policy> : std::true_type {};
+template <>
+struct is_execution_policy<execution::parallel_policy> : std::true_type {};
+
+template <typename T>
+constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+namespace detail_sort {
+
+	/**
+	 * @brief When the thread count is chosen automatically, each thread is
+	 * given at least this many elements to sort.
+	 */
+	KBLIB_CONSTANT std::size_t parallel_sort_grain = std::size_t{1} << 16u;
+
+	inline auto parallel_sort_threads(execution::sequenced_policy, std::size_t)
+	    -> std::size_t {
+		return 1;
+	}
+	inline auto parallel_sort_threads(execution::parallel_policy policy,
+	                                  std::size_t n) -> std::size_t {
+		if (policy.threads != 0) {
+			return std::max(std::size_t{1}, std::min(policy.threads, n));
+		}
+		const auto hw = std::size_t{std::thread::hardware_concurrency()};
+		return std::max(std::size_t{1}, std::min(hw, n / parallel_sort_grain));
+	}
+
+	/**
+	 * @brief Calls f(t) for every t in [0, threads), each on its own thread
+	 * (the calling thread runs f(0)), and waits for all of them to finish.
+	 *
+	 * If any of the calls throws, the first such exception is rethrown after
+	 * all threads have been joined. If a thread cannot be started, its call is
+	 * made on the calling thread instead.
+	 */
+	template <typename F>
+	auto fork_join(std::size_t threads, F f) -> void {
+		std::vector<std::exception_ptr> errors(threads);
+		auto run = [&](std::size_t t) {
+			try {
+				f(t);
+			} catch (...) {
+				errors[t] = std::current_exception();
+			}
+		};
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+		for (auto t : range(std::size_t{1}, threads)) {
+			try {
+				workers.emplace_back(run, t);
+			} catch (const std::system_error&) {
+				run(t);
+			}
+		}
+		run(0);
+		for (auto& w : workers) {
+			w.join();
+		}
+		for (auto& e : errors) {
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+	}
+
+	/**
+	 * @brief A tree of losers, for merging k sorted sources with log2(k)
+	 * comparisons per element.
+	 *
+	 * @tparam Beats A predicate on source indices which returns true if the
+	 * head of the first source must be output before the head of the second.
+	 * An exhausted source must lose to every other source.
+	 */
+	template <typename Beats>
+	class loser_tree {
+	 public:
+		loser_tree(std::size_t k, Beats beats)
+		    : k_(k)
+		    , nodes_(std::max(k, std::size_t{1}))
+		    , beats_(std::move(beats)) {
+			nodes_[0] = (k_ > 1) ? build(1) : 0;
+		}
+
+		/**
+		 * @brief The source whose head is next in the merged order.
+		 */
+		KBLIB_NODISCARD auto top() const noexcept -> std::size_t {
+			return nodes_[0];
+		}
+
+		/**
+		 * @brief Restores the tournament after the head of top() has changed.
+		 */
+		auto replay() -> void {
+			auto winner = nodes_[0];
+			for (auto n = (winner + k_) / 2; n > 0; n /= 2) {
+				if (beats_(nodes_[n], winner)) {
+					std::swap(nodes_[n], winner);
+				}
+			}
+			nodes_[0] = winner;
+		}
+
+	 private:
+		// Leaves are numbered [k, 2k), internal nodes [1, k)
+		auto build(std::size_t n) -> std::size_t {
+			if (n >= k_) {
+				return n - k_;
+			}
+			const auto a = build(2 * n);
+			const auto b = build(2 * n + 1);
+			if (beats_(a, b)) {
+				nodes_[n] = b;
+				return a;
+			} else {
+				nodes_[n] = a;
+				return b;
+			}
+		}
+
+		std::size_t k_;
+		std::vector<std::size_t> nodes_;
+		Beats beats_;
+	};
+
+	/**
+	 * @brief Finds how many elements of each sorted run precede the element of
+	 * rank r in the merged order of all runs, where equivalent elements are
+	 * ordered by the index of their run.
+	 *
+	 * Run m is [begin + bounds[m], begin + bounds[m + 1]).
+	 *
+	 * @remark Complexity: O(p^2 log^2(n)) comparisons for p runs.
+	 */
+	template <typename RandomAccessIt, typename Compare>
+	auto multiway_split(RandomAccessIt begin,
+	                    const std::vector<std::size_t>& bounds, std::size_t r,
+	                    Compare& comp) -> std::vector<std::size_t> {
+		const auto p = bounds.size() - 1;
+		std::vector<std::size_t> lo(p);
+		std::vector<std::size_t> hi(p);
+		for (auto m : range(p)) {
+			hi[m] = bounds[m + 1] - bounds[m];
+		}
+		std::vector<std::size_t> split(p);
+		while (true) {
+			// Bisect the run with the most uncertainty left
+			auto j = p;
+			std::size_t widest{};
+			for (auto m : range(p)) {
+				if (hi[m] - lo[m] > widest) {
+					widest = hi[m] - lo[m];
+					j = m;
+				}
+			}
+			if (j == p) {
+				return lo;
+			}
+			const auto i = lo[j] + widest / 2;
+			const auto& pivot = begin[to_signed(bounds[j] + i)];
+
+			std::size_t rank{};
+			for (auto m : range(p)) {
+				const auto first = begin + to_signed(bounds[m]);
+				const auto last = begin + to_signed(bounds[m + 1]);
+				if (m < j) {
+					split[m] = to_unsigned(std::upper_bound(first, last, pivot, comp)
+					                       - first);
+				} else if (m > j) {
+					split[m] = to_unsigned(std::lower_bound(first, last, pivot, comp)
+					                       - first);
+				} else {
+					split[m] = i;
+				}
+				rank += split[m];
+			}
+
+			if (rank == r) {
+				return split;
+			} else if (rank > r) {
+				for (auto m : range(p)) {
+					hi[m] = std::min(hi[m], split[m]);
+				}
+			} else {
+				for (auto m : range(p)) {
+					lo[m] = std::max(lo[m], split[m]);
+				}
+				lo[j] = std::max(lo[j], i + 1);
+			}
+		}
+	}
+
+	/**
+	 * @brief Sorts [begin, end) by splitting it into one run per thread,
+	 * sorting each run with sort_chunk, and then merging the runs with a
+	 * parallel multiway merge.
+	 *
+	 * Each thread merges an equal share of the output, whose sources are found
+	 * by multiway_split, through a loser_tree into uninitialized scratch
+	 * memory. The result is then moved back into the range in parallel.
+	 */
+	template <typename RandomAccessIt, typename Compare, typename SortChunk>
+	auto parallel_sort(RandomAccessIt begin, const RandomAccessIt end,
+	                   Compare comp, SortChunk sort_chunk, std::size_t threads)
+	    -> void {
+		using value_type =
+		    typename std::iterator_traits<RandomAccessIt>::value_type;
+		const auto n = to_unsigned(end - begin);
+		// Elements are moved into and out of the scratch space with no way to
+		// recover from a throwing move
+		constexpr bool nothrow_movable
+		    = std::is_nothrow_move_constructible<value_type>::value
+		      and std::is_nothrow_move_assignable<value_type>::value;
+		if (not nothrow_movable or threads < 2 or n < 2) {
+			sort_chunk(begin, end);
+			return;
+		}
+		std::vector<std::size_t> bounds(threads + 1);
+		for (auto t : range(threads + 1)) {
+			bounds[t] = n * t / threads;
+		}
+		fork_join(threads, [&](std::size_t t) {
+			sort_chunk(begin + to_signed(bounds[t]),
+			           begin + to_signed(bounds[t + 1]));
+		});
+
+		std::allocator<value_type> alloc;
+		const auto deleter = [&](value_type* p) { alloc.deallocate(p, n); };
+		std::unique_ptr<value_type, decltype(deleter)> scratch(alloc.allocate(n),
+		                                                       deleter);
+		// All splits must be found before any thread starts moving elements out
+		// of the runs
+		std::vector<std::vector<std::size_t>> splits(threads + 1);
+		splits.front().assign(threads, 0);
+		for (auto m : range(threads)) {
+			splits.back().push_back(bounds[m + 1] - bounds[m]);
+		}
+		fork_join(threads - 1, [&](std::size_t t) {
+			splits[t + 1] = multiway_split(begin, bounds, bounds[t + 1], comp);
+		});
+
+		std::vector<std::size_t> written(threads);
+		auto merge = [&](std::size_t t) {
+			std::vector<RandomAccessIt> heads(threads);
+			std::vector<RandomAccessIt> tails(threads);
+			for (auto m : range(threads)) {
+				heads[m] = begin + to_signed(bounds[m] + splits[t][m]);
+				tails[m] = begin + to_signed(bounds[m] + splits[t + 1][m]);
+			}
+			auto beats = [&](std::size_t a, std::size_t b) {
+				if (heads[a] == tails[a]) {
+					return false;
+				} else if (heads[b] == tails[b]) {
+					return true;
+				} else if (comp(*heads[b], *heads[a])) {
+					return false;
+				} else {
+					return comp(*heads[a], *heads[b]) or a < b;
+				}
+			};
+			loser_tree<decltype(beats)> tree(threads, beats);
+			for (auto i : range(bounds[t], bounds[t + 1])) {
+				const auto s = tree.top();
+				::new (static_cast<void*>(scratch.get() + i))
+				    value_type(std::move(*heads[s]++));
+				++written[t];
+				tree.replay();
+			}
+		};
+		try {
+			fork_join(threads, merge);
+		} catch (...) {
+			for (auto t : range(threads)) {
+				for (auto i : range(bounds[t], bounds[t] + written[t])) {
+					scratch.get()[i].~value_type();
+				}
+			}
+			throw;
+		}
+		fork_join(threads, [&](std::size_t t) {
+			for (auto i : range(bounds[t], bounds[t + 1])) {
+				begin[to_signed(i)] = std::move(scratch.get()[i]);
+				scratch.get()[i].~value_type();
+			}
+		});
+	}
+
+} // namespace detail_sort
+
+/**
+ * @brief Sorts a range after applying a transformation.
+ *
+ * Complexity: worst-case O(N log(N)), where N = std::distance(begin, end)
+ * comparisons and swaps.
+ *
+ * @param begin,end The range to sort
+ * @param transform A transformer (such as unary function or pointer to
+ * member) which will be applied to each object before comparing it. A
+ * transformer may not modify the object it is called with.
+ *
+ * @param compare A comparison predicate which returns true if the first
+ * argument shall be ordered before the second. BinaryPredicate must meet the
+ * requirements of the Compare named requirement.
+ */
+template <typename RandomAccessIt, typename UnaryOperation,
+          typename BinaryPredicate>
+constexpr auto sort_transform(RandomAccessIt begin, RandomAccessIt end,
+                              UnaryOperation transform,
+                              BinaryPredicate compare) -> void {
 	detail_sort::sort_transform_impl<
 	    RandomAccessIt, UnaryOperation, BinaryPredicate,
-	    decltype(kblib::invoke(transform, *begin))>::
-	    inplace(begin, end, std::forward<UnaryOperation>(transform),
-	            std::forward<BinaryPredicate>(compare));
+	    detail_sort::sort_key_t<RandomAccessIt, UnaryOperation>>::
+	    inplace(begin, end, std::move(transform), std::move(compare));
 }
 
 /**
- * @brief
+ * @brief Sorts a range after applying a transformation, in ascending order.
  *
  * @param begin,end The range to sort
  * @param transform The transformation to apply
  */
 template <typename RandomAccessIt, typename UnaryOperation>
 constexpr auto sort_transform(RandomAccessIt begin, RandomAccessIt end,
-                              UnaryOperation&& transform) -> void {
+                              UnaryOperation transform) -> void {
 	detail_sort::sort_transform_impl<
 	    RandomAccessIt, UnaryOperation, std::less<>,
-	    decltype(kblib::invoke(transform,
-	                           *begin))>::inplace(begin, end,
-	                                              std::forward<UnaryOperation>(
-	                                                  transform),
-	                                              std::less<>{});
+	    detail_sort::sort_key_t<RandomAccessIt, UnaryOperation>>::
+	    inplace(begin, end, std::move(transform), std::less<>{});
 }
 
 /**
@@ -713,17 +2099,15 @@ constexpr auto sort_transform(RandomAccessIt begin, RandomAccessIt end,
  */
 template <typename RandomAccessIt, typename BinaryPredicate>
 constexpr auto sort(RandomAccessIt begin, RandomAccessIt end,
-                    BinaryPredicate&& compare) -> void {
+                    BinaryPredicate compare) -> void {
 	detail_sort::sort_transform_impl<
 	    RandomAccessIt, identity, BinaryPredicate,
-	    decltype(kblib::invoke(transform,
-	                           *begin))>::inplace(begin, end, identity{},
-	                                              std::forward<BinaryPredicate>(
-	                                                  compare));
+	    detail_sort::sort_key_t<RandomAccessIt, identity>>::
+	    inplace(begin, end, identity{}, std::move(compare));
 }
 
 /**
- * @brief
+ * @brief Sorts a range in ascending order.
  *
  * @param begin,end The range to sort
  */
@@ -731,9 +2115,325 @@ template <typename RandomAccessIt>
 constexpr auto sort(RandomAccessIt begin, RandomAccessIt end) -> void {
 	detail_sort::sort_transform_impl<
 	    RandomAccessIt, identity, std::less<>,
-	    decltype(kblib::invoke(transform, *begin))>::inplace(begin, end,
-	                                                         identity{},
-	                                                         std::less<>{});
+	    detail_sort::sort_key_t<RandomAccessIt, identity>>::
+	    inplace(begin, end, identity{}, std::less<>{});
+}
+
+/**
+ * @brief Sorts a range after applying a transformation, preserving the
+ * relative order of elements with equivalent keys.
+ *
+ * Integral, enumeration, floating point, and string keys compared by
+ * std::less or std::greater are radix sorted, which is stable by
+ * construction. Other keys are sorted by a buffered merge sort.
+ *
+ * Complexity: worst-case O(N log(N)), where N = std::distance(begin, end)
+ * comparisons and moves, and O(N) additional space.
+ *
+ * @param begin,end The range to sort
+ * @param transform A transformer (such as unary function or pointer to
+ * member) which will be applied to each object before comparing it. A
+ * transformer may not modify the object it is called with.
+ * @param compare A comparison predicate which returns true if the first
+ * argument shall be ordered before the second. BinaryPredicate must meet the
+ * requirements of the Compare named requirement.
+ * @param buffer Caller-owned scratch space for the elements. Its contents
+ * afterwards are unspecified, but its capacity is kept, so reusing it for
+ * repeated sorts avoids reallocating it.
+ */
+template <typename RandomAccessIt, typename UnaryOperation,
+          typename BinaryPredicate>
+auto stable_sort_transform(
+    RandomAccessIt begin, RandomAccessIt end, UnaryOperation transform,
+    BinaryPredicate compare,
+    std::vector<typename std::iterator_traits<RandomAccessIt>::value_type>&
+        buffer) -> void {
+	detail_sort::stable_sort_transform_impl<
+	    RandomAccessIt, UnaryOperation, BinaryPredicate,
+	    detail_sort::sort_key_t<RandomAccessIt, UnaryOperation>>::
+	    inplace(begin, end, std::move(transform), std::move(compare), buffer);
+}
+
+/**
+ * @brief Sorts a range after applying a transformation, preserving the
+ * relative order of elements with equivalent keys.
+ *
+ * @param begin,end The range to sort
+ * @param transform The transformation to apply
+ * @param compare The comparison predicate
+ */
+template <typename RandomAccessIt, typename UnaryOperation,
+          typename BinaryPredicate>
+auto stable_sort_transform(RandomAccessIt begin, RandomAccessIt end,
+                           UnaryOperation transform, BinaryPredicate compare)
+    -> void {
+	std::vector<typename std::iterator_traits<RandomAccessIt>::value_type>
+	    buffer;
+	kblib::stable_sort_transform(begin, end, std::move(transform),
+	                             std::move(compare), buffer);
+}
+
+/**
+ * @brief Sorts a range after applying a transformation, in ascending order,
+ * preserving the relative order of elements with equivalent keys.
+ *
+ * @param begin,end The range to sort
+ * @param transform The transformation to apply
+ */
+template <typename RandomAccessIt, typename UnaryOperation>
+auto stable_sort_transform(RandomAccessIt begin, RandomAccessIt end,
+                           UnaryOperation transform) -> void {
+	kblib::stable_sort_transform(begin, end, std::move(transform),
+	                             std::less<>{});
+}
+
+/**
+ * @brief Sorts a range, preserving the relative order of equivalent
+ * elements.
+ *
+ * @param begin,end The range to sort
+ * @param compare The comparison predicate
+ * @param buffer Caller-owned scratch space, as for stable_sort_transform
+ */
+template <typename RandomAccessIt, typename BinaryPredicate>
+auto stable_sort(
+    RandomAccessIt begin, RandomAccessIt end, BinaryPredicate compare,
+    std::vector<typename std::iterator_traits<RandomAccessIt>::value_type>&
+        buffer) -> void {
+	kblib::stable_sort_transform(begin, end, identity{}, std::move(compare),
+	                             buffer);
+}
+
+/**
+ * @brief Sorts a range, preserving the relative order of equivalent
+ * elements.
+ *
+ * @param begin,end The range to sort
+ * @param compare The comparison predicate
+ */
+template <typename RandomAccessIt, typename BinaryPredicate>
+auto stable_sort(RandomAccessIt begin, RandomAccessIt end,
+                 BinaryPredicate compare) -> void {
+	kblib::stable_sort_transform(begin, end, identity{}, std::move(compare));
+}
+
+/**
+ * @brief Sorts a range in ascending order, preserving the relative order of
+ * equivalent elements.
+ *
+ * @param begin,end The range to sort
+ */
+template <typename RandomAccessIt>
+auto stable_sort(RandomAccessIt begin, RandomAccessIt end) -> void {
+	kblib::stable_sort_transform(begin, end, identity{}, std::less<>{});
+}
+
+/**
+ * @brief Computes the permutation which would sort a range after applying a
+ * transformation, without moving any of its elements. This is useful when
+ * the elements are expensive to move, or when several parallel arrays must
+ * be reordered together.
+ *
+ * Each key is computed once and sorted together with its index, so radix
+ * sortable keys are radix sorted. The permutation is stable: equivalent
+ * elements appear in their original order.
+ *
+ * @param begin,end The range to sort
+ * @param transform A transformer which will be applied to each object
+ * before comparing it
+ * @param compare A comparison predicate which returns true if the first
+ * argument shall be ordered before the second
+ * @param perm Receives the permutation: perm[i] is the index in [begin, end)
+ * of the element which sorts into position i. It is resized to fit, so
+ * reusing it avoids reallocating.
+ * @throws std::length_error if the indices of the range do not fit in Index
+ */
+template <typename RandomAccessIt, typename UnaryOperation,
+          typename BinaryPredicate, typename Index>
+auto sort_permutation_transform(RandomAccessIt begin, RandomAccessIt end,
+                                UnaryOperation transform,
+                                BinaryPredicate compare,
+                                std::vector<Index>& perm) -> void {
+	detail_sort::sort_permutation(begin, end, std::move(transform),
+	                              std::move(compare), perm);
+}
+
+/**
+ * @brief Computes the permutation which would sort a range after applying a
+ * transformation.
+ *
+ * @tparam Index The index type of the permutation
+ * @param begin,end The range to sort
+ * @param transform The transformation to apply
+ * @param compare The comparison predicate
+ * @return The sorting permutation, as for the overload taking perm.
+ */
+template <typename Index = std::uint32_t, typename RandomAccessIt,
+          typename UnaryOperation, typename BinaryPredicate>
+auto sort_permutation_transform(RandomAccessIt begin, RandomAccessIt end,
+                                UnaryOperation transform,
+                                BinaryPredicate compare) -> std::vector<Index> {
+	std::vector<Index> perm;
+	detail_sort::sort_permutation(begin, end, std::move(transform),
+	                              std::move(compare), perm);
+	return perm;
+}
+
+/**
+ * @brief Computes the permutation which would sort a range after applying a
+ * transformation, in ascending order.
+ *
+ * @tparam Index The index type of the permutation
+ * @param begin,end The range to sort
+ * @param transform The transformation to apply
+ */
+template <typename Index = std::uint32_t, typename RandomAccessIt,
+          typename UnaryOperation>
+auto sort_permutation_transform(RandomAccessIt begin, RandomAccessIt end,
+                                UnaryOperation transform)
+    -> std::vector<Index> {
+	return kblib::sort_permutation_transform<Index>(
+	    begin, end, std::move(transform), std::less<>{});
+}
+
+/**
+ * @brief Computes the permutation which would sort a range.
+ *
+ * @tparam Index The index type of the permutation
+ * @param begin,end The range to sort
+ * @param compare The comparison predicate
+ */
+template <typename Index = std::uint32_t, typename RandomAccessIt,
+          typename BinaryPredicate>
+auto sort_permutation(RandomAccessIt begin, RandomAccessIt end,
+                      BinaryPredicate compare) -> std::vector<Index> {
+	return kblib::sort_permutation_transform<Index>(begin, end, identity{},
+	                                                std::move(compare));
+}
+
+/**
+ * @brief Computes the permutation which would sort a range in ascending
+ * order.
+ *
+ * @tparam Index The index type of the permutation
+ * @param begin,end The range to sort
+ */
+template <typename Index = std::uint32_t, typename RandomAccessIt>
+auto sort_permutation(RandomAccessIt begin, RandomAccessIt end)
+    -> std::vector<Index> {
+	return kblib::sort_permutation_transform<Index>(begin, end, identity{},
+	                                                std::less<>{});
+}
+
+/**
+ * @brief Reorders one or more parallel arrays in place, so that position i
+ * of each holds the element which was at position perm[i], as computed by
+ * sort_permutation.
+ *
+ * Each array is permuted by following the cycles of the permutation, so
+ * every element is moved only once.
+ *
+ * @param p_begin,p_end The permutation. It must contain each index in
+ * [0, p_end - p_begin) exactly once.
+ * @param column,columns The beginnings of the arrays to reorder, each of
+ * which must have at least p_end - p_begin elements.
+ */
+template <typename IndexIt, typename RandomAccessIt, typename... Columns>
+auto apply_permutation(IndexIt p_begin, IndexIt p_end, RandomAccessIt column,
+                       Columns... columns) -> void {
+	std::vector<bool> done;
+	detail_sort::permute_columns(p_begin, to_unsigned(p_end - p_begin), done,
+	                             column, columns...);
+}
+
+/**
+ * @brief Sorts a range after applying a transformation, splitting the work
+ * across threads as requested by policy.
+ *
+ * Each thread sorts a contiguous part of the range the same way as the
+ * sequential sort_transform, and the sorted parts are then combined by a
+ * parallel multiway merge. Elements whose move operations may throw are
+ * always sorted sequentially.
+ *
+ * Complexity: O(N log(N)) comparisons in total, and O(N) additional space.
+ *
+ * @param policy The execution policy, such as kblib::execution::par
+ * @param begin,end The range to sort
+ * @param transform A transformer which will be applied to each object before
+ * comparing it. It may be called concurrently from multiple threads.
+ * @param compare A comparison predicate which returns true if the first
+ * argument shall be ordered before the second. It may be called concurrently
+ * from multiple threads.
+ */
+template <typename ExecutionPolicy, typename RandomAccessIt,
+          typename UnaryOperation, typename BinaryPredicate>
+auto sort_transform(ExecutionPolicy&& policy, RandomAccessIt begin,
+                    RandomAccessIt end, UnaryOperation transform,
+                    BinaryPredicate compare)
+    -> enable_if_t<is_execution_policy_v<decay_t<ExecutionPolicy>>> {
+	using impl = detail_sort::sort_transform_impl<
+	    RandomAccessIt, UnaryOperation, BinaryPredicate,
+	    detail_sort::sort_key_t<RandomAccessIt, UnaryOperation>>;
+	detail_sort::parallel_sort(
+	    begin, end,
+	    [&](const auto& a, const auto& b) {
+		    return kblib::invoke(compare, kblib::invoke(transform, a),
+		                         kblib::invoke(transform, b));
+	    },
+	    [&](RandomAccessIt first, RandomAccessIt last) {
+		    impl::inplace(first, last, transform, compare);
+	    },
+	    detail_sort::parallel_sort_threads(policy, to_unsigned(end - begin)));
+}
+
+/**
+ * @brief Sorts a range after applying a transformation, in ascending order,
+ * splitting the work across threads as requested by policy.
+ *
+ * @param policy The execution policy, such as kblib::execution::par
+ * @param begin,end The range to sort
+ * @param transform The transformation to apply
+ */
+template <typename ExecutionPolicy, typename RandomAccessIt,
+          typename UnaryOperation>
+auto sort_transform(ExecutionPolicy&& policy, RandomAccessIt begin,
+                    RandomAccessIt end, UnaryOperation transform)
+    -> enable_if_t<is_execution_policy_v<decay_t<ExecutionPolicy>>> {
+	kblib::sort_transform(std::forward<ExecutionPolicy>(policy), begin, end,
+	                      std::move(transform), std::less<>{});
+}
+
+/**
+ * @brief Sorts a range, splitting the work across threads as requested by
+ * policy.
+ *
+ * @param policy The execution policy, such as kblib::execution::par
+ * @param begin,end The range to sort
+ * @param compare A comparison predicate which returns true if the first
+ * argument shall be ordered before the second. It may be called concurrently
+ * from multiple threads.
+ */
+template <typename ExecutionPolicy, typename RandomAccessIt,
+          typename BinaryPredicate>
+auto sort(ExecutionPolicy&& policy, RandomAccessIt begin, RandomAccessIt end,
+          BinaryPredicate compare)
+    -> enable_if_t<is_execution_policy_v<decay_t<ExecutionPolicy>>> {
+	kblib::sort_transform(std::forward<ExecutionPolicy>(policy), begin, end,
+	                      identity{}, std::move(compare));
+}
+
+/**
+ * @brief Sorts a range in ascending order, splitting the work across threads
+ * as requested by policy.
+ *
+ * @param policy The execution policy, such as kblib::execution::par
+ * @param begin,end The range to sort
+ */
+template <typename ExecutionPolicy, typename RandomAccessIt>
+auto sort(ExecutionPolicy&& policy, RandomAccessIt begin, RandomAccessIt end)
+    -> enable_if_t<is_execution_policy_v<decay_t<ExecutionPolicy>>> {
+	kblib::sort_transform(std::forward<ExecutionPolicy>(policy), begin, end,
+	                      identity{}, std::less<>{});
 }
 
 } // namespace KBLIB_NS
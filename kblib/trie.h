@@ -38,10 +38,38 @@
 #	include "sort.h"
 #	include "traits.h"
 
+#	include <algorithm>
 #	include <array>
-#	include <bitset>
+#	include <cstdint>
+#	include <cstring>
+#	include <iterator>
+#	include <limits>
+#	include <memory>
+#	include <new>
+#	include <optional>
+#	include <ostream>
+#	include <stdexcept>
+#	include <tuple>
+#	include <utility>
 #	include <vector>
 
+/**
+ * @def KBLIB_SPARSE_TRIE_SSE2
+ * @brief Whether sparse tries search the keys of 16-way nodes with SSE2, all
+ * at once, or one at a time. Defaults to SSE2 where it is available.
+ */
+#	ifndef KBLIB_SPARSE_TRIE_SSE2
+#		if defined(__SSE2__) or defined(_M_X64) \
+		    or (defined(_M_IX86_FP) and _M_IX86_FP >= 2)
+#			define KBLIB_SPARSE_TRIE_SSE2 1
+#		else
+#			define KBLIB_SPARSE_TRIE_SSE2 0
+#		endif
+#	endif
+#	if KBLIB_SPARSE_TRIE_SSE2
+#		include <emmintrin.h>
+#	endif
+
 namespace KBLIB_NS {
 
 enum class extractor_policy {
@@ -139,27 +167,31 @@ class trie<KeyElem[], T, Extractor, false> {};
 template <typename Key, typename = void>
 struct default_extract;
 
+// Key elements index rows as unsigned values, so that a signed char key
+// element has 256 slots, not 128, and keys are ordered as std::string orders
+// them.
 template <typename Key>
 struct default_extract<Key, void_if_t<is_linear_container_v<Key>>> {
 	using value_type = typename Key::value_type;
-	static_assert(static_cast<value_type>(max) < static_cast<std::size_t>(max),
+	static_assert(std::is_integral<value_type>::value,
+	              "Key elements must be integral");
+	static_assert(static_cast<std::make_unsigned_t<value_type>>(max)
+	                  < static_cast<std::size_t>(max),
 	              "Key too large to index array");
 	// won't overflow because of above assertion
 	KBLIB_CONSTANT_M std::size_t key_cardinality
-	    = static_cast<value_type>(max) + std::size_t{1};
-	static_assert(std::is_integral<value_type>::value,
-	              "Key elements must be integral");
+	    = static_cast<std::make_unsigned_t<value_type>>(max) + std::size_t{1};
 
-	KBLIB_NODISCARD static constexpr auto begin(Key& key) noexcept(
+	KBLIB_NODISCARD static constexpr auto begin(const Key& key) noexcept(
 	    noexcept(key.begin())) -> decltype(auto) {
 		return key.begin();
 	}
-	KBLIB_NODISCARD static constexpr auto end(Key& key) noexcept(
+	KBLIB_NODISCARD static constexpr auto end(const Key& key) noexcept(
 	    noexcept(key.end())) -> decltype(auto) {
 		return key.end();
 	}
 	KBLIB_NODISCARD static constexpr auto index(
-	    Key& key, std::size_t idx) noexcept(noexcept(key[idx]))
+	    const Key& key, std::size_t idx) noexcept(noexcept(key[idx]))
 	    -> decltype(auto) {
 		return key[idx];
 	}
@@ -168,34 +200,601 @@ struct default_extract<Key, void_if_t<is_linear_container_v<Key>>> {
 template <typename KeyElem>
 struct default_extract<KeyElem[], void_if_t<std::is_integral_v<KeyElem>>> {
 	using value_type = KeyElem;
-	static_assert(static_cast<value_type>(max) < static_cast<std::size_t>(max),
+	static_assert(static_cast<std::make_unsigned_t<value_type>>(max)
+	                  < static_cast<std::size_t>(max),
 	              "Key too large to index array");
 	// won't overflow because of above assertion
 	KBLIB_CONSTANT_M std::size_t key_cardinality
-	    = static_cast<value_type>(max) + std::size_t{1};
-	static_assert(std::is_integral<value_type>::value,
-	              "Key elements must be integral");
+	    = static_cast<std::make_unsigned_t<value_type>>(max) + std::size_t{1};
 
 	template <std::size_t Size>
-	KBLIB_NODISCARD static constexpr auto begin(KeyElem (&key)[Size]) noexcept(
-	    noexcept(std::begin(key))) -> decltype(auto) {
+	KBLIB_NODISCARD static constexpr auto begin(
+	    const KeyElem (&key)[Size]) noexcept(noexcept(std::begin(key)))
+	    -> decltype(auto) {
 		return std::begin(key);
 	}
 	template <std::size_t Size>
-	KBLIB_NODISCARD static constexpr auto end(KeyElem (&key)[Size]) noexcept(
+	KBLIB_NODISCARD static constexpr auto end(const KeyElem (&key)[Size]) noexcept(
 	    noexcept(std::end(key))) -> decltype(auto) {
 		return std::end(key);
 	}
 	template <std::size_t Size>
 	KBLIB_NODISCARD static constexpr auto index(
-	    KeyElem (&key)[Size], std::size_t idx) noexcept(noexcept(key[idx]))
+	    const KeyElem (&key)[Size],
+	    std::size_t idx) noexcept(noexcept(key[idx]))
 	    -> decltype(auto) {
 		return key[idx];
 	}
 };
 
 template <typename Key>
-struct default_extract<Key, void_if_t<is_radix_sortable_v<Key>>>;
+struct default_extract<Key, void_if_t<is_radix_sortable_v<Key>
+                                      and not is_linear_container_v<Key>>>;
+
+namespace detail_trie {
+
+	/**
+	 * @brief The slot of a key element in a row. Elements are treated as
+	 * unsigned, so that iteration order agrees with std::string comparison.
+	 */
+	template <typename KeyElem>
+	KBLIB_NODISCARD constexpr auto slot_of(KeyElem e) noexcept -> std::size_t {
+		return static_cast<std::make_unsigned_t<KeyElem>>(e);
+	}
+
+	/**
+	 * @brief Compares keys lexicographically by slot, which is the order
+	 * array-mapped tries iterate in.
+	 */
+	template <typename Extractor>
+	struct slot_less {
+		template <typename Key>
+		KBLIB_NODISCARD auto operator()(const Key& a, const Key& b) const
+		    -> bool {
+			return std::lexicographical_compare(
+			    Extractor::begin(a), Extractor::end(a), Extractor::begin(b),
+			    Extractor::end(b), [](const auto& x, const auto& y) {
+				    return slot_of(x) < slot_of(y);
+			    });
+		}
+	};
+
+	/**
+	 * @brief A slot in an array-mapped trie.
+	 */
+	struct position {
+		std::size_t row;
+		std::size_t slot;
+
+		KBLIB_NODISCARD friend auto operator==(position a, position b) noexcept
+		    -> bool {
+			return a.row == b.row and a.slot == b.slot;
+		}
+		KBLIB_NODISCARD friend auto operator!=(position a, position b) noexcept
+		    -> bool {
+			return not (a == b);
+		}
+	};
+
+	/**
+	 * @brief A row of a trie_qset: a bit for each slot saying whether the key
+	 * ending there is present, and the jumps. Rows contain only integers, so
+	 * they can be written to a file and used in place (see trie_qset_view).
+	 */
+	template <std::size_t N, typename offset_type>
+	struct packed_row {
+		std::array<std::uint64_t, (N + 63) / 64> leaves;
+		std::array<offset_type, N> jumps;
+	};
+
+	/**
+	 * @brief Rows in memory owned elsewhere, such as a mapped file.
+	 */
+	template <typename Row>
+	struct row_span {
+		const Row* rows{};
+		std::size_t count{};
+
+		KBLIB_NODISCARD auto operator[](std::size_t i) const noexcept
+		    -> const Row& {
+			return rows[i];
+		}
+		KBLIB_NODISCARD auto size() const noexcept -> std::size_t {
+			return count;
+		}
+		KBLIB_NODISCARD auto empty() const noexcept -> bool {
+			return count == 0;
+		}
+	};
+
+	/**
+	 * @brief The header of a serialized trie_qset, which is followed by its
+	 * rows. Everything but the magic number must match for the rows to be
+	 * readable.
+	 */
+	struct qset_header {
+		KBLIB_CONSTANT_M std::array<char, 8> magic_value{'k', 'b', 'q', 's',
+		                                                 'e', 't', 0, 0};
+		KBLIB_CONSTANT_M std::uint32_t current_version = 1;
+		// Written in native byte order, so that it reads differently on a
+		// machine of the other endianness
+		KBLIB_CONSTANT_M std::uint32_t byte_order_mark = 0x01020304;
+
+		std::array<char, 8> magic;
+		std::uint32_t version;
+		std::uint32_t byte_order;
+		std::uint32_t cardinality;
+		std::uint32_t offset_size;
+		std::uint32_t row_size;
+		std::uint32_t has_empty;
+		std::uint64_t size;
+		std::uint64_t row_count;
+		// Keeps the rows that follow aligned, and leaves room for later
+		// versions
+		std::array<std::uint64_t, 2> reserved;
+
+		template <typename Extractor, typename offset_type, typename Row>
+		KBLIB_NODISCARD static auto make() noexcept -> qset_header {
+			qset_header h{};
+			h.magic = magic_value;
+			h.version = current_version;
+			h.byte_order = byte_order_mark;
+			h.cardinality = static_cast<std::uint32_t>(Extractor::key_cardinality);
+			h.offset_size = sizeof(offset_type);
+			h.row_size = sizeof(Row);
+			return h;
+		}
+
+		KBLIB_NODISCARD auto compatible(const qset_header& o) const noexcept
+		    -> bool {
+			return version == o.version and byte_order == o.byte_order
+			       and cardinality == o.cardinality
+			       and offset_size == o.offset_size and row_size == o.row_size;
+		}
+	};
+	static_assert(sizeof(qset_header) == 64, "qset_header must not be padded");
+
+	template <typename Key, std::size_t N, typename offset_type>
+	using keyed_row = std::array<std::pair<std::optional<Key>, offset_type>, N>;
+
+	/**
+	 * @brief The storage and traversal shared by trie_qset, trie_qset_view
+	 * and trie_set.
+	 *
+	 * Nodes are rows in a single array, of type Rows, with a slot for every
+	 * possible key element. Each slot holds a jump, relative to its own row, to
+	 * the row for the keys that continue past it (0 if there are none), and
+	 * whether the key ending at it is present. Derived says how a row stores
+	 * them, through static jump_of and has_key_at functions. Row 0 is the
+	 * root, which is never a jump target, so child() can use 0 for "no child".
+	 *
+	 * The empty key has no slot, so it is left to Derived.
+	 */
+	template <typename Derived, typename Key, typename Extractor,
+	          typename offset_type, typename Rows>
+	class array_trie_base {
+		static_assert(std::is_signed<offset_type>::value
+		                  and std::is_integral<offset_type>::value,
+		              "offset_type must be a signed integral type");
+
+	 public:
+		using size_type = std::size_t;
+
+		KBLIB_NODISCARD auto size() const noexcept -> size_type { return size_; }
+		KBLIB_NODISCARD auto empty() const noexcept -> bool { return size_ == 0; }
+
+		/**
+		 * @brief The number of rows allocated, including any left empty by
+		 * erase. Each row has a slot for every possible key element.
+		 */
+		KBLIB_NODISCARD auto row_count() const noexcept -> size_type {
+			return data_.size();
+		}
+
+	 protected:
+		KBLIB_CONSTANT_M std::size_t cardinality = Extractor::key_cardinality;
+		using path_type = std::vector<position>;
+
+		KBLIB_NODISCARD auto child(std::size_t row, std::size_t slot) const
+		    noexcept -> std::size_t {
+			const auto jump = Derived::jump_of(data_[row], slot);
+			return jump == 0 ? 0 : row + static_cast<std::size_t>(jump);
+		}
+		KBLIB_NODISCARD auto has_key(position p) const noexcept -> bool {
+			return Derived::has_key_at(data_[p.row], p.slot);
+		}
+
+		/**
+		 * @brief Finds the slot of a non-empty key, if the rows leading to it
+		 * exist.
+		 */
+		KBLIB_NODISCARD auto find_position(const Key& key) const
+		    -> std::optional<position> {
+			if (data_.empty()) {
+				return std::nullopt;
+			}
+			auto first = Extractor::begin(key);
+			const auto last = Extractor::end(key);
+			std::size_t row = 0;
+			for (;;) {
+				const auto slot = slot_of(*first);
+				if (++first == last) {
+					return position{row, slot};
+				}
+				row = child(row, slot);
+				if (row == 0) {
+					return std::nullopt;
+				}
+			}
+		}
+
+		/**
+		 * @brief Finds the slot of a non-empty key, adding rows as needed. If
+		 * path is given, the slots leading to it are recorded there.
+		 */
+		auto make_position(const Key& key, path_type* path = nullptr)
+		    -> position {
+			if (data_.empty()) {
+				data_.emplace_back();
+			}
+			auto first = Extractor::begin(key);
+			const auto last = Extractor::end(key);
+			std::size_t row = 0;
+			for (;;) {
+				const auto slot = slot_of(*first);
+				if (path) {
+					path->push_back({row, slot});
+				}
+				if (++first == last) {
+					return position{row, slot};
+				}
+				auto next = child(row, slot);
+				if (next == 0) {
+					next = data_.size();
+					if (next - row > static_cast<std::size_t>(
+					        std::numeric_limits<offset_type>::max())) {
+						throw std::length_error(
+						    "trie: offset_type is too small to address all rows");
+					}
+					data_.emplace_back();
+					Derived::jump_of(data_[row], slot)
+					    = static_cast<offset_type>(next - row);
+				}
+				row = next;
+			}
+		}
+
+		/**
+		 * @brief Records the slots leading to a non-empty key in path.
+		 *
+		 * @return bool Whether the key is present.
+		 */
+		auto find_path(const Key& key, path_type& path) const -> bool {
+			if (data_.empty()) {
+				return false;
+			}
+			auto first = Extractor::begin(key);
+			const auto last = Extractor::end(key);
+			std::size_t row = 0;
+			for (;;) {
+				const auto slot = slot_of(*first);
+				path.push_back({row, slot});
+				if (++first == last) {
+					return has_key(path.back());
+				}
+				row = child(row, slot);
+				if (row == 0) {
+					return false;
+				}
+			}
+		}
+
+		/**
+		 * @brief Moves path forward to the first present key at or after the
+		 * slot it ends at, in depth-first order. At the end, path is left
+		 * empty.
+		 */
+		auto seek(path_type& path) const noexcept -> void {
+			while (not path.empty()) {
+				const auto p = path.back();
+				if (p.slot == cardinality) {
+					path.pop_back();
+					if (not path.empty()) {
+						++path.back().slot;
+					}
+				} else if (has_key(p)) {
+					return;
+				} else if (const auto c = child(p.row, p.slot)) {
+					path.push_back({c, 0});
+				} else {
+					++path.back().slot;
+				}
+			}
+		}
+
+		/**
+		 * @brief Sets path to the first non-empty key.
+		 */
+		auto seek_first(path_type& path) const -> void {
+			path.clear();
+			if (not data_.empty()) {
+				path.push_back({0, 0});
+				seek(path);
+			}
+		}
+
+		/**
+		 * @brief Moves path from a present key to the next one. The keys that
+		 * extend the current key come first.
+		 */
+		auto advance(path_type& path) const -> void {
+			const auto p = path.back();
+			if (const auto c = child(p.row, p.slot)) {
+				path.push_back({c, 0});
+			} else {
+				++path.back().slot;
+			}
+			seek(path);
+		}
+
+		/**
+		 * @brief Calls f(path) for each present non-empty key that starts with
+		 * prefix, in order, with path ending at the key's slot.
+		 */
+		template <typename F>
+		auto for_each_path_under(const Key& prefix, F f) const -> void {
+			path_type path;
+			auto first = Extractor::begin(prefix);
+			const auto last = Extractor::end(prefix);
+			if (first == last) {
+				for (seek_first(path); not path.empty(); advance(path)) {
+					f(static_cast<const path_type&>(path));
+				}
+				return;
+			}
+			if (data_.empty()) {
+				return;
+			}
+			std::size_t row = 0;
+			for (;;) {
+				const auto slot = slot_of(*first);
+				path.push_back({row, slot});
+				if (++first == last) {
+					break;
+				}
+				row = child(row, slot);
+				if (row == 0) {
+					return;
+				}
+			}
+			// A depth-first walk of the rows below prefix, which stops on
+			// returning to prefix's own slot
+			const auto depth = path.size();
+			for (;;) {
+				const auto p = path.back();
+				if (p.slot == cardinality) {
+					path.pop_back();
+					if (path.size() == depth) {
+						return;
+					}
+					++path.back().slot;
+					continue;
+				}
+				if (has_key(p)) {
+					f(static_cast<const path_type&>(path));
+				}
+				if (const auto c = child(p.row, p.slot)) {
+					path.push_back({c, 0});
+				} else if (path.size() == depth) {
+					return;
+				} else {
+					++path.back().slot;
+				}
+			}
+		}
+
+		/**
+		 * @brief Inserts every key in [first, last), in sorted order. Rows are
+		 * created as they are first needed, so sorted insertion lays them out
+		 * in depth-first order: a lookup walks forward through memory, and
+		 * the rows of keys with a common prefix are close together.
+		 */
+		template <typename ForwardIt>
+		auto insert_sorted(ForwardIt first, ForwardIt last) -> void {
+			const slot_less<Extractor> less;
+			auto& self = static_cast<Derived&>(*this);
+			if (std::is_sorted(first, last, less)) {
+				for (; first != last; ++first) {
+					self.insert(*first);
+				}
+			} else {
+				std::vector<Key> keys(first, last);
+				std::sort(keys.begin(), keys.end(), less);
+				for (auto& k : keys) {
+					self.insert(std::move(k));
+				}
+			}
+		}
+
+		Rows data_;
+		size_type size_{};
+	};
+
+	/**
+	 * @brief The read-only part of trie_qset, shared with trie_qset_view,
+	 * which reads the same rows from memory it does not own.
+	 */
+	template <typename Derived, typename Key, typename Extractor,
+	          typename offset_type, typename Rows>
+	class qset_base
+	    : public array_trie_base<Derived, Key, Extractor, offset_type, Rows> {
+		using base = array_trie_base<Derived, Key, Extractor, offset_type, Rows>;
+		friend base;
+
+	 public:
+		using key_type = Key;
+		using value_type = Key;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+		using reference = value_type&;
+		using const_reference = const value_type&;
+		using pointer = value_type*;
+		using const_pointer = const value_type*;
+
+		using extractor = Extractor;
+		using key_elem = typename extractor::value_type;
+		KBLIB_CONSTANT_M std::size_t key_elem_cardinality
+		    = extractor::key_cardinality;
+
+		class const_iterator;
+		using iterator = const_iterator;
+
+		KBLIB_NODISCARD auto contains(const key_type& key) const -> bool {
+			if (extractor::begin(key) == extractor::end(key)) {
+				return has_empty_;
+			}
+			const auto p = this->find_position(key);
+			return p and this->has_key(*p);
+		}
+		KBLIB_NODISCARD auto count(const key_type& key) const -> size_type {
+			return contains(key);
+		}
+
+		/**
+		 * @brief Calls f(const Key&) on each key that starts with prefix, in
+		 * order. As keys are not stored, the key passed to f is rebuilt for
+		 * each call.
+		 */
+		template <typename F>
+		auto for_each_with_prefix(const key_type& prefix, F f) const -> void {
+			Key key{};
+			if (extractor::begin(prefix) == extractor::end(prefix)
+			    and has_empty_) {
+				f(static_cast<const Key&>(key));
+			}
+			this->for_each_path_under(
+			    prefix, [&](const typename base::path_type& path) {
+				    load_key(path, key);
+				    f(static_cast<const Key&>(key));
+			    });
+		}
+
+		/**
+		 * @brief A forward iterator over the keys, in lexicographic order. As
+		 * keys are not stored, each key is rebuilt in the iterator, and
+		 * references to it are invalidated when the iterator is incremented or
+		 * destroyed.
+		 */
+		class const_iterator {
+		 public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Key;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Key*;
+			using reference = const Key&;
+
+			const_iterator() = default;
+
+			KBLIB_NODISCARD auto operator*() const noexcept -> reference {
+				return key_;
+			}
+			KBLIB_NODISCARD auto operator->() const noexcept -> pointer {
+				return &key_;
+			}
+
+			auto operator++() -> const_iterator& {
+				if (at_empty_) {
+					at_empty_ = false;
+					owner_->seek_first(path_);
+				} else {
+					owner_->advance(path_);
+				}
+				load_key(path_, key_);
+				return *this;
+			}
+			auto operator++(int) -> const_iterator {
+				auto tmp = *this;
+				++*this;
+				return tmp;
+			}
+
+			KBLIB_NODISCARD friend auto operator==(
+			    const const_iterator& a, const const_iterator& b) noexcept
+			    -> bool {
+				return a.at_empty_ == b.at_empty_ and a.path_ == b.path_;
+			}
+			KBLIB_NODISCARD friend auto operator!=(
+			    const const_iterator& a, const const_iterator& b) noexcept
+			    -> bool {
+				return not (a == b);
+			}
+
+		 private:
+			friend class qset_base;
+			const_iterator(const qset_base* owner, bool at_empty) noexcept
+			    : owner_(owner)
+			    , at_empty_(at_empty) {}
+
+			const qset_base* owner_{};
+			typename base::path_type path_;
+			bool at_empty_{};
+			Key key_{};
+		};
+
+		KBLIB_NODISCARD auto begin() const -> const_iterator {
+			const_iterator it(this, has_empty_);
+			if (not has_empty_) {
+				this->seek_first(it.path_);
+				load_key(it.path_, it.key_);
+			}
+			return it;
+		}
+		KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+			return const_iterator(this, false);
+		}
+		KBLIB_NODISCARD auto cbegin() const -> const_iterator { return begin(); }
+		KBLIB_NODISCARD auto cend() const noexcept -> const_iterator {
+			return end();
+		}
+
+	 protected:
+		using row_type = packed_row<key_elem_cardinality, offset_type>;
+
+		static auto jump_of(const row_type& row, std::size_t slot) noexcept
+		    -> offset_type {
+			return row.jumps[slot];
+		}
+		static auto jump_of(row_type& row, std::size_t slot) noexcept
+		    -> offset_type& {
+			return row.jumps[slot];
+		}
+		static auto has_key_at(const row_type& row, std::size_t slot) noexcept
+		    -> bool {
+			return (row.leaves[slot / 64] >> (slot % 64)) & 1u;
+		}
+		static auto set_key_at(row_type& row, std::size_t slot, bool v) noexcept
+		    -> void {
+			const auto bit = std::uint64_t{1} << (slot % 64);
+			if (v) {
+				row.leaves[slot / 64] |= bit;
+			} else {
+				row.leaves[slot / 64] &= ~bit;
+			}
+		}
+
+		static auto load_key(const typename base::path_type& path, Key& key)
+		    -> void {
+			key = Key();
+			for (const auto& p : path) {
+				key.push_back(static_cast<key_elem>(p.slot));
+			}
+		}
+
+		bool has_empty_{};
+	};
+
+} // namespace detail_trie
 
 // qset: does not store Keys (generates them on-demand)
 // Key: the type used for lookup
@@ -204,7 +803,205 @@ struct default_extract<Key, void_if_t<is_radix_sortable_v<Key>>>;
 // integral type
 template <typename Key, typename Extractor = default_extract<Key>,
           typename offset_type = std::ptrdiff_t>
-class trie_qset {
+class trie_qset
+    : public detail_trie::qset_base<
+          trie_qset<Key, Extractor, offset_type>, Key, Extractor, offset_type,
+          std::vector<detail_trie::packed_row<Extractor::key_cardinality,
+                                              offset_type>>> {
+	using base = detail_trie::qset_base<
+	    trie_qset, Key, Extractor, offset_type,
+	    std::vector<
+	        detail_trie::packed_row<Extractor::key_cardinality, offset_type>>>;
+	friend typename base::array_trie_base;
+
+ public:
+	using typename base::key_type;
+	using typename base::size_type;
+	using typename base::value_type;
+
+	trie_qset() = default;
+	/**
+	 * @brief Builds the set from a range of keys, which are inserted in sorted
+	 * order so that the rows are laid out depth-first.
+	 */
+	template <typename ForwardIt>
+	trie_qset(ForwardIt first, ForwardIt last) {
+		this->insert_sorted(first, last);
+	}
+	trie_qset(std::initializer_list<value_type> il)
+	    : trie_qset(il.begin(), il.end()) {}
+
+	/**
+	 * @return bool Whether the key was inserted.
+	 */
+	auto insert(const key_type& key) -> bool {
+		if (Extractor::begin(key) == Extractor::end(key)) {
+			return std::exchange(this->has_empty_, true) ? false
+			                                             : (++this->size_, true);
+		}
+		const auto p = this->make_position(key);
+		auto& row = this->data_[p.row];
+		if (base::has_key_at(row, p.slot)) {
+			return false;
+		}
+		base::set_key_at(row, p.slot, true);
+		++this->size_;
+		return true;
+	}
+
+	/**
+	 * @brief Removes key from the set. Rows are not freed; see shrink_to_fit.
+	 *
+	 * @return size_type The number of keys removed (0 or 1).
+	 */
+	auto erase(const key_type& key) -> size_type {
+		if (Extractor::begin(key) == Extractor::end(key)) {
+			return std::exchange(this->has_empty_, false) ? (--this->size_, 1)
+			                                              : 0;
+		}
+		const auto p = this->find_position(key);
+		if (not p or not this->has_key(*p)) {
+			return 0;
+		}
+		base::set_key_at(this->data_[p->row], p->slot, false);
+		--this->size_;
+		return 1;
+	}
+
+	auto clear() noexcept -> void {
+		this->data_.clear();
+		this->size_ = 0;
+		this->has_empty_ = false;
+	}
+
+	/**
+	 * @brief Rebuilds the trie, freeing rows emptied by erase and restoring a
+	 * depth-first layout.
+	 */
+	auto shrink_to_fit() -> void {
+		const std::vector<key_type> keys(this->begin(), this->end());
+		clear();
+		this->insert_sorted(keys.begin(), keys.end());
+		this->data_.shrink_to_fit();
+	}
+
+	/**
+	 * @brief Writes the set in the format read by trie_qset_view: a header,
+	 * followed by the rows exactly as they are laid out in memory. Jumps are
+	 * relative, so the rows are valid wherever they are loaded.
+	 *
+	 * The format depends on the platform and on Extractor and offset_type, and
+	 * is meant to be written once and read by processes on the same machine.
+	 * Call shrink_to_fit first if keys have been erased.
+	 *
+	 * @return std::ostream& out, whose state reports whether writing failed.
+	 */
+	auto serialize(std::ostream& out) const -> std::ostream& {
+		auto h = detail_trie::qset_header::make<Extractor, offset_type,
+		                                         typename base::row_type>();
+		h.has_empty = this->has_empty_;
+		h.size = this->size_;
+		h.row_count = this->data_.size();
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		const auto bytes = this->data_.size() * sizeof(typename base::row_type);
+		out.write(reinterpret_cast<const char*>(this->data_.data()),
+		          static_cast<std::streamsize>(bytes));
+		return out;
+	}
+};
+
+/**
+ * @brief A read-only trie_qset that queries a serialized one in place, such as
+ * a file mapped into memory with kblib::mapped_file:
+ *
+ * @code
+ * // Once, when the keywords change
+ * std::ofstream out("keywords.trie", std::ios::binary);
+ * kblib::trie_qset<std::string>(keywords.begin(), keywords.end())
+ *     .serialize(out);
+ *
+ * // At every start
+ * const kblib::mapped_file file("keywords.trie");
+ * const kblib::trie_qset_view<std::string> words(file.data(), file.size());
+ * @endcode
+ *
+ * Nothing is parsed or copied: opening a view only checks the header, and
+ * the pages of a mapped file are shared by all the processes that map it.
+ * The rows themselves are trusted, so only files written by
+ * trie_qset::serialize should be opened. The view does not own the memory,
+ * which must outlive it.
+ */
+template <typename Key, typename Extractor = default_extract<Key>,
+          typename offset_type = std::ptrdiff_t>
+class trie_qset_view
+    : public detail_trie::qset_base<
+          trie_qset_view<Key, Extractor, offset_type>, Key, Extractor,
+          offset_type,
+          detail_trie::row_span<detail_trie::packed_row<
+              Extractor::key_cardinality, offset_type>>> {
+	using base = detail_trie::qset_base<
+	    trie_qset_view, Key, Extractor, offset_type,
+	    detail_trie::row_span<
+	        detail_trie::packed_row<Extractor::key_cardinality, offset_type>>>;
+	friend typename base::array_trie_base;
+	using row_type = typename base::row_type;
+
+ public:
+	trie_qset_view() = default;
+
+	/**
+	 * @param data The output of trie_qset::serialize, aligned to 8 bytes, as
+	 * memory from mapped_file or operator new is.
+	 * @param size The size of data in bytes.
+	 *
+	 * @throw std::invalid_argument if data does not hold a trie_qset with the
+	 * same key cardinality and offset_type, written on the same platform.
+	 */
+	trie_qset_view(const void* data, std::size_t size) {
+		using detail_trie::qset_header;
+		const auto bytes = static_cast<const unsigned char*>(data);
+		qset_header h;
+		if (size < sizeof(h)) {
+			throw std::invalid_argument(
+			    "trie_qset_view: data is not a serialized trie_qset");
+		}
+		std::memcpy(&h, bytes, sizeof(h));
+		if (h.magic != qset_header::magic_value) {
+			throw std::invalid_argument(
+			    "trie_qset_view: data is not a serialized trie_qset");
+		}
+		if (not h.compatible(
+		        qset_header::make<Extractor, offset_type, row_type>())) {
+			throw std::invalid_argument(
+			    "trie_qset_view: data was written with a different format, key "
+			    "type, offset_type, or platform");
+		}
+		if ((size - sizeof(h)) / sizeof(row_type) < h.row_count) {
+			throw std::invalid_argument("trie_qset_view: data is truncated");
+		}
+		if (reinterpret_cast<std::uintptr_t>(bytes) % alignof(row_type) != 0) {
+			throw std::invalid_argument("trie_qset_view: data is misaligned");
+		}
+		this->data_ = {reinterpret_cast<const row_type*>(bytes + sizeof(h)),
+		               static_cast<std::size_t>(h.row_count)};
+		this->size_ = static_cast<std::size_t>(h.size);
+		this->has_empty_ = h.has_empty != 0;
+	}
+};
+
+template <typename Key, typename Extractor = default_extract<Key>,
+          typename offset_type = std::ptrdiff_t>
+class trie_set
+    : public detail_trie::array_trie_base<
+          trie_set<Key, Extractor, offset_type>, Key, Extractor, offset_type,
+          std::vector<detail_trie::keyed_row<Key, Extractor::key_cardinality,
+                                             offset_type>>> {
+	using base = detail_trie::array_trie_base<
+	    trie_set, Key, Extractor, offset_type,
+	    std::vector<detail_trie::keyed_row<Key, Extractor::key_cardinality,
+	                                       offset_type>>>;
+	friend base;
+
  public:
 	using key_type = Key;
 	using value_type = Key;
@@ -221,38 +1018,499 @@ class trie_qset {
 	KBLIB_CONSTANT_M std::size_t key_elem_cardinality
 	    = extractor::key_cardinality;
 
+	class const_iterator;
+	using iterator = const_iterator;
+
+	trie_set() = default;
+	/**
+	 * @brief Builds the set from a range of keys, which are inserted in sorted
+	 * order so that the rows are laid out depth-first.
+	 */
+	template <typename ForwardIt>
+	trie_set(ForwardIt first, ForwardIt last) {
+		this->insert_sorted(first, last);
+	}
+	trie_set(std::initializer_list<value_type> il)
+	    : trie_set(il.begin(), il.end()) {}
+
+	/**
+	 * @return std::pair<iterator, bool> The key in the set, and whether it was
+	 * inserted.
+	 */
+	auto insert(value_type key) -> std::pair<iterator, bool> {
+		iterator it(this, false);
+		if (extractor::begin(key) == extractor::end(key)) {
+			it.at_empty_ = true;
+			if (empty_key_) {
+				return {it, false};
+			}
+			empty_key_.emplace(std::move(key));
+		} else {
+			const auto p = this->make_position(key, &it.path_);
+			auto& slot = this->data_[p.row][p.slot].first;
+			if (slot) {
+				return {it, false};
+			}
+			slot.emplace(std::move(key));
+		}
+		++this->size_;
+		return {it, true};
+	}
+
+	/**
+	 * @brief Removes key from the set. Rows are not freed; see shrink_to_fit.
+	 *
+	 * @return size_type The number of keys removed (0 or 1).
+	 */
+	auto erase(const key_type& key) -> size_type {
+		if (extractor::begin(key) == extractor::end(key)) {
+			if (not empty_key_) {
+				return 0;
+			}
+			empty_key_.reset();
+		} else {
+			const auto p = this->find_position(key);
+			if (not p or not this->has_key(*p)) {
+				return 0;
+			}
+			this->data_[p->row][p->slot].first.reset();
+		}
+		--this->size_;
+		return 1;
+	}
+
+	KBLIB_NODISCARD auto find(const key_type& key) const -> const_iterator {
+		const_iterator it(this, false);
+		if (extractor::begin(key) == extractor::end(key)) {
+			it.at_empty_ = empty_key_.has_value();
+		} else if (not this->find_path(key, it.path_)) {
+			it.path_.clear();
+		}
+		return it;
+	}
+	KBLIB_NODISCARD auto contains(const key_type& key) const -> bool {
+		if (extractor::begin(key) == extractor::end(key)) {
+			return empty_key_.has_value();
+		}
+		const auto p = this->find_position(key);
+		return p and this->has_key(*p);
+	}
+	KBLIB_NODISCARD auto count(const key_type& key) const -> size_type {
+		return contains(key);
+	}
+
+	/**
+	 * @brief Calls f(const Key&) on each key that starts with prefix, in
+	 * order.
+	 */
+	template <typename F>
+	auto for_each_with_prefix(const key_type& prefix, F f) const -> void {
+		if (extractor::begin(prefix) == extractor::end(prefix) and empty_key_) {
+			f(static_cast<const Key&>(*empty_key_));
+		}
+		this->for_each_path_under(
+		    prefix, [&](const typename base::path_type& path) {
+			    f(*key_at(path.back()));
+		    });
+	}
+
+	auto clear() noexcept -> void {
+		this->data_.clear();
+		this->size_ = 0;
+		empty_key_.reset();
+	}
+
+	/**
+	 * @brief Rebuilds the trie, freeing rows emptied by erase and restoring a
+	 * depth-first layout.
+	 */
+	auto shrink_to_fit() -> void {
+		std::vector<key_type> keys;
+		keys.reserve(this->size());
+		if (empty_key_) {
+			keys.push_back(std::move(*empty_key_));
+		}
+		typename base::path_type path;
+		for (this->seek_first(path); not path.empty(); this->advance(path)) {
+			keys.push_back(std::move(*key_at(path.back())));
+		}
+		clear();
+		this->insert_sorted(keys.begin(), keys.end());
+		this->data_.shrink_to_fit();
+	}
+
+	/**
+	 * @brief A forward iterator over the keys, in lexicographic order.
+	 */
+	class const_iterator {
+	 public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Key;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Key*;
+		using reference = const Key&;
+
+		const_iterator() = default;
+
+		KBLIB_NODISCARD auto operator*() const noexcept -> reference {
+			return at_empty_ ? *owner_->empty_key_
+			                 : *owner_->key_at(path_.back());
+		}
+		KBLIB_NODISCARD auto operator->() const noexcept -> pointer {
+			return &**this;
+		}
+
+		auto operator++() -> const_iterator& {
+			if (at_empty_) {
+				at_empty_ = false;
+				owner_->seek_first(path_);
+			} else {
+				owner_->advance(path_);
+			}
+			return *this;
+		}
+		auto operator++(int) -> const_iterator {
+			auto tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		KBLIB_NODISCARD friend auto operator==(const const_iterator& a,
+		                                       const const_iterator& b) noexcept
+		    -> bool {
+			return a.at_empty_ == b.at_empty_ and a.path_ == b.path_;
+		}
+		KBLIB_NODISCARD friend auto operator!=(const const_iterator& a,
+		                                       const const_iterator& b) noexcept
+		    -> bool {
+			return not (a == b);
+		}
+
+	 private:
+		friend class trie_set;
+		const_iterator(const trie_set* owner, bool at_empty) noexcept
+		    : owner_(owner)
+		    , at_empty_(at_empty) {}
+
+		const trie_set* owner_{};
+		typename base::path_type path_;
+		bool at_empty_{};
+	};
+
+	KBLIB_NODISCARD auto begin() const -> const_iterator {
+		const_iterator it(this, empty_key_.has_value());
+		if (not it.at_empty_) {
+			this->seek_first(it.path_);
+		}
+		return it;
+	}
+	KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+		return const_iterator(this, false);
+	}
+	KBLIB_NODISCARD auto cbegin() const -> const_iterator { return begin(); }
+	KBLIB_NODISCARD auto cend() const noexcept -> const_iterator { return end(); }
+
  private:
-	// Bitset stores leaf status, array holds jumps, 0 represents no jump (leaf
-	// or no entry)
-	using row_type = std::pair<std::bitset<key_elem_cardinality>,
-	                           std::array<offset_type, key_elem_cardinality>>;
-	std::vector<row_type> data_;
+	// offset 0 represents no jump (leaf or no entry)
+	using row_type = std::array<std::pair<std::optional<Key>, offset_type>,
+	                            key_elem_cardinality>;
+
+	static auto jump_of(const row_type& row, std::size_t slot) noexcept
+	    -> offset_type {
+		return row[slot].second;
+	}
+	static auto jump_of(row_type& row, std::size_t slot) noexcept
+	    -> offset_type& {
+		return row[slot].second;
+	}
+	static auto has_key_at(const row_type& row, std::size_t slot) noexcept
+	    -> bool {
+		return row[slot].first.has_value();
+	}
+	auto key_at(detail_trie::position p) const noexcept -> const Key* {
+		return &*this->data_[p.row][p.slot].first;
+	}
+	auto key_at(detail_trie::position p) noexcept -> Key* {
+		return &*this->data_[p.row][p.slot].first;
+	}
+
+	std::optional<Key> empty_key_;
 };
 
+/**
+ * @brief A read-only set of keys, stored as a double-array trie, for large
+ * dictionaries that are built once and then only queried.
+ *
+ * Each trie node is a unit in one array, holding a base and a check. The
+ * child of node s for element e is the unit t = base[s] + slot_of(e) + 1,
+ * which exists if check[t] == s; the end of a key is marked by the child for
+ * label 0. Base and check are stored together, so a lookup reads about one
+ * cache line per key element, and the whole set takes
+ * unit_count() * 2 * sizeof(index_type) bytes, where a trie_qset takes a
+ * full row of jumps for every node.
+ *
+ * The keys must be given up front, and finding a base for every node makes
+ * building slower than inserting into the other tries. Listing keys probes
+ * every possible element at each node, so for_each_with_prefix is only fast
+ * for narrow prefixes.
+ *
+ * @tparam index_type The type of unit indices. Must be a signed integral type
+ * able to count every unit.
+ */
 template <typename Key, typename Extractor = default_extract<Key>,
-          typename offset_type = std::ptrdiff_t>
-class trie_set {
+          typename index_type = std::int32_t>
+class double_array_trie_set {
+	static_assert(std::is_signed<index_type>::value
+	                  and std::is_integral<index_type>::value,
+	              "index_type must be a signed integral type");
+
  public:
 	using key_type = Key;
 	using value_type = Key;
 	using size_type = std::size_t;
-	using difference_type = std::ptrdiff_t;
-
-	using reference = value_type&;
-	using const_reference = const value_type&;
-	using pointer = value_type*;
-	using const_pointer = const value_type*;
 
 	using extractor = Extractor;
 	using key_elem = typename extractor::value_type;
 	KBLIB_CONSTANT_M std::size_t key_elem_cardinality
 	    = extractor::key_cardinality;
 
+	double_array_trie_set() = default;
+	/**
+	 * @brief Builds the set from a range of keys, which need not be sorted or
+	 * unique.
+	 */
+	template <typename ForwardIt>
+	double_array_trie_set(ForwardIt first, ForwardIt last) {
+		std::vector<Key> keys(first, last);
+		const detail_trie::slot_less<Extractor> less;
+		if (not std::is_sorted(keys.begin(), keys.end(), less)) {
+			std::sort(keys.begin(), keys.end(), less);
+		}
+		build(keys);
+	}
+	double_array_trie_set(std::initializer_list<value_type> il)
+	    : double_array_trie_set(il.begin(), il.end()) {}
+
+	KBLIB_NODISCARD auto size() const noexcept -> size_type { return size_; }
+	KBLIB_NODISCARD auto empty() const noexcept -> bool { return size_ == 0; }
+
+	/**
+	 * @brief The number of units in the array, including free ones left
+	 * between nodes.
+	 */
+	KBLIB_NODISCARD auto unit_count() const noexcept -> size_type {
+		return units_.size();
+	}
+
+	KBLIB_NODISCARD auto contains(const key_type& key) const noexcept -> bool {
+		if (units_.empty()) {
+			return false;
+		}
+		index_type s = 0;
+		for (auto first = extractor::begin(key), last = extractor::end(key);
+		     first != last; ++first) {
+			s = child(s, detail_trie::slot_of(*first) + 1);
+			if (s < 0) {
+				return false;
+			}
+		}
+		return child(s, 0) >= 0;
+	}
+	KBLIB_NODISCARD auto count(const key_type& key) const noexcept
+	    -> size_type {
+		return contains(key);
+	}
+
+	/**
+	 * @brief Calls f(const Key&) on each key that starts with prefix, in
+	 * order.
+	 */
+	template <typename F>
+	auto for_each_with_prefix(const key_type& prefix, F f) const -> void {
+		if (units_.empty()) {
+			return;
+		}
+		index_type s = 0;
+		Key key{};
+		for (auto first = extractor::begin(prefix), last = extractor::end(prefix);
+		     first != last; ++first) {
+			s = child(s, detail_trie::slot_of(*first) + 1);
+			if (s < 0) {
+				return;
+			}
+			key.push_back(*first);
+		}
+		// Depth-first, with the next label to try at each level
+		struct frame {
+			index_type node;
+			std::size_t label;
+		};
+		std::vector<frame> stack{{s, 0}};
+		while (not stack.empty()) {
+			auto& top = stack.back();
+			if (top.label == key_elem_cardinality + 1) {
+				stack.pop_back();
+				if (not stack.empty()) {
+					key.pop_back();
+				}
+				continue;
+			}
+			const auto label = top.label++;
+			const auto c = child(top.node, label);
+			if (c < 0) {
+				continue;
+			} else if (label == 0) {
+				f(static_cast<const Key&>(key));
+			} else {
+				key.push_back(static_cast<key_elem>(label - 1));
+				stack.push_back({c, 0});
+			}
+		}
+	}
+
  private:
-	// offset 0 represents no jump (leaf or no entry)
-	using row_type = std::array<std::pair<std::optional<Key>, offset_type>,
-	                            key_elem_cardinality>;
-	std::vector<row_type> data_;
+	struct unit {
+		index_type base;
+		index_type check;
+	};
+
+	/**
+	 * @return index_type The child of s with the given label, or -1.
+	 */
+	KBLIB_NODISCARD auto child(index_type s, std::size_t label) const noexcept
+	    -> index_type {
+		const auto t = static_cast<std::size_t>(
+		                   units_[static_cast<std::size_t>(s)].base)
+		               + label;
+		return t < units_.size() and units_[t].check == s
+		           ? static_cast<index_type>(t)
+		           : -1;
+	}
+
+	/**
+	 * @brief Lays out the trie of keys, which must be sorted, node by node in
+	 * depth-first order. Each node's children are placed at the first base at
+	 * which all of their units are free, found by walking a list of the free
+	 * units.
+	 */
+	auto build(const std::vector<Key>& keys) -> void {
+		if (keys.empty()) {
+			return;
+		}
+		// Free units have a negative check, and are linked in order through
+		// next_free and prev_free
+		std::vector<index_type> next_free, prev_free;
+		index_type free_head = -1, free_tail = -1;
+		const auto grow = [&](std::size_t n) {
+			if (n > static_cast<std::size_t>(
+			        std::numeric_limits<index_type>::max())) {
+				throw std::length_error("double_array_trie_set: index_type is too "
+				                        "small to address all units");
+			}
+			while (units_.size() < n) {
+				const auto i = static_cast<index_type>(units_.size());
+				units_.push_back({0, -1});
+				next_free.push_back(-1);
+				prev_free.push_back(free_tail);
+				if (free_tail < 0) {
+					free_head = i;
+				} else {
+					next_free[static_cast<std::size_t>(free_tail)] = i;
+				}
+				free_tail = i;
+			}
+		};
+		const auto occupy = [&](std::size_t i, index_type parent) {
+			const auto prev = prev_free[i], next = next_free[i];
+			(prev < 0 ? free_head : next_free[static_cast<std::size_t>(prev)])
+			    = next;
+			(next < 0 ? free_tail : prev_free[static_cast<std::size_t>(next)])
+			    = prev;
+			units_[i].check = parent;
+		};
+		const auto label_at = [](const Key& key, std::size_t depth) {
+			const auto len = static_cast<std::size_t>(
+			    std::distance(extractor::begin(key), extractor::end(key)));
+			return depth == len
+			           ? std::size_t{0}
+			           : detail_trie::slot_of(extractor::index(key, depth)) + 1;
+		};
+
+		// The root is unit 0, which is never a child as bases are at least 1
+		grow(1);
+		occupy(0, 0);
+
+		struct task {
+			index_type node;
+			std::size_t first, last, depth;
+		};
+		struct child_range {
+			std::size_t label, first, last;
+		};
+		std::vector<task> tasks{{0, 0, keys.size(), 0}};
+		std::vector<child_range> children;
+		while (not tasks.empty()) {
+			const auto t = tasks.back();
+			tasks.pop_back();
+			// Keys are sorted, so each child's keys are contiguous, and equal
+			// keys share one end-of-key unit
+			children.clear();
+			for (auto i = t.first; i != t.last;) {
+				const auto label = label_at(keys[i], t.depth);
+				auto j = i + 1;
+				while (j != t.last and label_at(keys[j], t.depth) == label) {
+					++j;
+				}
+				children.push_back({label, i, j});
+				i = j;
+			}
+
+			const auto lowest = children.front().label;
+			const auto highest = children.back().label;
+			std::size_t base = 0;
+			for (auto pos = free_head;;
+			     pos = next_free[static_cast<std::size_t>(pos)]) {
+				if (pos < 0) {
+					pos = static_cast<index_type>(units_.size());
+					grow(units_.size() + 1);
+				}
+				if (static_cast<std::size_t>(pos) <= lowest) {
+					continue;
+				}
+				base = static_cast<std::size_t>(pos) - lowest;
+				grow(base + highest + 1);
+				if (std::all_of(children.begin(), children.end(),
+				                [&](const child_range& c) {
+					                return units_[base + c.label].check < 0;
+				                })) {
+					break;
+				}
+			}
+
+			units_[static_cast<std::size_t>(t.node)].base
+			    = static_cast<index_type>(base);
+			for (const auto& c : children) {
+				occupy(base + c.label, t.node);
+			}
+			// Pushed in reverse, so that the lowest child is laid out next
+			for (auto it = children.rbegin(); it != children.rend(); ++it) {
+				if (it->label == 0) {
+					++size_;
+				} else {
+					tasks.push_back({static_cast<index_type>(base + it->label),
+					                 it->first, it->last, t.depth + 1});
+				}
+			}
+		}
+
+		while (units_.back().check < 0) {
+			units_.pop_back();
+		}
+		units_.shrink_to_fit();
+	}
+
+	std::vector<unit> units_;
+	size_type size_{};
 };
 
 template <typename Key, typename Value,
@@ -266,12 +1524,1376 @@ template <typename Key, typename Value,
           template <typename> typename SequenceContainer = std::vector>
 class trie_qmap {};
 
+namespace detail_sparse_trie {
+
+	KBLIB_NODISCARD inline auto countr_zero(unsigned x) noexcept -> unsigned {
+#	if defined(__GNUC__) or defined(__clang__)
+		return static_cast<unsigned>(__builtin_ctz(x));
+#	else
+		unsigned n = 0;
+		for (; not (x & 1u); x >>= 1u) {
+			++n;
+		}
+		return n;
+#	endif
+	}
+
+	enum class node_type : std::uint8_t { leaf, node4, node16, node48, node256 };
+
+	/**
+	 * @brief Prefix bytes beyond this many are not stored in inner nodes, but
+	 * skipped during lookup and checked against the full key in the leaf.
+	 */
+	KBLIB_CONSTANT std::size_t max_prefix = 8;
+
+	struct node {
+		explicit node(node_type t) noexcept
+		    : type(t) {}
+		node_type type;
+	};
+
+	/**
+	 * @brief The header of every leaf. A leaf is followed, in the same
+	 * allocation, by the key_len bytes of its key.
+	 */
+	struct leaf_header : node {
+		explicit leaf_header(std::uint32_t len) noexcept
+		    : node(node_type::leaf)
+		    , key_len(len) {}
+		std::uint32_t key_len;
+	};
+
+	template <typename Mapped>
+	struct leaf : leaf_header {
+		template <typename... Args>
+		explicit leaf(std::uint32_t len, Args&&... args)
+		    : leaf_header(len)
+		    , value(std::forward<Args>(args)...) {}
+		Mapped value;
+	};
+
+	/**
+	 * @brief The mapped type of a set, whose leaves hold only the key.
+	 */
+	struct no_value {};
+	template <>
+	struct leaf<no_value> : leaf_header {
+		using leaf_header::leaf_header;
+	};
+
+	/**
+	 * @brief The key bytes stored in a leaf.
+	 */
+	struct key_view {
+		const std::uint8_t* data;
+		std::size_t size;
+	};
+
+	/**
+	 * @brief The pointer type of an iterator whose reference is a proxy.
+	 */
+	template <typename Reference>
+	struct arrow_proxy {
+		Reference ref;
+		auto operator->() noexcept -> Reference* { return &ref; }
+	};
+
+	/**
+	 * @brief The header of every inner node: its compressed path, and the leaf
+	 * of the key that ends at this node, if any.
+	 */
+	struct inner : node {
+		using node::node;
+		std::uint16_t count{};
+		std::uint32_t prefix_len{};
+		std::array<std::uint8_t, max_prefix> prefix{};
+		node* terminal{};
+	};
+
+	// Children are kept sorted by key byte in node4 and node16
+	struct node4 : inner {
+		node4() noexcept
+		    : inner(node_type::node4) {}
+		std::array<std::uint8_t, 4> keys{};
+		std::array<node*, 4> children{};
+	};
+	struct node16 : inner {
+		node16() noexcept
+		    : inner(node_type::node16) {}
+		std::array<std::uint8_t, 16> keys{};
+		std::array<node*, 16> children{};
+	};
+	// index holds 1 + the child's slot, or 0 for no child
+	struct node48 : inner {
+		node48() noexcept
+		    : inner(node_type::node48) {}
+		std::array<std::uint8_t, 256> index{};
+		std::array<node*, 48> children{};
+	};
+	struct node256 : inner {
+		node256() noexcept
+		    : inner(node_type::node256) {}
+		std::array<node*, 256> children{};
+	};
+
+	KBLIB_NODISCARD inline auto is_leaf(const node* n) noexcept -> bool {
+		return n->type == node_type::leaf;
+	}
+
+	/**
+	 * @brief Finds the slot of the child for byte b, or nullptr.
+	 */
+	KBLIB_NODISCARD inline auto find_child(inner* n, std::uint8_t b) noexcept
+	    -> node** {
+		switch (n->type) {
+		case node_type::node4: {
+			auto p = static_cast<node4*>(n);
+			for (std::size_t i = 0; i != p->count; ++i) {
+				if (p->keys[i] == b) {
+					return &p->children[i];
+				}
+			}
+			return nullptr;
+		}
+		case node_type::node16: {
+			auto p = static_cast<node16*>(n);
+#	if KBLIB_SPARSE_TRIE_SSE2
+			const auto eq = _mm_cmpeq_epi8(
+			    _mm_set1_epi8(static_cast<char>(b)),
+			    _mm_loadu_si128(reinterpret_cast<const __m128i*>(p->keys.data())));
+			const auto mask = static_cast<unsigned>(_mm_movemask_epi8(eq))
+			                  & ((1u << p->count) - 1u);
+			return mask ? &p->children[countr_zero(mask)] : nullptr;
+#	else
+			for (std::size_t i = 0; i != p->count; ++i) {
+				if (p->keys[i] == b) {
+					return &p->children[i];
+				}
+			}
+			return nullptr;
+#	endif
+		}
+		case node_type::node48: {
+			auto p = static_cast<node48*>(n);
+			return p->index[b] ? &p->children[p->index[b] - 1u] : nullptr;
+		}
+		case node_type::node256: {
+			auto p = static_cast<node256*>(n);
+			return p->children[b] ? &p->children[b] : nullptr;
+		}
+		case node_type::leaf:
+			break;
+		}
+		return nullptr;
+	}
+
+	/**
+	 * @brief Finds the child with the smallest key byte greater than after, or
+	 * nullptr. after = -1 finds the first child.
+	 */
+	KBLIB_NODISCARD inline auto next_child(const inner* n, int after) noexcept
+	    -> node* {
+		switch (n->type) {
+		case node_type::node4: {
+			auto p = static_cast<const node4*>(n);
+			for (std::size_t i = 0; i != p->count; ++i) {
+				if (p->keys[i] > after) {
+					return p->children[i];
+				}
+			}
+			return nullptr;
+		}
+		case node_type::node16: {
+			auto p = static_cast<const node16*>(n);
+			for (std::size_t i = 0; i != p->count; ++i) {
+				if (p->keys[i] > after) {
+					return p->children[i];
+				}
+			}
+			return nullptr;
+		}
+		case node_type::node48: {
+			auto p = static_cast<const node48*>(n);
+			for (auto b = static_cast<std::size_t>(after + 1); b < 256; ++b) {
+				if (p->index[b]) {
+					return p->children[p->index[b] - 1u];
+				}
+			}
+			return nullptr;
+		}
+		case node_type::node256: {
+			auto p = static_cast<const node256*>(n);
+			for (auto b = static_cast<std::size_t>(after + 1); b < 256; ++b) {
+				if (p->children[b]) {
+					return p->children[b];
+				}
+			}
+			return nullptr;
+		}
+		case node_type::leaf:
+			break;
+		}
+		return nullptr;
+	}
+
+	/**
+	 * @brief The leaf of the smallest key under n.
+	 */
+	KBLIB_NODISCARD inline auto min_leaf(node* n) noexcept -> node* {
+		while (not is_leaf(n)) {
+			auto i = static_cast<inner*>(n);
+			n = i->terminal ? i->terminal : next_child(i, -1);
+		}
+		return n;
+	}
+
+	inline auto copy_header(inner& to, const inner& from) noexcept -> void {
+		to.count = from.count;
+		to.prefix_len = from.prefix_len;
+		to.prefix = from.prefix;
+		to.terminal = from.terminal;
+	}
+
+	template <typename Node>
+	auto sorted_insert(Node* p, std::uint8_t b, node* child) noexcept -> void {
+		std::size_t i = 0;
+		while (i != p->count and p->keys[i] < b) {
+			++i;
+		}
+		std::copy_backward(p->keys.begin() + i, p->keys.begin() + p->count,
+		                   p->keys.begin() + p->count + 1);
+		std::copy_backward(p->children.begin() + i,
+		                   p->children.begin() + p->count,
+		                   p->children.begin() + p->count + 1);
+		p->keys[i] = b;
+		p->children[i] = child;
+		++p->count;
+	}
+
+	template <typename Node>
+	auto sorted_erase(Node* p, std::uint8_t b) noexcept -> void {
+		std::size_t i = 0;
+		while (p->keys[i] != b) {
+			++i;
+		}
+		std::copy(p->keys.begin() + i + 1, p->keys.begin() + p->count,
+		          p->keys.begin() + i);
+		std::copy(p->children.begin() + i + 1, p->children.begin() + p->count,
+		          p->children.begin() + i);
+		--p->count;
+	}
+
+	/**
+	 * @brief Adds a child for byte b, which must not have one, replacing ref
+	 * with a larger node if it is full.
+	 */
+	inline auto add_child(node*& ref, std::uint8_t b, node* child) -> void {
+		auto n = static_cast<inner*>(ref);
+		switch (n->type) {
+		case node_type::node4: {
+			auto p = static_cast<node4*>(n);
+			if (p->count < 4) {
+				sorted_insert(p, b, child);
+				return;
+			}
+			auto grown = new node16;
+			copy_header(*grown, *p);
+			std::copy(p->keys.begin(), p->keys.end(), grown->keys.begin());
+			std::copy(p->children.begin(), p->children.end(),
+			          grown->children.begin());
+			delete p;
+			sorted_insert(grown, b, child);
+			ref = grown;
+			return;
+		}
+		case node_type::node16: {
+			auto p = static_cast<node16*>(n);
+			if (p->count < 16) {
+				sorted_insert(p, b, child);
+				return;
+			}
+			auto grown = new node48;
+			copy_header(*grown, *p);
+			for (std::size_t i = 0; i != 16; ++i) {
+				grown->index[p->keys[i]] = static_cast<std::uint8_t>(i + 1);
+				grown->children[i] = p->children[i];
+			}
+			delete p;
+			grown->index[b] = 17;
+			grown->children[16] = child;
+			++grown->count;
+			ref = grown;
+			return;
+		}
+		case node_type::node48: {
+			auto p = static_cast<node48*>(n);
+			if (p->count < 48) {
+				std::size_t i = 0;
+				while (p->children[i]) {
+					++i;
+				}
+				p->index[b] = static_cast<std::uint8_t>(i + 1);
+				p->children[i] = child;
+				++p->count;
+				return;
+			}
+			auto grown = new node256;
+			copy_header(*grown, *p);
+			for (std::size_t i = 0; i != 256; ++i) {
+				if (p->index[i]) {
+					grown->children[i] = p->children[p->index[i] - 1u];
+				}
+			}
+			delete p;
+			grown->children[b] = child;
+			++grown->count;
+			ref = grown;
+			return;
+		}
+		case node_type::node256: {
+			auto p = static_cast<node256*>(n);
+			p->children[b] = child;
+			++p->count;
+			return;
+		}
+		case node_type::leaf:
+			break;
+		}
+	}
+
+	/**
+	 * @brief Removes the child for byte b, replacing ref with a smaller node
+	 * once it is sparse enough. Each shrink threshold is below the size the
+	 * node grew at, so that alternating inserts and erases do not thrash.
+	 */
+	inline auto remove_child(node*& ref, std::uint8_t b) -> void {
+		auto n = static_cast<inner*>(ref);
+		switch (n->type) {
+		case node_type::node4:
+			sorted_erase(static_cast<node4*>(n), b);
+			return;
+		case node_type::node16: {
+			auto p = static_cast<node16*>(n);
+			sorted_erase(p, b);
+			if (p->count > 3) {
+				return;
+			}
+			auto shrunk = new node4;
+			copy_header(*shrunk, *p);
+			std::copy_n(p->keys.begin(), p->count, shrunk->keys.begin());
+			std::copy_n(p->children.begin(), p->count, shrunk->children.begin());
+			delete p;
+			ref = shrunk;
+			return;
+		}
+		case node_type::node48: {
+			auto p = static_cast<node48*>(n);
+			p->children[p->index[b] - 1u] = nullptr;
+			p->index[b] = 0;
+			--p->count;
+			if (p->count > 12) {
+				return;
+			}
+			auto shrunk = new node16;
+			copy_header(*shrunk, *p);
+			std::size_t j = 0;
+			for (std::size_t i = 0; i != 256; ++i) {
+				if (p->index[i]) {
+					shrunk->keys[j] = static_cast<std::uint8_t>(i);
+					shrunk->children[j++] = p->children[p->index[i] - 1u];
+				}
+			}
+			delete p;
+			ref = shrunk;
+			return;
+		}
+		case node_type::node256: {
+			auto p = static_cast<node256*>(n);
+			p->children[b] = nullptr;
+			--p->count;
+			if (p->count > 36) {
+				return;
+			}
+			auto shrunk = new node48;
+			copy_header(*shrunk, *p);
+			std::size_t j = 0;
+			for (std::size_t i = 0; i != 256; ++i) {
+				if (p->children[i]) {
+					shrunk->index[i] = static_cast<std::uint8_t>(j + 1);
+					shrunk->children[j++] = p->children[i];
+				}
+			}
+			delete p;
+			ref = shrunk;
+			return;
+		}
+		case node_type::leaf:
+			break;
+		}
+	}
+
+	/**
+	 * @brief Calls f on each child of n, in key order.
+	 */
+	template <typename F>
+	auto for_each_child(inner* n, F f) -> void {
+		switch (n->type) {
+		case node_type::node4: {
+			auto p = static_cast<node4*>(n);
+			std::for_each_n(p->children.begin(), p->count, f);
+		} break;
+		case node_type::node16: {
+			auto p = static_cast<node16*>(n);
+			std::for_each_n(p->children.begin(), p->count, f);
+		} break;
+		case node_type::node48: {
+			auto p = static_cast<node48*>(n);
+			for (auto i : p->index) {
+				if (i) {
+					f(p->children[i - 1u]);
+				}
+			}
+		} break;
+		case node_type::node256: {
+			auto p = static_cast<node256*>(n);
+			for (auto c : p->children) {
+				if (c) {
+					f(c);
+				}
+			}
+		} break;
+		case node_type::leaf:
+			break;
+		}
+	}
+
+	KBLIB_NODISCARD inline auto node_size(const node* n) noexcept
+	    -> std::size_t {
+		switch (n->type) {
+		case node_type::node4:
+			return sizeof(node4);
+		case node_type::node16:
+			return sizeof(node16);
+		case node_type::node48:
+			return sizeof(node48);
+		case node_type::node256:
+			return sizeof(node256);
+		case node_type::leaf:
+			break;
+		}
+		return 0;
+	}
+
+	/**
+	 * @brief An adaptive radix tree: the implementation of sparse_trie_set and
+	 * sparse_trie_map.
+	 *
+	 * Inner nodes come in four sizes, for up to 4, 16, 48 and 256 children,
+	 * and grow and shrink as children are added and removed, so that sparse
+	 * levels do not pay for 256 slots. Chains of single-child nodes are
+	 * collapsed into a prefix stored in the node below them. Each leaf holds
+	 * its mapped value and, in the same allocation, the bytes of its full key,
+	 * so that stored prefixes can be truncated and only verified once a leaf
+	 * is reached. Keys are never stored as Key objects: iterators rebuild them
+	 * from the leaf when dereferenced.
+	 *
+	 * Iterators point at leaves, and are only invalidated by erasing their own
+	 * element. Incrementing one descends from the root, taking time
+	 * proportional to the key length.
+	 */
+	template <typename Key, typename Mapped, typename Extractor>
+	class art {
+		static_assert(Extractor::key_cardinality <= 256,
+		              "sparse tries index nodes by byte");
+
+		KBLIB_CONSTANT_M bool is_set = std::is_same<Mapped, no_value>::value;
+
+	 public:
+		using key_type = Key;
+		using value_type
+		    = std::conditional_t<is_set, Key, std::pair<const Key, Mapped>>;
+		using size_type = std::size_t;
+		using difference_type = std::ptrdiff_t;
+
+	 protected:
+		using leaf_type = leaf<Mapped>;
+		using key_elem = typename Extractor::value_type;
+
+	 public:
+		/**
+		 * @brief Dereferences to a const Key& for a set, or to a
+		 * std::pair<const Key&, Mapped&> for a map. The key is rebuilt into
+		 * the iterator on first use, so references to it last only as long
+		 * as the iterator does and is not incremented.
+		 */
+		template <bool Const>
+		class iterator_t {
+		 public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = typename art::value_type;
+			using difference_type = std::ptrdiff_t;
+			using reference = std::conditional_t<
+			    is_set, const Key&,
+			    std::pair<const Key&,
+			              std::conditional_t<Const, const Mapped&, Mapped&>>>;
+			using pointer
+			    = std::conditional_t<is_set, const Key*, arrow_proxy<reference>>;
+
+			iterator_t() = default;
+			template <bool C = Const, typename = std::enable_if_t<C>>
+			iterator_t(const iterator_t<false>& o) noexcept
+			    : owner_(o.owner_)
+			    , leaf_(o.leaf_) {}
+
+			KBLIB_NODISCARD auto operator*() const -> reference {
+				return deref(bool_constant<is_set>{});
+			}
+			KBLIB_NODISCARD auto operator->() const -> pointer {
+				return arrow(bool_constant<is_set>{});
+			}
+			auto operator++() noexcept -> iterator_t& {
+				leaf_ = owner_->successor(leaf_);
+				return *this;
+			}
+			auto operator++(int) noexcept -> iterator_t {
+				auto tmp = *this;
+				++*this;
+				return tmp;
+			}
+
+			KBLIB_NODISCARD friend auto operator==(const iterator_t& a,
+			                                       const iterator_t& b) noexcept
+			    -> bool {
+				return a.leaf_ == b.leaf_;
+			}
+			KBLIB_NODISCARD friend auto operator!=(const iterator_t& a,
+			                                       const iterator_t& b) noexcept
+			    -> bool {
+				return a.leaf_ != b.leaf_;
+			}
+
+		 private:
+			friend class art;
+			template <bool>
+			friend class iterator_t;
+			iterator_t(const art* owner, leaf_type* l) noexcept
+			    : owner_(owner)
+			    , leaf_(l) {}
+
+			auto key() const -> const Key& {
+				if (loaded_ != leaf_) {
+					load_key(leaf_, key_);
+					loaded_ = leaf_;
+				}
+				return key_;
+			}
+			auto deref(std::true_type) const -> reference { return key(); }
+			auto deref(std::false_type) const -> reference {
+				return {key(), leaf_->value};
+			}
+			auto arrow(std::true_type) const -> pointer { return &key(); }
+			auto arrow(std::false_type) const -> pointer {
+				return {deref(std::false_type{})};
+			}
+
+			const art* owner_{};
+			leaf_type* leaf_{};
+			mutable const leaf_type* loaded_{};
+			mutable Key key_{};
+		};
+
+		art() = default;
+		art(const art& other)
+		    : art() {
+			for (auto l = other.first_leaf(); l; l = other.successor(l)) {
+				copy_leaf(*l, bool_constant<is_set>{});
+			}
+		}
+		art(art&& other) noexcept
+		    : root_(std::exchange(other.root_, nullptr))
+		    , size_(std::exchange(other.size_, 0)) {}
+		auto operator=(art other) noexcept -> art& {
+			std::swap(root_, other.root_);
+			std::swap(size_, other.size_);
+			return *this;
+		}
+		~art() { destroy(root_); }
+
+		KBLIB_NODISCARD auto size() const noexcept -> size_type { return size_; }
+		KBLIB_NODISCARD auto empty() const noexcept -> bool { return size_ == 0; }
+
+		auto clear() noexcept -> void {
+			destroy(root_);
+			root_ = nullptr;
+			size_ = 0;
+		}
+
+		/**
+		 * @brief The bytes allocated for nodes and leaves, including the key
+		 * bytes, but not anything the mapped values allocate themselves.
+		 */
+		KBLIB_NODISCARD auto memory_use() const noexcept -> std::size_t {
+			return memory_use(root_);
+		}
+
+		KBLIB_NODISCARD auto contains(const Key& key) const -> bool {
+			return find_leaf(key) != nullptr;
+		}
+		KBLIB_NODISCARD auto count(const Key& key) const -> size_type {
+			return contains(key);
+		}
+
+		/**
+		 * @brief Calls f on each element whose key starts with prefix, in
+		 * order, passing what dereferencing a const_iterator would. Unlike
+		 * iterating, this does not descend from the root for each element,
+		 * and rebuilds every key into the same object.
+		 */
+		template <typename F>
+		auto for_each_with_prefix(const Key& prefix, F f) const -> void {
+			const auto len = key_size(prefix);
+			std::size_t depth = 0;
+			node* n = root_;
+			while (n and not is_leaf(n) and depth < len) {
+				auto i = static_cast<inner*>(n);
+				const auto stored
+				    = std::min<std::size_t>(i->prefix_len, max_prefix);
+				for (std::size_t j = 0; j != stored and depth + j != len; ++j) {
+					if (i->prefix[j] != byte_at(prefix, depth + j)) {
+						return;
+					}
+				}
+				depth += i->prefix_len;
+				if (depth >= len) {
+					break;
+				}
+				auto c = find_child(i, byte_at(prefix, depth++));
+				n = c ? *c : nullptr;
+			}
+			if (not n) {
+				return;
+			}
+			// Every key below n agrees with prefix on the bytes checked so far,
+			// but prefix bytes that are not stored in nodes were skipped
+			const auto k = key_of(min_leaf(n));
+			if (k.size < len) {
+				return;
+			}
+			for (std::size_t j = 0; j != len; ++j) {
+				if (k.data[j] != byte_at(prefix, j)) {
+					return;
+				}
+			}
+			Key key{};
+			const auto visit = [&](const leaf_type* l) {
+				load_key(l, key);
+				f(element(key, l, bool_constant<is_set>{}));
+			};
+			visit_leaves(n, visit);
+		}
+
+		/**
+		 * @return size_type The number of elements removed (0 or 1).
+		 */
+		auto erase(const Key& key) -> size_type {
+			if (erase_from(root_, key, key_size(key), 0)) {
+				--size_;
+				return 1;
+			}
+			return 0;
+		}
+
+	 protected:
+		KBLIB_NODISCARD static auto key_size(const Key& key) -> std::size_t {
+			return static_cast<std::size_t>(
+			    std::distance(Extractor::begin(key), Extractor::end(key)));
+		}
+		KBLIB_NODISCARD static auto key_size(key_view key) noexcept
+		    -> std::size_t {
+			return key.size;
+		}
+		KBLIB_NODISCARD static auto byte_at(const Key& key, std::size_t i)
+		    -> std::uint8_t {
+			return static_cast<std::uint8_t>(
+			    detail_trie::slot_of<key_elem>(Extractor::index(key, i)));
+		}
+		KBLIB_NODISCARD static auto byte_at(key_view key, std::size_t i) noexcept
+		    -> std::uint8_t {
+			return key.data[i];
+		}
+		KBLIB_NODISCARD static auto key_of(const node* n) noexcept -> key_view {
+			auto l = static_cast<const leaf_type*>(n);
+			return {reinterpret_cast<const std::uint8_t*>(l) + sizeof(leaf_type),
+			        l->key_len};
+		}
+		template <typename K>
+		KBLIB_NODISCARD static auto equal(key_view a, const K& b) -> bool {
+			if (a.size != key_size(b)) {
+				return false;
+			}
+			for (std::size_t i = 0; i != a.size; ++i) {
+				if (a.data[i] != byte_at(b, i)) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static auto load_key(const leaf_type* l, Key& key) -> void {
+			const auto k = key_of(l);
+			key.clear();
+			for (std::size_t i = 0; i != k.size; ++i) {
+				key.push_back(static_cast<key_elem>(k.data[i]));
+			}
+		}
+
+		KBLIB_NODISCARD auto find_leaf(const Key& key) const -> leaf_type* {
+			const auto len = key_size(key);
+			std::size_t depth = 0;
+			node* n = root_;
+			while (n) {
+				if (is_leaf(n)) {
+					return equal(key_of(n), key) ? static_cast<leaf_type*>(n)
+					                             : nullptr;
+				}
+				auto i = static_cast<inner*>(n);
+				if (i->prefix_len) {
+					if (len - depth < i->prefix_len) {
+						return nullptr;
+					}
+					const auto stored
+					    = std::min<std::size_t>(i->prefix_len, max_prefix);
+					for (std::size_t j = 0; j != stored; ++j) {
+						if (i->prefix[j] != byte_at(key, depth + j)) {
+							return nullptr;
+						}
+					}
+					depth += i->prefix_len;
+				}
+				if (depth == len) {
+					n = i->terminal;
+					continue;
+				}
+				auto c = find_child(i, byte_at(key, depth++));
+				n = c ? *c : nullptr;
+			}
+			return nullptr;
+		}
+
+		/**
+		 * @brief Inserts a leaf for key with its value constructed from args,
+		 * unless key is present.
+		 */
+		template <typename K, typename... Args>
+		auto emplace_unique(const K& key, Args&&... args)
+		    -> std::pair<leaf_type*, bool> {
+			const auto len = key_size(key);
+			const auto make = [&] {
+				return make_leaf(key, len, std::forward<Args>(args)...);
+			};
+			const auto inserted = [&](leaf_ptr l) {
+				++size_;
+				return std::pair<leaf_type*, bool>{l.release(), true};
+			};
+			node** ref = &root_;
+			std::size_t depth = 0;
+			for (;;) {
+				node* n = *ref;
+				if (not n) {
+					auto l = make();
+					*ref = l.get();
+					return inserted(std::move(l));
+				}
+				if (is_leaf(n)) {
+					const auto other = key_of(n);
+					if (equal(other, key)) {
+						return {static_cast<leaf_type*>(n), false};
+					}
+					// Split the leaf into a node holding both keys
+					std::size_t common = 0;
+					while (depth + common < len and depth + common < other.size
+					       and byte_at(key, depth + common)
+					               == other.data[depth + common]) {
+						++common;
+					}
+					auto l = make();
+					auto split = std::make_unique<node4>();
+					set_prefix(*split, key, depth, common);
+					place(*split, other, other.size, depth + common, n);
+					place(*split, key, len, depth + common, l.get());
+					*ref = split.release();
+					return inserted(std::move(l));
+				}
+				auto i = static_cast<inner*>(n);
+				if (i->prefix_len) {
+					const auto p = prefix_mismatch(i, key, len, depth);
+					if (p < i->prefix_len) {
+						auto l = make();
+						split_prefix(ref, key, depth, p);
+						place(*static_cast<node4*>(*ref), key, len, depth + p,
+						      l.get());
+						return inserted(std::move(l));
+					}
+					depth += i->prefix_len;
+				}
+				if (depth == len) {
+					if (i->terminal) {
+						return {static_cast<leaf_type*>(i->terminal), false};
+					}
+					auto l = make();
+					i->terminal = l.get();
+					return inserted(std::move(l));
+				}
+				const auto b = byte_at(key, depth);
+				if (auto c = find_child(i, b)) {
+					ref = c;
+					++depth;
+					continue;
+				}
+				auto l = make();
+				add_child(*ref, b, l.get());
+				return inserted(std::move(l));
+			}
+		}
+
+		/**
+		 * @brief Removes the element of l, which must be in the tree.
+		 */
+		auto erase_leaf(const leaf_type* l) -> void {
+			// The key is not read again once its leaf has been freed
+			const auto key = key_of(l);
+			erase_from(root_, key, key.size, 0);
+			--size_;
+		}
+
+		auto successor(const leaf_type* l) const noexcept -> leaf_type* {
+			const auto key = key_of(l);
+			std::size_t depth = 0;
+			node* n = root_;
+			node* next = nullptr;
+			while (not is_leaf(n)) {
+				auto i = static_cast<inner*>(n);
+				depth += i->prefix_len;
+				if (depth == key.size) {
+					// l is the terminal, so every child follows it
+					if (auto c = next_child(i, -1)) {
+						next = c;
+					}
+					break;
+				}
+				const auto b = key.data[depth++];
+				if (auto c = next_child(i, b)) {
+					next = c;
+				}
+				n = *find_child(i, b);
+			}
+			return next ? static_cast<leaf_type*>(min_leaf(next)) : nullptr;
+		}
+
+		KBLIB_NODISCARD auto first_leaf() const noexcept -> leaf_type* {
+			return root_ ? static_cast<leaf_type*>(min_leaf(root_)) : nullptr;
+		}
+
+		template <bool Const>
+		KBLIB_NODISCARD auto make_iterator(leaf_type* l) const noexcept
+		    -> iterator_t<Const> {
+			return iterator_t<Const>(this, l);
+		}
+		template <bool Const>
+		KBLIB_NODISCARD static auto leaf_of(iterator_t<Const> it) noexcept
+		    -> leaf_type* {
+			return it.leaf_;
+		}
+
+	 private:
+		static auto free_leaf(leaf_type* l) noexcept -> void {
+			l->~leaf_type();
+			::operator delete(l, std::align_val_t{alignof(leaf_type)});
+		}
+		struct leaf_deleter {
+			auto operator()(leaf_type* l) const noexcept -> void { free_leaf(l); }
+		};
+		using leaf_ptr = std::unique_ptr<leaf_type, leaf_deleter>;
+
+		/**
+		 * @brief Allocates a leaf with its value constructed from args, and
+		 * the len bytes of key after it.
+		 *
+		 * @throw std::length_error if key is longer than a leaf can record.
+		 */
+		template <typename K, typename... Args>
+		static auto make_leaf(const K& key, std::size_t len, Args&&... args)
+		    -> leaf_ptr {
+			if (len > std::numeric_limits<std::uint32_t>::max()) {
+				throw std::length_error("sparse_trie: key too long");
+			}
+			void* mem = ::operator new(sizeof(leaf_type) + len,
+			                           std::align_val_t{alignof(leaf_type)});
+			leaf_ptr l;
+			try {
+				l.reset(::new (mem) leaf_type(static_cast<std::uint32_t>(len),
+				                              std::forward<Args>(args)...));
+			} catch (...) {
+				::operator delete(mem, std::align_val_t{alignof(leaf_type)});
+				throw;
+			}
+			auto bytes = static_cast<std::uint8_t*>(mem) + sizeof(leaf_type);
+			for (std::size_t i = 0; i != len; ++i) {
+				bytes[i] = byte_at(key, i);
+			}
+			return l;
+		}
+
+		auto copy_leaf(const leaf_type& l, std::true_type) -> void {
+			emplace_unique(key_of(&l));
+		}
+		auto copy_leaf(const leaf_type& l, std::false_type) -> void {
+			emplace_unique(key_of(&l), l.value);
+		}
+
+		static auto element(const Key& key, const leaf_type*,
+		                    std::true_type) noexcept -> const Key& {
+			return key;
+		}
+		template <typename L>
+		static auto element(const Key& key, L* l, std::false_type) noexcept
+		    -> std::pair<const Key&, decltype((l->value))> {
+			return {key, l->value};
+		}
+
+		template <typename F>
+		static auto visit_leaves(node* n, const F& f) -> void {
+			if (is_leaf(n)) {
+				f(static_cast<const leaf_type*>(n));
+				return;
+			}
+			auto i = static_cast<inner*>(n);
+			if (i->terminal) {
+				visit_leaves(i->terminal, f);
+			}
+			for_each_child(i, [&](node* c) { visit_leaves(c, f); });
+		}
+
+		/**
+		 * @brief Sets the prefix of n to the len bytes of key after depth.
+		 */
+		template <typename K>
+		static auto set_prefix(inner& n, const K& key, std::size_t depth,
+		                       std::size_t len) -> void {
+			n.prefix_len = static_cast<std::uint32_t>(len);
+			for (std::size_t j = 0; j != std::min(len, max_prefix); ++j) {
+				n.prefix[j] = byte_at(key, depth + j);
+			}
+		}
+
+		/**
+		 * @brief Adds n, holding key, to the node whose prefix ends at depth d.
+		 */
+		template <typename K>
+		static auto place(node4& to, const K& key, std::size_t len,
+		                  std::size_t d, node* n) -> void {
+			if (d == len) {
+				to.terminal = n;
+			} else {
+				sorted_insert(&to, byte_at(key, d), n);
+			}
+		}
+
+		/**
+		 * @brief The number of prefix bytes of n that match key after depth.
+		 * Bytes that are not stored are read from a leaf below n.
+		 */
+		template <typename K>
+		static auto prefix_mismatch(inner* n, const K& key, std::size_t len,
+		                            std::size_t depth) -> std::size_t {
+			const auto limit = std::min<std::size_t>(n->prefix_len, len - depth);
+			const auto stored = std::min(limit, max_prefix);
+			std::size_t j = 0;
+			for (; j != stored; ++j) {
+				if (n->prefix[j] != byte_at(key, depth + j)) {
+					return j;
+				}
+			}
+			if (j != limit) {
+				const auto full = key_of(min_leaf(n));
+				for (; j != limit; ++j) {
+					if (full.data[depth + j] != byte_at(key, depth + j)) {
+						return j;
+					}
+				}
+			}
+			return j;
+		}
+
+		/**
+		 * @brief Replaces *ref with a node4 whose prefix is the first p bytes
+		 * of the prefix of *ref, and which has *ref, with the rest of its
+		 * prefix, as its only child.
+		 */
+		template <typename K>
+		static auto split_prefix(node** ref, const K& key, std::size_t depth,
+		                         std::size_t p) -> void {
+			auto n = static_cast<inner*>(*ref);
+			auto split = std::make_unique<node4>();
+			// The first p bytes match key, and so can be copied from it
+			set_prefix(*split, key, depth, p);
+			key_view full{};
+			if (n->prefix_len > max_prefix) {
+				full = key_of(min_leaf(n));
+			}
+			const auto byte = [&](std::size_t j) {
+				return j < max_prefix ? n->prefix[j] : full.data[depth + j];
+			};
+			const auto b = byte(p);
+			const auto rest = n->prefix_len - p - 1;
+			std::array<std::uint8_t, max_prefix> shifted{};
+			for (std::size_t j = 0; j != std::min<std::size_t>(rest, max_prefix);
+			     ++j) {
+				shifted[j] = byte(p + 1 + j);
+			}
+			n->prefix = shifted;
+			n->prefix_len = static_cast<std::uint32_t>(rest);
+			sorted_insert(split.get(), b, n);
+			*ref = split.release();
+		}
+
+		/**
+		 * @brief Removes key from the subtree at ref, collapsing nodes left
+		 * with a single entry.
+		 *
+		 * @return bool Whether key was found.
+		 */
+		template <typename K>
+		auto erase_from(node*& ref, const K& key, std::size_t len,
+		                std::size_t depth) -> bool {
+			node* n = ref;
+			if (not n) {
+				return false;
+			}
+			if (is_leaf(n)) {
+				if (not equal(key_of(n), key)) {
+					return false;
+				}
+				free_leaf(static_cast<leaf_type*>(n));
+				ref = nullptr;
+				return true;
+			}
+			auto i = static_cast<inner*>(n);
+			if (len - depth < i->prefix_len) {
+				return false;
+			}
+			depth += i->prefix_len;
+			if (depth == len) {
+				if (not i->terminal or not equal(key_of(i->terminal), key)) {
+					return false;
+				}
+				free_leaf(static_cast<leaf_type*>(i->terminal));
+				i->terminal = nullptr;
+			} else {
+				const auto b = byte_at(key, depth);
+				auto c = find_child(i, b);
+				if (not c or not erase_from(*c, key, len, depth + 1)) {
+					return false;
+				}
+				if (*c) {
+					return true;
+				}
+				remove_child(ref, b);
+			}
+			collapse(ref);
+			return true;
+		}
+
+		/**
+		 * @brief Replaces an inner node with a single entry by that entry,
+		 * moving its prefix into the child.
+		 */
+		static auto collapse(node*& ref) -> void {
+			auto i = static_cast<inner*>(ref);
+			if (i->count + (i->terminal ? 1 : 0) > 1) {
+				return;
+			}
+			if (i->count == 0) {
+				// Leaves hold their full key, and need no prefix
+				ref = i->terminal;
+			} else {
+				// Nodes only shrink to one child by way of node4
+				auto p = static_cast<node4*>(i);
+				node* c = p->children[0];
+				if (not is_leaf(c)) {
+					auto ci = static_cast<inner*>(c);
+					std::array<std::uint8_t, max_prefix> merged{};
+					std::size_t j = 0;
+					for (; j != std::min<std::size_t>(i->prefix_len, max_prefix);
+					     ++j) {
+						merged[j] = i->prefix[j];
+					}
+					if (j < max_prefix and j == i->prefix_len) {
+						merged[j++] = p->keys[0];
+					}
+					for (std::size_t k = 0; j < max_prefix and k < ci->prefix_len;
+					     ++j, ++k) {
+						merged[j] = ci->prefix[k];
+					}
+					ci->prefix = merged;
+					ci->prefix_len += i->prefix_len + 1;
+				}
+				ref = c;
+			}
+			destroy_inner(i);
+		}
+
+		static auto destroy_inner(inner* n) noexcept -> void {
+			switch (n->type) {
+			case node_type::node4:
+				delete static_cast<node4*>(n);
+				break;
+			case node_type::node16:
+				delete static_cast<node16*>(n);
+				break;
+			case node_type::node48:
+				delete static_cast<node48*>(n);
+				break;
+			case node_type::node256:
+				delete static_cast<node256*>(n);
+				break;
+			case node_type::leaf:
+				break;
+			}
+		}
+
+		static auto destroy(node* n) noexcept -> void {
+			if (not n) {
+				return;
+			}
+			if (is_leaf(n)) {
+				free_leaf(static_cast<leaf_type*>(n));
+				return;
+			}
+			auto i = static_cast<inner*>(n);
+			destroy(i->terminal);
+			for_each_child(i, [](node* c) { destroy(c); });
+			destroy_inner(i);
+		}
+
+		static auto memory_use(node* n) noexcept -> std::size_t {
+			if (not n) {
+				return 0;
+			}
+			if (is_leaf(n)) {
+				return sizeof(leaf_type)
+				       + static_cast<const leaf_type*>(n)->key_len;
+			}
+			auto i = static_cast<inner*>(n);
+			std::size_t total = node_size(i) + memory_use(i->terminal);
+			for_each_child(i, [&](node* c) { total += memory_use(c); });
+			return total;
+		}
+
+		node* root_{};
+		size_type size_{};
+	};
+
+} // namespace detail_sparse_trie
+
+/**
+ * @brief A set of byte-string keys, stored in an adaptive radix tree.
+ *
+ * Unlike the array-mapped tries, nodes grow with the number of distinct next
+ * elements, and runs of single-child nodes are compressed, so memory use is
+ * proportional to the number of keys even when they are long and sparse,
+ * like URLs and paths. Lookup touches one node per distinct branching point.
+ *
+ * Keys iterate in lexicographic order, comparing elements as unsigned.
+ *
+ * Like trie_qset, it does not store Keys: each leaf holds the bytes of its
+ * key, and iterators rebuild the Key when dereferenced, so Key must be default
+ * constructible and support clear and push_back. References to the key are
+ * only valid while the iterator they came from is, and is not incremented.
+ */
 template <typename Key, typename Extractor = default_extract<Key>>
-class sparse_trie_set {};
+class sparse_trie_set
+    : public detail_sparse_trie::art<Key, detail_sparse_trie::no_value,
+                                     Extractor> {
+	using base
+	    = detail_sparse_trie::art<Key, detail_sparse_trie::no_value, Extractor>;
 
+ public:
+	using key_type = Key;
+	using value_type = Key;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = const value_type&;
+	using const_reference = const value_type&;
+	using pointer = const value_type*;
+	using const_pointer = const value_type*;
+	using extractor = Extractor;
+
+	using iterator = typename base::template iterator_t<true>;
+	using const_iterator = iterator;
+
+	sparse_trie_set() = default;
+	template <typename InputIt>
+	sparse_trie_set(InputIt first, InputIt last) {
+		insert(first, last);
+	}
+	sparse_trie_set(std::initializer_list<value_type> il)
+	    : sparse_trie_set(il.begin(), il.end()) {}
+
+	auto insert(const value_type& key) -> std::pair<iterator, bool> {
+		auto r = this->emplace_unique(key);
+		return {this->template make_iterator<true>(r.first), r.second};
+	}
+	template <typename InputIt>
+	auto insert(InputIt first, InputIt last) -> void {
+		for (; first != last; ++first) {
+			insert(*first);
+		}
+	}
+
+	using base::erase;
+	auto erase(const_iterator pos) -> iterator {
+		auto next = std::next(pos);
+		this->erase_leaf(this->leaf_of(pos));
+		return next;
+	}
+
+	KBLIB_NODISCARD auto find(const key_type& key) const -> const_iterator {
+		return this->template make_iterator<true>(this->find_leaf(key));
+	}
+
+	KBLIB_NODISCARD auto begin() const noexcept -> const_iterator {
+		return this->template make_iterator<true>(this->first_leaf());
+	}
+	KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+		return this->template make_iterator<true>(nullptr);
+	}
+	KBLIB_NODISCARD auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+	KBLIB_NODISCARD auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+};
+
+/**
+ * @brief A map from byte-string keys to Value, stored in an adaptive radix
+ * tree. See sparse_trie_set.
+ *
+ * As no std::pair<const Key, Value> is stored, iterators dereference to a
+ * std::pair<const Key&, Value&> proxy, the key of which is rebuilt into the
+ * iterator.
+ */
 template <typename Key, typename Value,
           typename Extractor = default_extract<Key>>
-class sparse_trie_map {};
+class sparse_trie_map
+    : public detail_sparse_trie::art<Key, Value, Extractor> {
+	using base = detail_sparse_trie::art<Key, Value, Extractor>;
+
+ public:
+	using key_type = Key;
+	using mapped_type = Value;
+	using value_type = std::pair<const Key, Value>;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using extractor = Extractor;
+
+	using iterator = typename base::template iterator_t<false>;
+	using const_iterator = typename base::template iterator_t<true>;
+	using reference = typename iterator::reference;
+	using const_reference = typename const_iterator::reference;
+	using pointer = typename iterator::pointer;
+	using const_pointer = typename const_iterator::pointer;
+
+	sparse_trie_map() = default;
+	template <typename InputIt>
+	sparse_trie_map(InputIt first, InputIt last) {
+		insert(first, last);
+	}
+	sparse_trie_map(std::initializer_list<value_type> il)
+	    : sparse_trie_map(il.begin(), il.end()) {}
+
+	template <typename... Args>
+	auto try_emplace(const key_type& key, Args&&... args)
+	    -> std::pair<iterator, bool> {
+		auto r = this->emplace_unique(key, std::forward<Args>(args)...);
+		return {this->template make_iterator<false>(r.first), r.second};
+	}
+
+	auto insert(const value_type& value) -> std::pair<iterator, bool> {
+		auto r = this->emplace_unique(value.first, value.second);
+		return {this->template make_iterator<false>(r.first), r.second};
+	}
+	template <typename InputIt>
+	auto insert(InputIt first, InputIt last) -> void {
+		for (; first != last; ++first) {
+			insert(*first);
+		}
+	}
+
+	template <typename M>
+	auto insert_or_assign(const key_type& key, M&& obj)
+	    -> std::pair<iterator, bool> {
+		auto r = this->emplace_unique(key, std::forward<M>(obj));
+		if (not r.second) {
+			r.first->value = std::forward<M>(obj);
+		}
+		return {this->template make_iterator<false>(r.first), r.second};
+	}
+
+	auto operator[](const key_type& key) -> mapped_type& {
+		return this->emplace_unique(key).first->value;
+	}
+
+	/**
+	 * @throw std::out_of_range if key is not in the map.
+	 */
+	KBLIB_NODISCARD auto at(const key_type& key) -> mapped_type& {
+		if (auto l = this->find_leaf(key)) {
+			return l->value;
+		}
+		throw std::out_of_range("sparse_trie_map: key not found");
+	}
+	KBLIB_NODISCARD auto at(const key_type& key) const -> const mapped_type& {
+		if (auto l = this->find_leaf(key)) {
+			return l->value;
+		}
+		throw std::out_of_range("sparse_trie_map: key not found");
+	}
+
+	using base::erase;
+	auto erase(const_iterator pos) -> iterator {
+		const auto next = this->leaf_of(std::next(pos));
+		this->erase_leaf(this->leaf_of(pos));
+		return this->template make_iterator<false>(next);
+	}
+
+	KBLIB_NODISCARD auto find(const key_type& key) -> iterator {
+		return this->template make_iterator<false>(this->find_leaf(key));
+	}
+	KBLIB_NODISCARD auto find(const key_type& key) const -> const_iterator {
+		return this->template make_iterator<true>(this->find_leaf(key));
+	}
+
+	KBLIB_NODISCARD auto begin() noexcept -> iterator {
+		return this->template make_iterator<false>(this->first_leaf());
+	}
+	KBLIB_NODISCARD auto begin() const noexcept -> const_iterator {
+		return this->template make_iterator<true>(this->first_leaf());
+	}
+	KBLIB_NODISCARD auto end() noexcept -> iterator {
+		return this->template make_iterator<false>(nullptr);
+	}
+	KBLIB_NODISCARD auto end() const noexcept -> const_iterator {
+		return this->template make_iterator<true>(nullptr);
+	}
+	KBLIB_NODISCARD auto cbegin() const noexcept -> const_iterator {
+		return begin();
+	}
+	KBLIB_NODISCARD auto cend() const noexcept -> const_iterator {
+		return end();
+	}
+};
 
 } // namespace KBLIB_NS
 
@@ -3,7 +3,13 @@
 #include "catch2/catch.hpp"
 #include "kblib/hash.h"
 
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 template <typename T>
 struct print;
@@ -66,10 +72,114 @@ static_assert(
 TEST_CASE("test_trie") {
 	kblib::compact_bit_trie<unsigned short, 1024, int> test;
 	REQUIRE(test.insert({0b1000100010000000, 10}, 1));
-	// has UB, so I hardcoded a test failure as a reminder
-	// std::cout<<test.at({0b1000100010000000, 10})<<'\n';
-	/// TODO(killerbee13): fix compact_bit_trie::at
-	REQUIRE(not +"test.at({0b1000100010000000, 10}) has UB");
+	REQUIRE(not test.insert({0b1000100010111111, 10}, 2));
+	REQUIRE(test.at({0b1000100010000000, 10}) == 1);
+	REQUIRE_THROWS_AS(test.at({0b1000100000000000, 9}), std::out_of_range);
+	REQUIRE_THROWS_AS(test.at({0, 17}), std::invalid_argument);
+
+	REQUIRE(test.insert({0b1000000000000000, 2}, 2));
+	REQUIRE(test.insert({0b1000100010110000, 12}, 3));
+	test.insert_or_assign({0b1000000000000000, 2}, 4);
+	REQUIRE(test.size() == 3);
+	REQUIRE(test.at({0b1000000000000000, 2}) == 4);
+	REQUIRE(test.find_deep({0b1000100010110101, 16}) == 3);
+	REQUIRE(test.find_deep({0b1000100010110101, 16}, 1) == 4);
+	REQUIRE(test.find_deep({0b1000100010000000, 11}) == 1);
+	REQUIRE_THROWS_AS(test.find_deep({0b0000000000000000, 16}),
+	                  std::out_of_range);
+}
+
+TEST_CASE("compact_bit_trie prefixes") {
+	// An IPv4 routing table
+	using table = kblib::compact_bit_trie<std::uint32_t, UINT32_MAX, int>;
+	table routes;
+	routes.insert({0, 0}, 0);
+	routes.insert({0x0A000000, 8}, 1);       // 10.0.0.0/8
+	routes.insert({0x0A010000, 16}, 2);      // 10.1.0.0/16
+	routes.insert({0x0A010200, 24}, 3);      // 10.1.2.0/24
+	routes.insert({0x0A800000, 9}, 4);       // 10.128.0.0/9
+	routes.insert({0xC0A80000, 16}, 5);      // 192.168.0.0/16
+	routes.insert({0xC0A80101, 32}, 6);      // 192.168.1.1/32
+	REQUIRE(routes.size() == 7);
+
+	SECTION("longest prefix match") {
+		const auto& c = routes;
+		auto it = c.longest_prefix_match(0x0A010203);
+		REQUIRE(*it == 3);
+		REQUIRE(it.key().prefix == 0x0A010200);
+		REQUIRE(it.key().bits == 24);
+		REQUIRE(*c.longest_prefix_match(0x0A01FF00) == 2);
+		REQUIRE(*c.longest_prefix_match(0x0AFF0000) == 4);
+		REQUIRE(*c.longest_prefix_match(0x0B000000) == 0);
+		REQUIRE(*c.longest_prefix_match(0xC0A80101) == 6);
+		REQUIRE(*c.longest_prefix_match(0xC0A80102) == 5);
+
+		*routes.longest_prefix_match(0x0A000001) = 10;
+		REQUIRE(routes.at({0x0A000000, 8}) == 10);
+
+		table empty;
+		REQUIRE(empty.longest_prefix_match(0x0A010203) == empty.end());
+		REQUIRE(empty.find({0x0A000000, 8}) == empty.end());
+		REQUIRE(std::as_const(empty).find({}) == empty.cend());
+		empty.insert({0x0A000000, 8}, 1);
+		REQUIRE(empty.longest_prefix_match(0x0B000000) == empty.end());
+		REQUIRE(empty.find({0x0A000000, 8}) != empty.end());
+		routes.clear();
+		REQUIRE(routes.find({0x0A000000, 8}) == routes.end());
+	}
+	SECTION("iteration") {
+		std::vector<int> order(routes.begin(), routes.end());
+		REQUIRE(order == std::vector<int>{0, 1, 2, 3, 4, 5, 6});
+		std::vector<int> reversed(routes.rbegin(), routes.rend());
+		REQUIRE(reversed == std::vector<int>{6, 5, 4, 3, 2, 1, 0});
+		for (auto it = routes.cbegin(); it != routes.cend(); ++it) {
+			REQUIRE(routes.find(it.key()) == it);
+		}
+	}
+	SECTION("prefix range") {
+		auto r = routes.prefix_range({0x0A000000, 8});
+		REQUIRE(std::vector<int>(r.first, r.second)
+		        == std::vector<int>{1, 2, 3, 4});
+		r = routes.prefix_range({0x0A000000, 12});
+		REQUIRE(std::vector<int>(r.first, r.second)
+		        == std::vector<int>{2, 3});
+		r = routes.prefix_range({0xC0A80100, 24});
+		REQUIRE(std::vector<int>(r.first, r.second) == std::vector<int>{6});
+		r = routes.prefix_range({0x0B000000, 8});
+		REQUIRE(r.first == r.second);
+		r = routes.prefix_range({0, 0});
+		REQUIRE(std::distance(r.first, r.second) == 7);
+	}
+	SECTION("shrink_to_fit") {
+		auto compact = routes;
+		compact.shrink_to_fit();
+		const auto same = [&] {
+			REQUIRE(std::equal(routes.begin(), routes.end(), compact.begin(),
+			                   compact.end()));
+			REQUIRE(std::equal(routes.rbegin(), routes.rend(), compact.rbegin(),
+			                   compact.rend()));
+			std::uint32_t addr = 0x0A010203;
+			for (int i = 0; i != 10000; ++i) {
+				addr = addr * 1664525u + 1013904223u;
+				// Half of the addresses fall inside 10.0.0.0/8
+				const auto a = i % 2 ? addr : (addr >> 8u) | 0x0A000000u;
+				REQUIRE(*routes.longest_prefix_match(a)
+				        == *compact.longest_prefix_match(a));
+			}
+			for (const std::uint16_t bits :
+			     std::initializer_list<std::uint16_t>{0, 4, 8, 9, 16, 24, 32}) {
+				const auto r1 = routes.prefix_range({0x0A010200, bits});
+				const auto r2 = compact.prefix_range({0x0A010200, bits});
+				REQUIRE(std::equal(r1.first, r1.second, r2.first, r2.second));
+			}
+		};
+		same();
+		routes.insert({0x0A010280, 25}, 7);
+		compact.insert({0x0A010280, 25}, 7);
+		same();
+		compact.shrink_to_fit();
+		same();
+	}
 }
 #endif
 
@@ -0,0 +1,122 @@
+#include "kblib/bloom_filter.h"
+
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename Filter>
+auto false_positive_rate(const Filter& f, std::uint64_t first,
+                         std::uint64_t count) -> double {
+	std::size_t hits = 0;
+	for (auto k = first; k != first + count; ++k) {
+		hits += f.contains(k);
+	}
+	return static_cast<double>(hits) / static_cast<double>(count);
+}
+
+} // namespace
+
+TEMPLATE_TEST_CASE("bloom_filter", "", kblib::bloom_filter<std::uint64_t>,
+                   kblib::blocked_bloom_filter<std::uint64_t>) {
+	constexpr std::size_t n = 100000;
+	TestType filter(n, 0.01);
+	std::vector<std::uint64_t> keys(n);
+	for (std::size_t i = 0; i != n; ++i) {
+		keys[i] = i * 0x9e3779b97f4a7c15u;
+	}
+	// Iterators, pointers (which are hashed in batches), and single keys
+	filter.insert(keys.begin(), keys.begin() + n / 4);
+	filter.insert(keys.data() + n / 4, keys.data() + n / 2);
+	for (auto it = keys.begin() + n / 2; it != keys.end(); ++it) {
+		filter.insert(*it);
+	}
+
+	// No false negatives, by either lookup
+	for (auto k : keys) {
+		REQUIRE(filter.contains(k));
+	}
+	std::vector<char> found(n);
+	filter.contains(keys.begin(), keys.end(), found.begin());
+	CHECK(std::count(found.begin(), found.end(), 1) == n);
+	std::fill(found.begin(), found.end(), 0);
+	const auto* p = keys.data();
+	filter.contains(p, p + n, found.begin());
+	CHECK(std::count(found.begin(), found.end(), 1) == n);
+
+	// Keys 1..n were not inserted (only key 0 was)
+	const double fpr = false_positive_rate(filter, 1, n);
+	CHECK(fpr < 0.015);
+	CHECK(fpr > 0.001);
+
+	SECTION("serialization") {
+		const auto bytes = filter.serialize();
+		CHECK(bytes.size() == 64 + filter.bit_count() / 8);
+		auto copy = TestType::deserialize(bytes.data(), bytes.size());
+		CHECK(copy.hash_count() == filter.hash_count());
+		CHECK(copy.bit_count() == filter.bit_count());
+		CHECK(copy.serialize() == bytes);
+
+		// A view reads the buffer in place, as it would a mapped file, which
+		// is page aligned
+		struct alignas(64) line {
+			unsigned char bytes[64];
+		};
+		std::vector<line> aligned(bytes.size() / 64 + 1);
+		std::memcpy(aligned.data(), bytes.data(), bytes.size());
+		using view_type = kblib::basic_bloom_filter_view<
+		    std::uint64_t, kblib::FNV_hash<std::uint64_t, std::uint64_t>,
+		    std::conditional_t<
+		        std::is_same<TestType,
+		                     kblib::bloom_filter<std::uint64_t>>::value,
+		        kblib::detail_bloom::plain_layout,
+		        kblib::detail_bloom::blocked_layout>>;
+		view_type view(aligned.data(), bytes.size());
+		for (auto k : keys) {
+			REQUIRE(view.contains(k));
+		}
+		CHECK(false_positive_rate(view, 1, n) == fpr);
+		// 8-byte alignment is not enough for the cache-line-sized blocks
+		auto* const shifted
+		    = reinterpret_cast<unsigned char*>(aligned.data()) + 8;
+		std::memmove(shifted, aligned.data(), bytes.size());
+		CHECK_THROWS_AS(view_type(shifted, bytes.size()), std::invalid_argument);
+
+		CHECK_THROWS_AS(TestType::deserialize(bytes.data(), 63),
+		                std::invalid_argument);
+		CHECK_THROWS_AS(
+		    TestType::deserialize(bytes.data(), bytes.size() - 64),
+		    std::invalid_argument);
+		auto corrupt = bytes;
+		corrupt[0] = 'x';
+		CHECK_THROWS_AS(TestType::deserialize(corrupt.data(), corrupt.size()),
+		                std::invalid_argument);
+	}
+
+	SECTION("merge and clear") {
+		TestType other(n, 0.01);
+		other.insert(std::uint64_t{1});
+		filter.merge(other);
+		CHECK(filter.contains(1));
+		CHECK_THROWS_AS(filter.merge(TestType(10, 0.01)), std::invalid_argument);
+		filter.clear();
+		CHECK(false_positive_rate(filter, 0, 1000) == 0);
+	}
+}
+
+TEST_CASE("bloom_filter of strings") {
+	kblib::blocked_bloom_filter<std::string> filter(1000);
+	filter.insert("apple");
+	filter.insert("banana");
+	CHECK(filter.contains("apple"));
+	CHECK(filter.contains("banana"));
+	CHECK(filter.hash_count() == 8);
+	// Filters of different layouts cannot read each other
+	const auto bytes = filter.serialize();
+	CHECK_THROWS_AS(
+	    kblib::bloom_filter<std::string>::deserialize(bytes.data(), bytes.size()),
+	    std::invalid_argument);
+}
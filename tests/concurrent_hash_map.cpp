@@ -0,0 +1,66 @@
+#include "kblib/concurrent_hash_map.h"
+
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if KBLIB_USE_CXX17
+
+TEST_CASE("concurrent_hash_map") {
+	kblib::concurrent_hash_map<std::string, int> map(4);
+	CHECK(map.shard_count() == 4);
+	CHECK(map.empty());
+	CHECK(map.try_emplace("a", 1));
+	CHECK_FALSE(map.try_emplace("a", 2));
+	CHECK(map.find("a") == 1);
+	CHECK(map.find(std::string_view("a")) == 1);
+	CHECK(map.find("b") == std::nullopt);
+	CHECK_FALSE(map.insert_or_assign(std::string("a"), 3));
+	CHECK(map.visit("a", [](int& v) { v *= 2; }));
+	CHECK_FALSE(map.visit("b", [](int&) { FAIL(); }));
+	int seen = 0;
+	CHECK(map.cvisit("a", [&](const int& v) { seen = v; }));
+	CHECK(seen == 6);
+	CHECK(map.erase("a") == 1);
+	CHECK(map.erase("a") == 0);
+	CHECK(map.size() == 0);
+
+	SECTION("concurrent counting") {
+		// Every thread counts every word, so each count must reach the number
+		// of threads exactly
+		constexpr int threads = 8;
+		constexpr int words = 5000;
+		// Catch assertions are not thread-safe, so failures are only counted
+		std::atomic<int> missing{0};
+		std::vector<std::thread> pool;
+		for (int t = 0; t != threads; ++t) {
+			pool.emplace_back([&map, &missing, t] {
+				for (int i = 0; i != words; ++i) {
+					const auto word = std::to_string((i * 7 + t * 1009) % words);
+					map.try_emplace_or_visit(word, [](int& c) { ++c; }, 1);
+					missing += not map.contains(word);
+				}
+			});
+		}
+		for (auto& th : pool) {
+			th.join();
+		}
+		CHECK(missing == 0);
+		CHECK(map.size() == words);
+		int total = 0;
+		map.cvisit_all([&](const std::pair<const std::string, int>& v) {
+			REQUIRE(v.second == threads);
+			total += v.second;
+		});
+		CHECK(total == threads * words);
+		map.visit_all([](std::pair<const std::string, int>& v) { v.second = 0; });
+		CHECK(map.find("42") == 0);
+		map.clear();
+		CHECK(map.empty());
+	}
+}
+
+#endif
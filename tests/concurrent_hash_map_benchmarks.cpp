@@ -0,0 +1,104 @@
+#include "kblib/concurrent_hash_map.h"
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if KBLIB_USE_CXX17
+
+namespace {
+
+// Each thread performs this many operations per run
+constexpr std::size_t ops_per_thread = 1 << 16;
+// Keys are drawn from this many distinct values, so threads collide on keys
+constexpr std::uint64_t key_space = 1 << 18;
+
+auto make_keys(std::size_t thread) -> std::vector<std::uint64_t> {
+	std::mt19937_64 rng{thread};
+	std::vector<std::uint64_t> keys(ops_per_thread);
+	for (auto& k : keys) {
+		k = rng() % key_space;
+	}
+	return keys;
+}
+
+template <typename F>
+auto run_threads(std::size_t threads, F f) -> void {
+	std::vector<std::thread> pool;
+	for (std::size_t t = 0; t != threads; ++t) {
+		pool.emplace_back(f, t);
+	}
+	for (auto& th : pool) {
+		th.join();
+	}
+}
+
+} // namespace
+
+TEST_CASE("concurrent_hash_map contention", "[.][benchmark]") {
+	const std::size_t max_threads
+	    = std::max(std::thread::hardware_concurrency(), 1u);
+	for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+		std::vector<std::vector<std::uint64_t>> keys;
+		for (std::size_t t = 0; t != threads; ++t) {
+			keys.push_back(make_keys(t));
+		}
+		const auto suffix = ", " + std::to_string(threads) + " threads";
+
+		// The baseline this replaces: one map behind one mutex
+		BENCHMARK_ADVANCED("hash_map + mutex, ingest" + suffix)
+		(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] {
+				kblib::hash_map<std::uint64_t, std::uint64_t> map;
+				std::mutex mutex;
+				run_threads(threads, [&](std::size_t t) {
+					for (auto k : keys[t]) {
+						std::lock_guard<std::mutex> lock(mutex);
+						++map[k];
+					}
+				});
+				return map.size();
+			});
+		};
+		BENCHMARK_ADVANCED("concurrent_hash_map, ingest" + suffix)
+		(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] {
+				kblib::concurrent_hash_map<std::uint64_t, std::uint64_t> map;
+				run_threads(threads, [&](std::size_t t) {
+					for (auto k : keys[t]) {
+						map.try_emplace_or_visit(
+						    k, [](std::uint64_t& c) { ++c; }, 1u);
+					}
+				});
+				return map.size();
+			});
+		};
+
+		kblib::concurrent_hash_map<std::uint64_t, std::uint64_t> filled;
+		for (std::uint64_t k = 0; k < key_space; k += 2) {
+			filled.try_emplace(k, k);
+		}
+		BENCHMARK_ADVANCED("concurrent_hash_map, find" + suffix)
+		(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] {
+				std::atomic<std::size_t> found{0};
+				run_threads(threads, [&](std::size_t t) {
+					std::size_t local = 0;
+					for (auto k : keys[t]) {
+						local += filled.contains(k);
+					}
+					found += local;
+				});
+				return found.load();
+			});
+		};
+	}
+}
+
+#endif
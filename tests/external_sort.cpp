@@ -0,0 +1,121 @@
+#include "catch2/catch.hpp"
+
+#include "kblib/external_sort.h"
+
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#if KBLIB_USE_CXX17
+
+namespace {
+
+struct temp_dir {
+	temp_dir()
+	    : path(std::filesystem::temp_directory_path()
+	           / ("kblib-external-sort-test-"
+	              + std::to_string(std::random_device{}()))) {
+		std::filesystem::create_directories(path);
+	}
+	~temp_dir() { std::filesystem::remove_all(path); }
+
+	auto empty() const -> bool {
+		return std::filesystem::directory_iterator(path)
+		       == std::filesystem::directory_iterator();
+	}
+
+	std::filesystem::path path;
+};
+
+} // namespace
+
+TEST_CASE("external_sort") {
+	std::minstd_rand rng{std::random_device{}()};
+	temp_dir dir;
+	kblib::external_sort_options options;
+	options.temp_directory = dir.path;
+
+	SECTION("integers, in memory") {
+		std::uniform_int_distribution<int> dist(-1000000, 1000000);
+		std::vector<int> input(10000);
+		std::generate(input.begin(), input.end(), [&] { return dist(rng); });
+		auto expected = input;
+		std::sort(expected.begin(), expected.end());
+
+		std::vector<int> output;
+		kblib::external_sort(input.begin(), input.end(),
+		                     std::back_inserter(output), std::less<>{}, options);
+		CHECK(output == expected);
+		CHECK(dir.empty());
+	}
+	SECTION("integers, with several merge passes") {
+		std::uniform_int_distribution<int> dist(-1000000, 1000000);
+		std::vector<int> input(100000);
+		std::generate(input.begin(), input.end(), [&] { return dist(rng); });
+		auto expected = input;
+		std::sort(expected.begin(), expected.end(), std::greater<>{});
+
+		// 100 runs of ~500 records, merged 4 at a time
+		options.memory_budget = 4096;
+		options.io_buffer_size = 1024;
+		std::vector<int> output(input.size());
+		auto last = kblib::external_sort(input.begin(), input.end(),
+		                                 output.begin(), std::greater<>{},
+		                                 options);
+		CHECK(last == output.end());
+		CHECK(output == expected);
+		CHECK(dir.empty());
+	}
+	SECTION("log lines by a computed key, from a stream") {
+		std::uniform_int_distribution<int> dist(0, 5000);
+		std::ostringstream log;
+		std::vector<std::string> lines;
+		for (int i = 0; i < 20000; ++i) {
+			lines.push_back(std::to_string(dist(rng)) + ":event-"
+			                + std::to_string(i));
+			log << lines.back() << '\n';
+		}
+		auto key = [](const std::string& line) {
+			return std::stoi(line.substr(0, line.find(':')));
+		};
+		auto expected = lines;
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [&](const std::string& a, const std::string& b) {
+			                 return key(a) < key(b);
+		                 });
+
+		options.memory_budget = 16384;
+		options.io_buffer_size = 256;
+		std::istringstream in(log.str());
+		std::vector<std::string> output;
+		kblib::external_sort_transform(std::istream_iterator<std::string>(in),
+		                               std::istream_iterator<std::string>(),
+		                               std::back_inserter(output), key,
+		                               std::less<>{}, options);
+		CHECK(output == expected);
+		CHECK(dir.empty());
+	}
+	SECTION("default temporary directory") {
+		CHECK(kblib::external_sort_options{}.temp_directory.empty());
+		std::vector<int> input(5000);
+		std::iota(input.begin(), input.end(), 0);
+		std::reverse(input.begin(), input.end());
+
+		options.temp_directory.clear();
+		options.memory_budget = 4096;
+		options.io_buffer_size = 1024;
+		std::vector<int> output;
+		kblib::external_sort(input.begin(), input.end(),
+		                     std::back_inserter(output), std::less<>{}, options);
+		CHECK(std::is_sorted(output.begin(), output.end()));
+		CHECK(output.size() == input.size());
+	}
+	SECTION("empty input") {
+		std::vector<std::string> input, output;
+		kblib::external_sort(input.begin(), input.end(),
+		                     std::back_inserter(output), std::less<>{}, options);
+		CHECK(output.empty());
+	}
+}
+
+#endif
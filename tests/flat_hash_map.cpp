@@ -0,0 +1,291 @@
+#include "kblib/flat_hash_map.h"
+
+#include "catch2/catch.hpp"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+TEST_CASE("flat_hash_map") {
+	kblib::flat_hash_map<std::string, int> map;
+	REQUIRE(map.empty());
+	REQUIRE(map.begin() == map.end());
+	REQUIRE(map.find("a") == map.end());
+	REQUIRE_FALSE(map.contains("a"));
+	REQUIRE(map.erase("a") == 0);
+
+	SECTION("insertion and lookup") {
+		map["a"] = 1;
+		CHECK(map.insert({"b", 2}).second);
+		CHECK_FALSE(map.insert({"b", 3}).second);
+		CHECK(map.try_emplace("c", 3).second);
+		CHECK_FALSE(map.try_emplace("c", 4).second);
+		CHECK_FALSE(map.insert_or_assign("c", 5).second);
+		CHECK(map.emplace("d", 4).second);
+		REQUIRE(map.size() == 4);
+		CHECK(map.at("a") == 1);
+		CHECK(map.at("b") == 2);
+		CHECK(map.at("c") == 5);
+		CHECK(map.find("d")->second == 4);
+		CHECK(map.count("d") == 1);
+		CHECK_THROWS_AS(map.at("e"), std::out_of_range);
+
+		// Transparent lookup does not construct a std::string
+		CHECK(map.contains(std::string_view("a")));
+		CHECK(map.at(std::string_view("b")) == 2);
+		CHECK(map.equal_range(std::string_view("c")).first == map.find("c"));
+		CHECK(std::distance(map.equal_range("c").first,
+		                    map.equal_range("c").second)
+		      == 1);
+
+		std::map<std::string, int> seen(map.begin(), map.end());
+		CHECK(seen == std::map<std::string, int>{
+		                  {"a", 1}, {"b", 2}, {"c", 5}, {"d", 4}});
+	}
+
+	SECTION("copy and move") {
+		for (int i = 0; i < 100; ++i) {
+			map[std::to_string(i)] = i;
+		}
+		auto copy = map;
+		CHECK(copy == map);
+		copy["0"] = -1;
+		CHECK(copy != map);
+		auto moved = std::move(copy);
+		CHECK(moved.size() == 100);
+		CHECK(moved.at("0") == -1);
+		CHECK(copy.empty()); // NOLINT(bugprone-use-after-move)
+		copy = moved;
+		CHECK(copy == moved);
+		copy.clear();
+		CHECK(copy.empty());
+		CHECK(copy.begin() == copy.end());
+		copy["x"] = 1;
+		CHECK(copy.size() == 1);
+	}
+
+	SECTION("reserve and rehash") {
+		map.reserve(1000);
+		const auto cap = map.capacity();
+		CHECK(cap >= 1000);
+		for (int i = 0; i < 1000; ++i) {
+			map[std::to_string(i)] = i;
+		}
+		CHECK(map.capacity() == cap);
+		CHECK(map.load_factor() <= map.max_load_factor());
+		for (int i = 0; i < 990; ++i) {
+			map.erase(std::to_string(i));
+		}
+		map.rehash(0);
+		CHECK(map.capacity() < cap);
+		CHECK(map.size() == 10);
+		CHECK(map.at("995") == 995);
+		map.clear();
+		map.rehash(0);
+		CHECK(map.capacity() == 0);
+		CHECK(map.find("1") == map.end());
+	}
+}
+
+namespace {
+
+struct counted_key {
+	static int copies;
+
+	int v;
+
+	counted_key(int x) noexcept
+	    : v(x) {}
+	counted_key(const counted_key& o) noexcept
+	    : v(o.v) {
+		++copies;
+	}
+	counted_key(counted_key&&) noexcept = default;
+
+	friend auto operator==(const counted_key& a, const counted_key& b) noexcept
+	    -> bool {
+		return a.v == b.v;
+	}
+};
+int counted_key::copies = 0;
+
+// Data members in both base and derived make this not standard-layout
+struct key_base {
+	int v;
+};
+struct derived_key : key_base {
+	int unused = 0;
+
+	derived_key(int x) noexcept
+	    : key_base{x} {}
+
+	friend auto operator==(const derived_key& a, const derived_key& b) noexcept
+	    -> bool {
+		return a.v == b.v;
+	}
+};
+
+struct v_hash {
+	template <typename K>
+	auto operator()(const K& k) const noexcept -> std::size_t {
+		return std::hash<int>{}(k.v);
+	}
+};
+
+template <typename Key>
+auto check_relocation() -> void {
+	kblib::flat_hash_map<Key, std::unique_ptr<int>, v_hash> map;
+	for (int i = 0; i != 1000; ++i) {
+		map.try_emplace(i, std::make_unique<int>(i));
+	}
+	REQUIRE(map.size() == 1000);
+	for (int i = 0; i != 1000; ++i) {
+		const auto it = map.find(i);
+		REQUIRE(it != map.end());
+		CHECK(*it->second == i);
+	}
+}
+
+} // namespace
+
+TEST_CASE("flat_hash_map relocates elements when rehashing") {
+	SECTION("keys are moved") {
+		counted_key::copies = 0;
+		check_relocation<counted_key>();
+		CHECK(counted_key::copies == 0);
+	}
+	SECTION("keys are copied if they can not be moved") {
+		check_relocation<derived_key>();
+	}
+}
+
+TEST_CASE("flat_hash_map agrees with std::unordered_map") {
+	// Heavy insert/erase churn exercises tombstones and in-place rehashing
+	std::mt19937 rng{1};
+	std::uniform_int_distribution<int> key(0, 2000);
+	kblib::flat_hash_map<int, int> map;
+	std::unordered_map<int, int> ref;
+	for (int i = 0; i < 200000; ++i) {
+		const auto k = key(rng);
+		switch (rng() % 4) {
+		case 0:
+		case 1:
+			map[k] = i;
+			ref[k] = i;
+			break;
+		case 2:
+			REQUIRE(map.erase(k) == ref.erase(k));
+			break;
+		case 3: {
+			auto it = map.find(k);
+			auto rit = ref.find(k);
+			REQUIRE((it == map.end()) == (rit == ref.end()));
+			if (it != map.end()) {
+				REQUIRE(it->second == rit->second);
+				if (i % 2) {
+					map.erase(it);
+					ref.erase(rit);
+				}
+			}
+		} break;
+		}
+		REQUIRE(map.size() == ref.size());
+	}
+	std::size_t visited = 0;
+	for (const auto& v : map) {
+		REQUIRE(ref.at(v.first) == v.second);
+		++visited;
+	}
+	CHECK(visited == ref.size());
+	// The table only grew as far as the live elements require
+	CHECK(map.capacity() <= 8191);
+
+	// Erasing while iterating
+	for (auto it = map.begin(); it != map.end();) {
+		if (it->first % 2) {
+			it = map.erase(it);
+		} else {
+			++it;
+		}
+	}
+	for (const auto& v : map) {
+		REQUIRE(v.first % 2 == 0);
+	}
+}
+
+TEST_CASE("flat_hash_set") {
+	kblib::flat_hash_set<std::string> set{"a", "b", "c"};
+	CHECK(set.size() == 3);
+	CHECK(set.contains("a"));
+	CHECK(set.contains(std::string_view("c")));
+	CHECK_FALSE(set.insert("a").second);
+	CHECK(set.insert("d").second);
+	CHECK(set.erase("b") == 1);
+	CHECK(set == kblib::flat_hash_set<std::string>{"d", "c", "a"});
+	static_assert(std::is_same<decltype(set)::iterator,
+	                           decltype(set)::const_iterator>::value,
+	              "set elements must not be modifiable");
+
+	kblib::flat_hash_set<int, kblib::mix_hash<>> ints;
+	for (int i = 0; i < 10000; ++i) {
+		ints.insert(i * 7);
+	}
+	CHECK(ints.size() == 10000);
+	for (int i = 0; i < 70000; ++i) {
+		REQUIRE(ints.contains(i) == (i % 7 == 0));
+	}
+}
+
+TEST_CASE("flat_hash_multimap") {
+	kblib::flat_hash_multimap<std::string, int> index{
+	    {"a", 1}, {"b", 2}, {"a", 3}, {"c", 4}, {"a", 5}};
+	CHECK(index.size() == 5);
+	CHECK(index.key_count() == 3);
+	CHECK(index.count("a") == 3);
+	CHECK(index.count(std::string_view("b")) == 1);
+	CHECK(index.count("d") == 0);
+
+	// Values of a key are adjacent, in insertion order
+	auto r = index.equal_range("a");
+	CHECK(std::vector<int>(r.first, r.second) == std::vector<int>{1, 3, 5});
+	CHECK(&*std::prev(r.second) - &*r.first == 2);
+	auto none = index.equal_range("d");
+	CHECK(none.first == none.second);
+
+	*index.emplace("b", 6) += 1;
+	r = index.equal_range("b");
+	CHECK(std::vector<int>(r.first, r.second) == std::vector<int>{2, 7});
+
+	r = index.equal_range("a");
+	auto next = index.erase("a", std::next(r.first));
+	CHECK(*next == 5);
+	CHECK(index.count("a") == 2);
+	CHECK(index.size() == 5);
+	CHECK(index.erase("a") == 2);
+	CHECK_FALSE(index.contains("a"));
+	CHECK(index.size() == 3);
+	index.erase("c", index.equal_range("c").first);
+	CHECK_FALSE(index.contains("c"));
+	CHECK(index.size() == 2);
+	r = index.equal_range("b");
+	CHECK(index.erase("b", std::prev(r.second))
+	      == decltype(index)::mapped_iterator{});
+	CHECK(index.count("b") == 1);
+	CHECK(index.size() == 1);
+
+	std::size_t values = 0;
+	for (const auto& group : index) {
+		values += group.second.size();
+	}
+	CHECK(values == index.size());
+
+	auto copy = index;
+	CHECK(copy == index);
+	copy.insert({"z", 0});
+	CHECK(copy != index);
+	copy.clear();
+	CHECK(copy.empty());
+	CHECK(copy.begin() == copy.end());
+}
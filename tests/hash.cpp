@@ -2,10 +2,13 @@
 
 #include "catch2/catch.hpp"
 
+#include <bitset>
 #include <deque>
 #include <map>
 #include <set>
+#include <sstream>
 #include <unordered_map>
+#include <vector>
 
 struct has_padding {
 	char c;
@@ -168,3 +171,307 @@ TEST_CASE("FNV_hash (32 bit)") {
 	            == test_var_hash(decltype(var){std::in_place_index<0>, 42}));
 #endif
 }
+
+TEST_CASE("FNVa_bulk") {
+	std::string input;
+	for (int i = 0; i < 4099; ++i) {
+		input.push_back(static_cast<char>(i * 37 + i / 256));
+	}
+	auto bulk = [](const std::string& s, std::size_t n) {
+		return kblib::FNVa_bulk<std::uint64_t>(s.data(), n);
+	};
+
+	SECTION("short inputs are standard FNV-1a") {
+		for (std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{31},
+		                      kblib::fnv::bulk_threshold - 1}) {
+			CHECK(bulk(input, n) == kblib::FNVa_s<std::uint64_t>(input.data(), n));
+		}
+		CHECK(kblib::FNV_hash<std::string>{}("abc")
+		      == kblib::FNVa<std::size_t>(std::string("abc")));
+	}
+	SECTION("long inputs use the lanes") {
+		for (std::size_t n : {kblib::fnv::bulk_threshold,
+		                      kblib::fnv::bulk_threshold + 1, input.size()}) {
+			CHECK(bulk(input, n)
+			      == kblib::FNVa_lanes<std::uint64_t>(input.data(), n));
+			CHECK(kblib::FNVa_lanes<std::uint32_t>(input.data(), n)
+			      != kblib::FNVa_lanes<std::uint32_t>(input.data(), n - 1));
+		}
+	}
+	SECTION("every byte affects the hash") {
+		const auto h = bulk(input, input.size());
+		for (std::size_t i = 0; i < input.size(); i += 7) {
+			auto copy = input;
+			copy[i] ^= 1;
+			CHECK(bulk(copy, copy.size()) != h);
+		}
+		// Swapping the stripes of two lanes changes the hash
+		auto swapped = input;
+		std::swap_ranges(swapped.begin(), swapped.begin() + 8,
+		                 swapped.begin() + 8);
+		CHECK(bulk(swapped, swapped.size()) != h);
+	}
+	SECTION("the offset is used") {
+		CHECK(kblib::FNVa_lanes<std::uint64_t>(input.data(), input.size(), 1)
+		      != kblib::FNVa_lanes<std::uint64_t>(input.data(), input.size(), 2));
+	}
+	SECTION("contiguous containers agree") {
+		std::vector<char> v(input.begin(), input.end());
+		const auto h = kblib::FNV_hash<std::string>{}(input);
+		CHECK(kblib::FNV_hash<std::vector<char>>{}(v) == h);
+#if KBLIB_USE_CXX17
+		CHECK(kblib::FNV_hash<std::string_view>{}(input) == h);
+#endif
+		CHECK(kblib::FNV_hash<>{}(input) == h);
+		CHECK(h == bulk(input, input.size()));
+
+		std::vector<std::uint32_t> words(1000);
+		std::iota(words.begin(), words.end(), 0u);
+		CHECK(kblib::FNV_hash<std::vector<std::uint32_t>>{}(words)
+		      == kblib::FNVa_bulk<std::size_t>(
+		          reinterpret_cast<const char*>(words.data()),
+		          words.size() * sizeof(std::uint32_t)));
+	}
+#if KBLIB_USE_CXX20
+	SECTION("constant evaluation agrees") {
+		constexpr auto bytes = [] {
+			std::array<char, 300> a{};
+			for (std::size_t i = 0; i < a.size(); ++i) {
+				a[i] = static_cast<char>(i * 37);
+			}
+			return a;
+		}();
+		constexpr auto words = [] {
+			std::array<std::uint32_t, 100> a{};
+			for (std::size_t i = 0; i < a.size(); ++i) {
+				a[i] = static_cast<std::uint32_t>(i * 2654435761u);
+			}
+			return a;
+		}();
+		constexpr auto bytes_hash = kblib::FNV_hash<decltype(bytes)>{}(bytes);
+		constexpr auto words_hash = kblib::FNV_hash<decltype(words)>{}(words);
+		auto runtime_bytes = bytes;
+		auto runtime_words = words;
+		CHECK(kblib::FNV_hash<decltype(bytes)>{}(runtime_bytes) == bytes_hash);
+		CHECK(kblib::FNV_hash<decltype(words)>{}(runtime_words) == words_hash);
+	}
+#endif
+}
+
+TEST_CASE("mix_hash") {
+	(void)kblib::mix_hash<int*>{}({});
+	(void)kblib::mix_hash<std::string>{}({});
+	(void)kblib::mix_hash<std::vector<int>>{}({});
+	(void)kblib::mix_hash<std::deque<char>>{}({});
+	(void)kblib::mix_hash<std::tuple<std::wstring, int*>>{}({});
+	(void)kblib::mix_hash<std::set<int>::iterator>{}({});
+	(void)kblib::mix_hash<empty_t>{}({});
+	(void)kblib::mix_hash<no_padding>{}({});
+	(void)kblib::mix_hash<std::map<std::tuple<std::wstring, int*>,
+	                               std::vector<std::array<bool, 16>>>>{}({});
+#if KBLIB_USE_CXX17
+	(void)kblib::mix_hash<std::optional<std::string>>{}({});
+	(void)kblib::mix_hash<std::variant<int, std::string>>{}({});
+#endif
+	static_assert(not kblib::is_mix_hashable_v<has_padding>, "");
+	static_assert(not kblib::is_mix_hashable_v<std::tuple<has_padding>>, "");
+
+	std::string input;
+	for (int i = 0; i < 300; ++i) {
+		input.push_back(static_cast<char>(i * 37 + i / 256));
+	}
+
+	SECTION("keys hash as their bytes") {
+		const std::uint64_t u = 0x0123456789abcdefu;
+		unsigned char bytes[sizeof(u)]{};
+		kblib::to_bytes(u, bytes);
+		CHECK(kblib::mix_hash<std::uint64_t>{}(u)
+		      == kblib::mix_s(bytes, sizeof(bytes)));
+		CHECK(kblib::mix_hash<std::int8_t>{}(-1)
+		      == kblib::mix_hash<std::uint8_t>{}(0xff));
+		CHECK(kblib::mix_hash<std::int32_t>{}(-2)
+		      == kblib::mix_hash<std::uint32_t>{}(0xfffffffeu));
+		CHECK(kblib::mix_hash<std::int32_t>{}(-2)
+		      != kblib::mix_hash<std::int64_t>{}(-2));
+
+		const auto h = kblib::mix_hash<std::string>{}(input);
+		CHECK(h == kblib::mix_s(input.data(), input.size()));
+		CHECK(kblib::mix_hash<std::vector<char>>{}({input.begin(), input.end()})
+		      == h);
+#if KBLIB_USE_CXX17
+		CHECK(kblib::mix_hash<std::string_view>{}(input) == h);
+#endif
+		CHECK(kblib::mix_hash<>{}(input) == h);
+	}
+	SECTION("every length and every byte matter") {
+		std::set<std::uint64_t> seen;
+		for (std::size_t n = 0; n <= input.size(); ++n) {
+			seen.insert(kblib::mix_s(input.data(), n));
+		}
+		CHECK(seen.size() == input.size() + 1);
+
+		for (std::size_t n : {1, 3, 4, 8, 15, 16, 17, 32, 48, 49, 97, 300}) {
+			const auto h = kblib::mix_s(input.data(), n);
+			for (std::size_t i = 0; i != n; ++i) {
+				auto copy = input;
+				copy[i] ^= 0x10;
+				CHECK(kblib::mix_s(copy.data(), n) != h);
+			}
+		}
+	}
+	SECTION("the seed is used") {
+		CHECK(kblib::mix_s(input.data(), 0, 1) != kblib::mix_s(input.data(), 0, 2));
+		CHECK(kblib::mix_hash<int>{}(0, 1) != kblib::mix_hash<int>{}(0, 2));
+	}
+	SECTION("small integers avalanche") {
+		// Flipping one input bit should flip about half of the output bits
+		double total{};
+		int count{};
+		for (std::uint64_t k = 0; k != 64; ++k) {
+			for (unsigned bit = 0; bit != 64; ++bit) {
+				const auto diff = kblib::mix_hash<std::uint64_t>{}(k)
+				                  ^ kblib::mix_hash<std::uint64_t>{}(
+				                      k ^ (std::uint64_t{1} << bit));
+				total += static_cast<double>(std::bitset<64>(diff).count());
+				++count;
+			}
+		}
+		const auto mean = total / count;
+		CHECK(mean > 31.0);
+		CHECK(mean < 33.0);
+	}
+	SECTION("container aliases take the hasher") {
+		kblib::hash_map<int, std::string, kblib::mix_hash<>> map;
+		for (int i = 0; i < 1000; ++i) {
+			map[i] = std::to_string(i);
+		}
+		CHECK(map.size() == 1000);
+		CHECK(map.at(123) == "123");
+		static_assert(std::is_same<decltype(map)::hasher, kblib::mix_hash<>>::value,
+		              "");
+		kblib::hash_set<std::string, kblib::mix_hash<>> set{"a", "b"};
+		CHECK(set.count("a") == 1);
+		static_assert(
+		    std::is_same<kblib::hash_set<int>::hasher, kblib::FNV_hash<>>::value,
+		    "");
+	}
+#if KBLIB_USE_CXX20
+	SECTION("constant evaluation agrees") {
+		constexpr std::array<std::uint32_t, 20> words{1, 2, 3, 4, 5, 6, 7, 8, 9};
+		constexpr auto words_hash = kblib::mix_hash<decltype(words)>{}(words);
+		constexpr auto int_hash = kblib::mix_hash<long>{}(-12345);
+		constexpr auto tuple_hash
+		    = kblib::mix_hash<std::tuple<int, char>>{}({1, 'a'});
+		auto runtime_words = words;
+		long runtime_int = -12345;
+		std::tuple<int, char> runtime_tuple{1, 'a'};
+		CHECK(kblib::mix_hash<decltype(words)>{}(runtime_words) == words_hash);
+		CHECK(kblib::mix_hash<long>{}(runtime_int) == int_hash);
+		CHECK(kblib::mix_hash<std::tuple<int, char>>{}(runtime_tuple)
+		      == tuple_hash);
+	}
+#endif
+}
+
+TEST_CASE("hash container aliases") {
+	kblib::hash_multiset<std::string> words{"a", "b", "a"};
+	CHECK(words.size() == 3);
+	CHECK(words.count("a") == 2);
+	kblib::hash_multimap<int, int, kblib::mix_hash<>> pairs{
+	    {1, 1}, {1, 2}, {2, 3}};
+	CHECK(pairs.count(1) == 2);
+	static_assert(
+	    std::is_same<kblib::hash_multiset<int>,
+	                 std::unordered_multiset<int, kblib::FNV_hash<>,
+	                                         std::equal_to<>>>::value,
+	    "");
+}
+
+TEST_CASE("fnv_hasher") {
+	using namespace kblib::literals;
+	std::string input;
+	for (int i = 0; i < 100000; ++i) {
+		input += static_cast<char>(i * 7 + i / 251);
+	}
+	const auto expected = kblib::FNVa_s<std::uint64_t>(input.data(), input.size());
+
+	// Chunk boundaries do not affect the result
+	kblib::fnv_hasher<std::uint64_t> chunked;
+	for (std::size_t pos = 0, n = 1; pos < input.size(); pos += n, n = n * 3 + 1) {
+		const auto len = std::min(n, input.size() - pos);
+		chunked.update(input.data() + pos, len);
+	}
+	CHECK(chunked.digest() == expected);
+
+	kblib::fnv_hasher<std::uint64_t> ranges;
+	ranges.update(std::string_view(input).substr(0, 1000))
+	    .update(std::deque<char>(input.begin() + 1000, input.end()));
+	CHECK(ranges.digest() == expected);
+
+	// Larger than fnv_hasher::stream_chunk_size
+	std::istringstream is(input);
+	kblib::fnv_hasher<std::uint64_t> streamed;
+	streamed.update(is);
+	CHECK(streamed.digest() == expected);
+	CHECK(is.eof());
+	CHECK_FALSE(is.bad());
+
+	// Equivalent to chaining FNVa through its hval parameter
+	kblib::fnv_hasher<std::uint32_t> h;
+	CHECK(h.update(std::string("abc")).digest() == "abc"_fnv32);
+	CHECK(kblib::fnv_hasher<std::uint32_t>("ab"_fnv32).update("c", 1).digest()
+	      == "abc"_fnv32);
+	h.reset();
+	CHECK(h.digest() == kblib::fnv::fnv_offset<std::uint32_t>::value);
+}
+
+TEST_CASE("FNV_hash::hash_many") {
+	std::vector<std::uint64_t> u64(1000);
+	std::vector<std::uint16_t> u16(1000);
+	std::vector<no_padding> structs(1000);
+	std::vector<const int*> ptrs(1000);
+	for (std::size_t i = 0; i != u64.size(); ++i) {
+		u64[i] = i * 0x9e3779b97f4a7c15u;
+		u16[i] = static_cast<std::uint16_t>(i * 40503u);
+		structs[i] = {static_cast<int>(i), -static_cast<int>(i * 3)};
+		ptrs[i] = reinterpret_cast<const int*>(i * 8);
+	}
+
+	// Every path must agree with operator() exactly, for any count and both
+	// hash widths
+	auto check = [](const auto& keys, auto hash_int) {
+		using Key = typename std::decay_t<decltype(keys)>::value_type;
+		using HashInt = decltype(hash_int);
+		kblib::FNV_hash<Key, HashInt> hasher;
+		for (std::size_t n : {0u, 1u, 15u, 16u, 17u, 1000u}) {
+			std::vector<HashInt> out(n);
+			hasher.hash_many(keys.data(), n, out.data());
+			for (std::size_t i = 0; i != n; ++i) {
+				REQUIRE(out[i] == hasher(keys[i]));
+			}
+		}
+		std::vector<HashInt> out(keys.size());
+		hasher.hash_many(keys.data(), keys.size(), out.data(), 12345u);
+		for (std::size_t i = 0; i != keys.size(); ++i) {
+			REQUIRE(out[i] == hasher(keys[i], 12345u));
+		}
+	};
+	check(u64, std::uint64_t{});
+	check(u64, std::uint32_t{});
+	check(u16, std::uint64_t{});
+	check(u16, std::uint32_t{});
+	check(structs, std::uint64_t{});
+	check(structs, std::uint32_t{});
+	check(ptrs, std::uint64_t{});
+
+	// The free function falls back to calling the hasher
+	std::vector<std::string> strings{"a", "bc", "def"};
+	std::vector<std::size_t> out(strings.size());
+	kblib::hash_many(kblib::FNV_hash<std::string>{}, strings.data(),
+	                 strings.size(), out.data());
+	CHECK(out[2] == kblib::FNV_hash<std::string>{}("def"));
+	std::vector<std::size_t> out64(u64.size());
+	kblib::hash_many(kblib::FNV_hash<std::uint64_t>{}, u64.data(), u64.size(),
+	                 out64.data());
+	CHECK(out64[999] == kblib::FNV_hash<std::uint64_t>{}(u64[999]));
+}
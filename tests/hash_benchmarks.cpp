@@ -0,0 +1,355 @@
+#include "kblib/hash.h"
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#if defined(__x86_64__) or defined(__i386__)
+#	include <x86intrin.h>
+#	define KBLIB_HASH_BENCH_TSC 1
+#elif defined(_M_X64) or defined(_M_IX86)
+#	include <intrin.h>
+#	define KBLIB_HASH_BENCH_TSC 1
+#else
+#	define KBLIB_HASH_BENCH_TSC 0
+#endif
+
+#if KBLIB_USE_CXX17
+
+namespace {
+
+// Each benchmark run hashes this many keys, so that timer resolution does not
+// dominate for small keys
+constexpr std::size_t batch_size = 1024;
+// String and vector keys are timed at these sizes, in bytes
+constexpr std::size_t key_sizes[] = {4, 8, 16, 32, 64, 256, 1024, 4096};
+
+using string_tuple = std::tuple<std::uint32_t, std::string, std::uint64_t>;
+using string_variant = std::variant<std::uint64_t, std::string>;
+
+/**
+ * @brief Calls f(name, hasher) for each hasher being compared. std::hash is
+ * only included for keys it supports.
+ */
+template <typename Key, typename F>
+auto for_each_hasher(F f) -> void {
+	f("FNV_hash", kblib::FNV_hash<Key, std::uint64_t>{});
+	f("mix_hash", kblib::mix_hash<Key>{});
+	if constexpr (std::is_default_constructible_v<std::hash<Key>>) {
+		f("std::hash", std::hash<Key>{});
+	}
+}
+
+auto random_string(std::mt19937_64& rng, std::size_t size) -> std::string {
+	std::uniform_int_distribution<int> dist('a', 'z');
+	std::string s(size, ' ');
+	for (auto& c : s) {
+		c = static_cast<char>(dist(rng));
+	}
+	return s;
+}
+
+template <typename F>
+auto make_keys(std::size_t n, F make) {
+	// Fixed seed, so that runs can be compared with each other
+	std::mt19937_64 rng{42};
+	std::vector<decltype(make(rng))> keys;
+	keys.reserve(n);
+	for (std::size_t i = 0; i != n; ++i) {
+		keys.push_back(make(rng));
+	}
+	return keys;
+}
+
+template <typename Key>
+auto bench_hashers(const std::string& suffix, const std::vector<Key>& keys)
+    -> void {
+	for_each_hasher<Key>([&](const char* name, auto hash) {
+		BENCHMARK_ADVANCED(name + suffix)(Catch::Benchmark::Chronometer meter) {
+			meter.measure([&] {
+				std::uint64_t sum{};
+				for (const auto& k : keys) {
+					sum += static_cast<std::uint64_t>(hash(k));
+				}
+				return sum;
+			});
+		};
+	});
+}
+
+/**
+ * @brief A timestamp in CPU cycles where available, and in nanoseconds
+ * otherwise. The TSC ticks at the nominal clock rate, so results on a
+ * turbo-boosting CPU read slightly optimistic.
+ */
+auto cycle_count() -> std::uint64_t {
+#	if KBLIB_HASH_BENCH_TSC
+	return __rdtsc();
+#	else
+	return static_cast<std::uint64_t>(
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(
+	        std::chrono::steady_clock::now().time_since_epoch())
+	        .count());
+#	endif
+}
+constexpr const char* cycle_unit = KBLIB_HASH_BENCH_TSC ? "cycle" : "ns";
+
+/**
+ * @brief The best of several timings of hashing all of keys, in bytes hashed
+ * per cycle.
+ */
+template <typename Hasher>
+auto bytes_per_cycle(Hasher hash, const std::vector<std::string>& keys)
+    -> double {
+	constexpr int repeats = 16;
+	auto best = std::numeric_limits<std::uint64_t>::max();
+	std::uint64_t sum{};
+	for (int r = 0; r != repeats; ++r) {
+		const auto start = cycle_count();
+		for (const auto& k : keys) {
+			sum += static_cast<std::uint64_t>(hash(k));
+		}
+		best = std::min(best, cycle_count() - start);
+	}
+	// Keep the hashes from being optimized away
+	volatile std::uint64_t sink = sum;
+	static_cast<void>(sink);
+	return static_cast<double>(keys.size() * keys.front().size())
+	       / static_cast<double>(std::max(best, std::uint64_t{1}));
+}
+
+/**
+ * @brief Functions for flipping individual bits of a key, for the avalanche
+ * test. Keys of varying length are only flipped in as many bits as the first
+ * key has.
+ */
+auto bit_width(std::uint64_t) -> std::size_t { return 64; }
+auto flip_bit(std::uint64_t k, std::size_t bit) -> std::uint64_t {
+	return k ^ (std::uint64_t{1} << bit);
+}
+auto bit_width(const std::string& k) -> std::size_t { return 8 * k.size(); }
+auto flip_bit(std::string k, std::size_t bit) -> std::string {
+	k[bit / 8] = static_cast<char>(k[bit / 8] ^ (1 << (bit % 8)));
+	return k;
+}
+
+struct avalanche_result {
+	// The fraction of output bits that flip when one input bit flips. Ideally
+	// 0.5.
+	double mean;
+	// The largest deviation from 0.5 of the probability that a given output
+	// bit flips when a given input bit flips. Ideally 0, plus sampling noise
+	// of about 1/sqrt(keys).
+	double worst_bias;
+};
+
+template <typename Hasher, typename Key>
+auto avalanche(Hasher hash, const std::vector<Key>& keys) -> avalanche_result {
+	using result_type = decltype(hash(keys.front()));
+	constexpr std::size_t out_bits = 8 * sizeof(result_type);
+	const std::size_t in_bits = bit_width(keys.front());
+	std::vector<std::size_t> flips(in_bits * out_bits);
+	for (const auto& k : keys) {
+		const auto h = static_cast<std::uint64_t>(hash(k));
+		for (std::size_t i = 0; i != in_bits; ++i) {
+			const auto diff = h ^ static_cast<std::uint64_t>(hash(flip_bit(k, i)));
+			for (std::size_t j = 0; j != out_bits; ++j) {
+				flips[i * out_bits + j] += (diff >> j) & 1u;
+			}
+		}
+	}
+	double total{};
+	double worst{};
+	for (auto f : flips) {
+		const auto p = static_cast<double>(f) / static_cast<double>(keys.size());
+		total += p;
+		worst = std::max(worst, std::abs(p - 0.5));
+	}
+	return {total / static_cast<double>(flips.size()), worst};
+}
+
+struct distribution_result {
+	// Chi-squared of the bucket counts divided by its degrees of freedom, when
+	// buckets are chosen by the low or the high bits of the hash. Ideally
+	// close to 1; 0 means perfectly even, which only structured keys achieve.
+	double chi2_low;
+	double chi2_high;
+	// The most keys in one bucket (by the low bits)
+	std::size_t max_load;
+};
+
+template <typename Hasher, typename Key>
+auto bucket_distribution(Hasher hash, const std::vector<Key>& keys,
+                         unsigned table_bits) -> distribution_result {
+	using result_type = decltype(hash(keys.front()));
+	constexpr unsigned out_bits = 8 * sizeof(result_type);
+	const std::size_t buckets = std::size_t{1} << table_bits;
+	std::vector<std::size_t> low(buckets), high(buckets);
+	for (const auto& k : keys) {
+		const auto h = static_cast<std::uint64_t>(hash(k));
+		++low[h & (buckets - 1)];
+		++high[(h >> (out_bits - table_bits)) & (buckets - 1)];
+	}
+	const double expected
+	    = static_cast<double>(keys.size()) / static_cast<double>(buckets);
+	const auto chi2 = [&](const std::vector<std::size_t>& counts) {
+		double sum{};
+		for (auto c : counts) {
+			const auto d = static_cast<double>(c) - expected;
+			sum += d * d / expected;
+		}
+		return sum / static_cast<double>(buckets - 1);
+	};
+	return {chi2(low), chi2(high), *std::max_element(low.begin(), low.end())};
+}
+
+template <typename Key>
+auto report_quality(const char* family, const std::vector<Key>& keys) -> void {
+	// Avalanche flips every input bit of every key, so it uses a sample
+	const std::vector<Key> sample(
+	    keys.begin(),
+	    keys.begin() + static_cast<std::ptrdiff_t>(std::min(keys.size(),
+	                                                        std::size_t{2000})));
+	constexpr unsigned table_bits = 16;
+	for_each_hasher<Key>([&](const char* name, auto hash) {
+		std::cout << std::left << std::setw(20) << family << std::setw(11)
+		          << name << std::right << std::fixed << std::setprecision(3);
+		const auto a = avalanche(hash, sample);
+		std::cout << std::setw(9) << a.mean << std::setw(9) << a.worst_bias;
+		const auto d = bucket_distribution(hash, keys, table_bits);
+		std::cout << std::setw(12) << d.chi2_low << std::setw(12) << d.chi2_high
+		          << std::setw(6) << d.max_load << '\n';
+		if (name == std::string("mix_hash")) {
+			CHECK(a.mean > 0.49);
+			CHECK(a.mean < 0.51);
+			CHECK(a.worst_bias < 0.1);
+			CHECK(d.chi2_low < 1.5);
+			CHECK(d.chi2_high < 1.5);
+		}
+	});
+}
+
+} // namespace
+
+TEST_CASE("hash throughput", "[.][benchmark]") {
+	using namespace std::literals;
+
+	bench_hashers(", uint32"s, make_keys(batch_size, [](std::mt19937_64& rng) {
+		              return static_cast<std::uint32_t>(rng());
+	              }));
+	bench_hashers(", uint64"s, make_keys(batch_size, [](std::mt19937_64& rng) {
+		              return std::uint64_t{rng()};
+	              }));
+	for (auto size : key_sizes) {
+		const auto suffix = ", string, " + std::to_string(size) + " bytes";
+		bench_hashers(suffix, make_keys(batch_size, [&](std::mt19937_64& rng) {
+			              return random_string(rng, size);
+		              }));
+	}
+	for (auto size : key_sizes) {
+		if (size < sizeof(std::uint32_t)) {
+			continue;
+		}
+		const auto suffix
+		    = ", vector<uint32>, " + std::to_string(size) + " bytes";
+		bench_hashers(suffix, make_keys(batch_size, [&](std::mt19937_64& rng) {
+			              std::vector<std::uint32_t> v(size / 4);
+			              for (auto& x : v) {
+				              x = static_cast<std::uint32_t>(rng());
+			              }
+			              return v;
+		              }));
+	}
+	// Not contiguous, so hashed element by element
+	bench_hashers(", vector<string>, 8 x 8 bytes"s,
+	              make_keys(batch_size, [](std::mt19937_64& rng) {
+		              std::vector<std::string> v(8);
+		              for (auto& s : v) {
+			              s = random_string(rng, 8);
+		              }
+		              return v;
+	              }));
+	bench_hashers(", tuple<uint32, string, uint64>"s,
+	              make_keys(batch_size, [](std::mt19937_64& rng) {
+		              return string_tuple{static_cast<std::uint32_t>(rng()),
+		                                  random_string(rng, 16), rng()};
+	              }));
+	bench_hashers(", variant<uint64, string>"s,
+	              make_keys(batch_size, [](std::mt19937_64& rng) {
+		              return rng() % 2 ? string_variant{random_string(rng, 16)}
+		                               : string_variant{std::uint64_t{rng()}};
+	              }));
+	bench_hashers(", optional<uint64>"s,
+	              make_keys(batch_size, [](std::mt19937_64& rng) {
+		              return rng() % 4 ? std::optional<std::uint64_t>{rng()}
+		                               : std::nullopt;
+	              }));
+
+	std::cout << "\nstring hashing throughput, bytes/" << cycle_unit << '\n'
+	          << std::setw(8) << "bytes";
+	for_each_hasher<std::string>([](const char* name, auto) {
+		std::cout << std::setw(11) << name;
+	});
+	std::cout << '\n';
+	for (auto size : key_sizes) {
+		const auto keys = make_keys(batch_size, [&](std::mt19937_64& rng) {
+			return random_string(rng, size);
+		});
+		std::cout << std::setw(8) << size << std::fixed << std::setprecision(3);
+		for_each_hasher<std::string>([&](const char*, auto hash) {
+			std::cout << std::setw(11) << bytes_per_cycle(hash, keys);
+		});
+		std::cout << '\n';
+	}
+}
+
+TEST_CASE("hash quality", "[.][benchmark]") {
+	constexpr std::size_t n = 1u << 18u;
+	std::cout << "\navalanche: mean fraction of output bits flipped by one input"
+	             " bit, and worst bias\n"
+	             "buckets: chi-squared per degree of freedom over 2^16 buckets"
+	             " by low and high bits, and max load (mean 4)\n\n"
+	          << std::left << std::setw(20) << "keys" << std::setw(11)
+	          << "hasher" << std::right << std::setw(9) << "mean"
+	          << std::setw(9) << "bias" << std::setw(12) << "chi2 low"
+	          << std::setw(12) << "chi2 high" << std::setw(6) << "max" << '\n';
+
+	std::vector<std::uint64_t> sequential(n), strided(n);
+	for (std::size_t i = 0; i != n; ++i) {
+		sequential[i] = i;
+		// Like aligned pointers, or keys that are multiples of a page size
+		strided[i] = i << 12u;
+	}
+	report_quality("sequential uint64", sequential);
+	report_quality("strided uint64", strided);
+	report_quality("random uint64",
+	               make_keys(n, [](std::mt19937_64& rng) {
+		               return std::uint64_t{rng()};
+	               }));
+
+	std::vector<std::string> numbered(n);
+	for (std::size_t i = 0; i != n; ++i) {
+		numbered[i] = "key" + std::to_string(i);
+	}
+	report_quality("\"key<n>\" strings", numbered);
+	report_quality("8 byte strings", make_keys(n, [](std::mt19937_64& rng) {
+		               return random_string(rng, 8);
+	               }));
+	report_quality("32 byte strings", make_keys(n, [](std::mt19937_64& rng) {
+		               return random_string(rng, 32);
+	               }));
+}
+
+#endif // KBLIB_USE_CXX17
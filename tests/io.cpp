@@ -5,6 +5,7 @@
 
 #include <deque>
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <vector>
 
@@ -320,6 +321,24 @@ TEST_CASE("get_file_contents") {
 	// so the second overload of get_file_contents will be used.
 	auto fileerror = kblib::get_file_contents<std::deque<char>>(filename);
 }
+
+TEST_CASE("mapped_file") {
+	const auto path = std::filesystem::temp_directory_path()
+	                  / ("kblib-mapped-file-test-"
+	                     + std::to_string(std::random_device{}()));
+	const std::string contents("mapped\0file", 11);
+	std::ofstream(path, std::ios::binary) << contents;
+	{
+		const kblib::mapped_file file(path);
+		REQUIRE(std::string(file.data(), file.size()) == contents);
+	}
+	// Truncate only once the mapping is gone
+	std::ofstream(path, std::ios::binary | std::ios::trunc);
+	auto empty = kblib::mapped_file(path);
+	CHECK(empty.empty());
+	std::filesystem::remove(path);
+	CHECK_THROWS_AS(kblib::mapped_file(path), std::system_error);
+}
 #endif
 
 TEST_CASE("tee_stream") {
@@ -1,6 +1,9 @@
+#include "kblib/tdecl.h"
+
 #if KBLIB_USE_CXX17
 
 #	include "kblib/multi_span.h"
+#	include "kblib/hash.h"
 #	include "catch2/catch.hpp"
 
 #	include <array>
@@ -12,6 +15,19 @@ TEST_CASE("multi_span") {
 	REQUIRE(std::distance(span.begin(), span.end()) == 10 * 10);
 }
 
+TEST_CASE("multi_span hashing") {
+	const std::string a = "hello, ", b = "", c = "world";
+	kblib::multi_span<const char> span{kblib::span<const char>(a),
+	                                   kblib::span<const char>(b),
+	                                   kblib::span<const char>(c)};
+	std::size_t spans = 0;
+	span.for_each_span([&](kblib::span<const char>) { ++spans; });
+	CHECK(spans == 3);
+	kblib::fnv_hasher<std::uint64_t> h;
+	CHECK(h.update(span).digest()
+	      == kblib::FNVa_s<std::uint64_t>("hello, world", 12));
+}
+
 #	if 0
 TEST_CASE("input iterators") {
 	std::istringstream i1("0 1 2 3 4 5 6 7 8 9");
@@ -0,0 +1,70 @@
+#include "kblib/perfect_hash.h"
+
+#include "catch2/catch.hpp"
+
+#include <string>
+
+#if KBLIB_USE_CXX17
+
+namespace {
+
+enum class keyword { if_, else_, while_, for_, return_, break_, continue_ };
+
+constexpr auto keywords = kblib::make_perfect_hash_map<keyword>(
+    {{"if", keyword::if_},
+     {"else", keyword::else_},
+     {"while", keyword::while_},
+     {"for", keyword::for_},
+     {"return", keyword::return_},
+     {"break", keyword::break_},
+     {"continue", keyword::continue_}});
+
+static_assert(keywords.at("while") == keyword::while_);
+static_assert(keywords.index_of("for") == 3);
+static_assert(not keywords.contains("goto"));
+static_assert(not keywords.contains(""));
+
+} // namespace
+
+TEST_CASE("perfect_hash_map") {
+	CHECK(keywords.size() == 7);
+	CHECK(keywords.table_size == 8);
+	for (const auto& e : keywords) {
+		REQUIRE(keywords.at(e.first) == e.second);
+		REQUIRE(keywords.find(e.first) == &e);
+	}
+	CHECK(keywords.find("whil") == keywords.end());
+	CHECK(keywords.count(std::string("return")) == 1);
+	CHECK_THROWS_AS(keywords.at("goto"), std::out_of_range);
+
+	SECTION("a full table of many keys") {
+		// Built at run time, to keep compilation fast
+		static const std::string names[] = {
+		    "alpha", "bravo",  "charlie", "delta",   "echo",    "foxtrot",
+		    "golf",  "hotel",  "india",   "juliett", "kilo",    "lima",
+		    "mike",  "novem",  "oscar",   "papa",    "quebec",  "romeo",
+		    "sierra", "tango", "uniform", "victor",  "whiskey", "xray",
+		    "yankee", "zulu",  "zero",    "one",     "two",     "three",
+		    "four",  "five"};
+		std::pair<std::string_view, int> entries[32];
+		for (int i = 0; i != 32; ++i) {
+			entries[i] = {names[i], i};
+		}
+		auto map = kblib::make_perfect_hash_map(entries);
+		CHECK(map.table_size == 32);
+		for (int i = 0; i != 32; ++i) {
+			REQUIRE(map.at(names[i]) == i);
+		}
+		for (const char* absent : {"", "alph", "alphaa", "six", "Zulu"}) {
+			REQUIRE_FALSE(map.contains(absent));
+		}
+	}
+
+	SECTION("duplicate keys are rejected") {
+		std::pair<std::string_view, int> entries[] = {{"a", 1}, {"a", 2}};
+		CHECK_THROWS_AS(kblib::make_perfect_hash_map(entries),
+		                std::invalid_argument);
+	}
+}
+
+#endif
@@ -280,3 +280,662 @@ TEST_CASE("byte extraction") {
 	static_assert(+kblib::get_byte_index(arr, 6) == 0xBA, "");
 	static_assert(+kblib::get_byte_index(arr, 7) == 0x98, "");
 }
+
+namespace {
+struct record {
+	std::uint32_t key32;
+	std::uint64_t key64;
+	std::size_t id;
+};
+} // namespace
+
+TEST_CASE("sort_transform (radix)") {
+	std::minstd_rand rng{std::random_device{}()};
+	auto make_records = [&](std::size_t n, std::uint64_t max) {
+		std::uniform_int_distribution<std::uint64_t> dist(0, max);
+		std::vector<record> records(n);
+		for (auto i : kblib::range(n)) {
+			auto v = dist(rng);
+			records[i] = {static_cast<std::uint32_t>(v), v * 0x9E3779B97F4A7C15u,
+			              i};
+		}
+		return records;
+	};
+	auto ids = [](const std::vector<record>& records) {
+		std::vector<std::size_t> out;
+		for (const auto& r : records) {
+			out.push_back(r.id);
+		}
+		return out;
+	};
+
+	auto check_sorted = [&](auto sort, auto compare) {
+		for (auto max : {std::uint64_t{0}, std::uint64_t{255},
+		                  std::uint64_t{65535}, std::uint64_t{UINT32_MAX}}) {
+			for (auto n : {std::size_t{0}, std::size_t{5}, std::size_t{5000},
+			               std::size_t{60000}}) {
+				auto records = make_records(n, max);
+				auto expected = records;
+				std::stable_sort(expected.begin(), expected.end(), compare);
+				sort(records);
+				CHECK(ids(records) == ids(expected));
+			}
+		}
+	};
+
+	SECTION("uint32_t ascending") {
+		check_sorted(
+		    [](std::vector<record>& r) {
+			    kblib::sort_transform(r.begin(), r.end(), &record::key32);
+		    },
+		    [](const record& a, const record& b) { return a.key32 < b.key32; });
+	}
+	SECTION("uint64_t ascending") {
+		check_sorted(
+		    [](std::vector<record>& r) {
+			    kblib::sort_transform(r.begin(), r.end(), &record::key64);
+		    },
+		    [](const record& a, const record& b) { return a.key64 < b.key64; });
+	}
+	SECTION("uint32_t descending") {
+		check_sorted(
+		    [](std::vector<record>& r) {
+			    kblib::sort_transform(r.begin(), r.end(), &record::key32,
+			                          std::greater<>{});
+		    },
+		    [](const record& a, const record& b) { return a.key32 > b.key32; });
+	}
+	SECTION("uint64_t descending") {
+		check_sorted(
+		    [](std::vector<record>& r) {
+			    kblib::sort_transform(r.begin(), r.end(), &record::key64,
+			                          std::greater<>{});
+		    },
+		    [](const record& a, const record& b) { return a.key64 > b.key64; });
+	}
+	SECTION("sorted and reverse sorted input") {
+		auto records = make_records(5000, 255);
+		const auto by_key = [](const record& a, const record& b) {
+			return a.key32 < b.key32;
+		};
+		std::stable_sort(records.begin(), records.end(), by_key);
+		auto expected = records;
+		kblib::sort_transform(records.begin(), records.end(), &record::key32);
+		CHECK(ids(records) == ids(expected));
+
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [](const record& a, const record& b) {
+			                 return a.key32 > b.key32;
+		                 });
+		kblib::sort_transform(records.begin(), records.end(), &record::key32,
+		                      std::greater<>{});
+		CHECK(ids(records) == ids(expected));
+	}
+	SECTION("kblib::sort on integers") {
+		std::uniform_int_distribution<unsigned> dist;
+		std::vector<unsigned> input(10000);
+		std::generate(input.begin(), input.end(), [&] { return dist(rng); });
+		auto expected = input;
+		std::sort(expected.begin(), expected.end());
+		kblib::sort(input.begin(), input.end());
+		CHECK(input == expected);
+	}
+}
+
+namespace {
+enum class level : signed char { low = -100, mid = 0, high = 100 };
+
+struct signed_record {
+	std::int32_t key32;
+	std::int64_t key64;
+	float keyf;
+	double keyd;
+	level keye;
+	std::size_t id;
+};
+} // namespace
+
+TEST_CASE("sort_transform (signed and floating point radix)") {
+	static_assert(kblib::radix_key(std::int8_t{-1}) < kblib::radix_key(0),
+	              "radix_key must preserve order across zero");
+	CHECK(kblib::radix_key(-0.0) == kblib::radix_key(0.0));
+	CHECK(kblib::radix_key(-1.5f) < kblib::radix_key(-1.0f));
+	CHECK(kblib::radix_key(-std::numeric_limits<double>::infinity())
+	      < kblib::radix_key(std::numeric_limits<double>::lowest()));
+
+	std::minstd_rand rng{std::random_device{}()};
+	const double specials[] = {0.0,
+	                           -0.0,
+	                           std::numeric_limits<double>::infinity(),
+	                           -std::numeric_limits<double>::infinity(),
+	                           std::numeric_limits<double>::denorm_min(),
+	                           -std::numeric_limits<double>::denorm_min(),
+	                           std::numeric_limits<double>::max(),
+	                           std::numeric_limits<double>::lowest()};
+	const level levels[] = {level::low, level::mid, level::high};
+	auto make_records = [&](std::size_t n, std::int64_t max) {
+		std::uniform_int_distribution<std::int64_t> dist(-max, max);
+		std::uniform_real_distribution<double> real(-1e6, 1e6);
+		std::vector<signed_record> records(n);
+		for (auto i : kblib::range(n)) {
+			auto v = dist(rng);
+			double d = (i % 7 == 0) ? specials[i / 7 % 8] : real(rng);
+			if (max <= 16) {
+				d = static_cast<double>(v) / 4;
+			}
+			records[i] = {static_cast<std::int32_t>(v),
+			              v * 0x10001,
+			              static_cast<float>(d),
+			              d,
+			              levels[kblib::to_unsigned(v) % 3],
+			              i};
+		}
+		return records;
+	};
+	auto ids = [](const std::vector<signed_record>& records) {
+		std::vector<std::size_t> out;
+		for (const auto& r : records) {
+			out.push_back(r.id);
+		}
+		return out;
+	};
+
+	auto check_sorted = [&](auto member) {
+		for (auto max :
+		     {std::int64_t{0}, std::int64_t{16}, std::int64_t{INT32_MAX}}) {
+			for (auto n : {std::size_t{0}, std::size_t{5}, std::size_t{5000},
+			               std::size_t{60000}}) {
+				auto records = make_records(n, max);
+				auto expected = records;
+				using R = const signed_record&;
+				std::stable_sort(expected.begin(), expected.end(),
+				                 [&](R a, R b) { return a.*member < b.*member; });
+				kblib::sort_transform(records.begin(), records.end(), member);
+				CHECK(ids(records) == ids(expected));
+
+				std::stable_sort(expected.begin(), expected.end(),
+				                 [&](R a, R b) { return a.*member > b.*member; });
+				kblib::sort_transform(records.begin(), records.end(), member,
+				                      std::greater<>{});
+				CHECK(ids(records) == ids(expected));
+			}
+		}
+	};
+
+	SECTION("int32_t") { check_sorted(&signed_record::key32); }
+	SECTION("int64_t") { check_sorted(&signed_record::key64); }
+	SECTION("float") { check_sorted(&signed_record::keyf); }
+	SECTION("double") { check_sorted(&signed_record::keyd); }
+	SECTION("enum") { check_sorted(&signed_record::keye); }
+	SECTION("kblib::sort on doubles") {
+		std::uniform_real_distribution<double> dist(-1e9, 1e9);
+		std::vector<double> input(10000);
+		std::generate(input.begin(), input.end(), [&] { return dist(rng); });
+		auto expected = input;
+		std::sort(expected.begin(), expected.end());
+		kblib::sort(input.begin(), input.end());
+		CHECK(input == expected);
+	}
+}
+
+TEST_CASE("sort_transform (string radix)") {
+	std::minstd_rand rng{std::random_device{}()};
+	auto random_key = [&](auto tag, std::size_t max_len, auto min_el,
+	                      auto max_el) {
+		using Key = typename decltype(tag)::type;
+		using E = typename Key::value_type;
+		std::uniform_int_distribution<std::size_t> len(0, max_len);
+		std::uniform_int_distribution<long long> el(min_el, max_el);
+		Key key;
+		for (auto n = len(rng); n; --n) {
+			key.push_back(static_cast<E>(el(rng)));
+		}
+		return key;
+	};
+	auto check_sorted = [&](auto tag, auto min_el, auto max_el) {
+		using Key = typename decltype(tag)::type;
+		for (auto n : {std::size_t{0}, std::size_t{3}, std::size_t{1000},
+		               std::size_t{20000}}) {
+			std::vector<Key> input;
+			for (auto i : kblib::range(n)) {
+				// long shared prefixes and many duplicates
+				auto prefix = random_key(tag, 1, min_el, min_el + 1);
+				auto key = random_key(tag, i % 2 ? 3 : 20, min_el, max_el);
+				prefix.insert(prefix.end(), key.begin(), key.end());
+				input.push_back(prefix);
+			}
+			auto asc = input;
+			auto desc = input;
+			auto expected = input;
+			std::sort(expected.begin(), expected.end());
+			kblib::sort(asc.begin(), asc.end());
+			CHECK(asc == expected);
+
+			std::sort(expected.begin(), expected.end(), std::greater<>{});
+			kblib::sort(desc.begin(), desc.end(), std::greater<>{});
+			CHECK(desc == expected);
+		}
+	};
+
+	SECTION("std::string") {
+		check_sorted(kblib::detail::tag<std::string>{}, 'a', 'd');
+		check_sorted(kblib::detail::tag<std::string>{}, -128, 127);
+	}
+	SECTION("std::wstring") {
+		check_sorted(kblib::detail::tag<std::wstring>{}, -70000, 70000);
+	}
+	SECTION("std::vector<std::uint8_t>") {
+		check_sorted(kblib::detail::tag<std::vector<std::uint8_t>>{}, 0, 255);
+	}
+	SECTION("std::vector<char>") {
+		check_sorted(kblib::detail::tag<std::vector<char>>{}, -128, 127);
+	}
+	SECTION("std::vector<std::int16_t>") {
+		check_sorted(kblib::detail::tag<std::vector<std::int16_t>>{}, -300, 300);
+	}
+	SECTION("std::vector<std::uint32_t>") {
+		check_sorted(kblib::detail::tag<std::vector<std::uint32_t>>{}, 0,
+		             UINT32_MAX);
+	}
+	SECTION("member key") {
+		struct named {
+			std::string name;
+			int id;
+		};
+		std::vector<named> input;
+		for (auto i : kblib::range(5000)) {
+			input.push_back({random_key(kblib::detail::tag<std::string>{}, 8,
+			                            'a', 'z'),
+			                 i});
+		}
+		kblib::sort_transform(input.begin(), input.end(), &named::name);
+		CHECK(std::is_sorted(
+		    input.begin(), input.end(),
+		    [](const named& a, const named& b) { return a.name < b.name; }));
+	}
+}
+
+TEST_CASE("sort_transform (cached keys)") {
+	std::minstd_rand rng{std::random_device{}()};
+	std::uniform_int_distribution<int> dist(-5000, 5000);
+	std::vector<int> input(20000);
+	std::generate(input.begin(), input.end(), [&] { return dist(rng); });
+
+	std::size_t calls{};
+	// Sorts by the absolute value's decimal representation
+	auto key = [&calls](int v) {
+		++calls;
+		return std::to_string(std::abs(v));
+	};
+	auto by_key = [](int a, int b) {
+		return std::to_string(std::abs(a)) < std::to_string(std::abs(b));
+	};
+	auto keys_of = [](const std::vector<int>& v) {
+		std::vector<std::string> out;
+		for (auto x : v) {
+			out.push_back(std::to_string(std::abs(x)));
+		}
+		return out;
+	};
+	auto expected = input;
+	std::sort(expected.begin(), expected.end(), by_key);
+
+	SECTION("transform is called once per element") {
+		kblib::sort_transform(input.begin(), input.end(), key);
+		CHECK(calls == input.size());
+		CHECK(keys_of(input) == keys_of(expected));
+		auto sorted = expected;
+		std::sort(sorted.begin(), sorted.end());
+		std::sort(input.begin(), input.end());
+		CHECK(input == sorted);
+	}
+	SECTION("custom comparison") {
+		auto length_then_value = [](const std::string& a, const std::string& b) {
+			return std::make_pair(a.size(), a) < std::make_pair(b.size(), b);
+		};
+		kblib::sort_transform(input.begin(), input.end(), key,
+		                      length_then_value);
+		CHECK(calls == input.size());
+		auto got = keys_of(input);
+		CHECK(std::is_sorted(got.begin(), got.end(), length_then_value));
+	}
+	SECTION("integral keys from a lambda") {
+		kblib::sort_transform(
+		    input.begin(), input.end(),
+		    [&calls](int v) {
+			    ++calls;
+			    return -v;
+		    },
+		    std::greater<>{});
+		CHECK(calls == input.size());
+		CHECK(std::is_sorted(input.begin(), input.end()));
+	}
+	SECTION("kblib::sort with a custom comparison") {
+		kblib::sort(input.begin(), input.end(),
+		            [](int a, int b) { return std::abs(a) < std::abs(b); });
+		CHECK(std::is_sorted(input.begin(), input.end(), [](int a, int b) {
+			return std::abs(a) < std::abs(b);
+		}));
+	}
+}
+
+TEST_CASE("sort (parallel)") {
+	std::minstd_rand rng{std::random_device{}()};
+
+	auto check = [&](auto make, auto sort, auto less) {
+		for (auto n : {std::size_t{0}, std::size_t{1}, std::size_t{7},
+		               std::size_t{1000}, std::size_t{100000}}) {
+			for (auto threads : {std::size_t{0}, std::size_t{1}, std::size_t{2},
+			                     std::size_t{3}, std::size_t{8}}) {
+				auto input = make(n);
+				auto expected = input;
+				std::sort(expected.begin(), expected.end(), less);
+				sort(kblib::execution::parallel_policy{threads}, input);
+				CHECK(input.size() == expected.size());
+				CHECK(std::is_sorted(input.begin(), input.end(), less));
+				std::sort(input.begin(), input.end());
+				std::sort(expected.begin(), expected.end());
+				CHECK(input == expected);
+			}
+		}
+	};
+
+	SECTION("integers with many duplicates") {
+		check(
+		    [&](std::size_t n) {
+			    std::uniform_int_distribution<int> dist(-50, 50);
+			    std::vector<int> v(n);
+			    std::generate(v.begin(), v.end(), [&] { return dist(rng); });
+			    return v;
+		    },
+		    [](auto policy, std::vector<int>& v) {
+			    kblib::sort(policy, v.begin(), v.end());
+		    },
+		    std::less<>{});
+	}
+	SECTION("doubles in reverse") {
+		check(
+		    [&](std::size_t n) {
+			    std::uniform_real_distribution<double> dist(-1e3, 1e3);
+			    std::vector<double> v(n);
+			    std::generate(v.begin(), v.end(), [&] { return dist(rng); });
+			    return v;
+		    },
+		    [](auto policy, std::vector<double>& v) {
+			    kblib::sort(policy, v.begin(), v.end(), std::greater<>{});
+		    },
+		    std::greater<>{});
+	}
+	SECTION("strings by a computed key") {
+		auto key = [](const std::string& s) { return s.substr(1); };
+		check(
+		    [&](std::size_t n) {
+			    std::uniform_int_distribution<int> dist(0, 2000);
+			    std::vector<std::string> v(n);
+			    std::generate(v.begin(), v.end(),
+			                  [&] { return std::to_string(dist(rng)); });
+			    return v;
+		    },
+		    [&](auto policy, std::vector<std::string>& v) {
+			    kblib::sort_transform(policy, v.begin(), v.end(), key);
+		    },
+		    [&](const std::string& a, const std::string& b) {
+			    return key(a) < key(b);
+		    });
+	}
+	SECTION("sequenced policy") {
+		std::vector<int> v{5, 3, 9, 1, 1, 4};
+		kblib::sort(kblib::execution::seq, v.begin(), v.end());
+		CHECK(v == std::vector<int>{1, 1, 3, 4, 5, 9});
+	}
+	SECTION("exceptions propagate") {
+		std::vector<int> v(10000);
+		std::iota(v.begin(), v.end(), 0);
+		std::shuffle(v.begin(), v.end(), rng);
+		auto throwing = [](int a, int b) {
+			if (a == 4242 or b == 4242) {
+				throw std::runtime_error("comparison failed");
+			}
+			return a < b;
+		};
+		CHECK_THROWS_AS(kblib::sort(kblib::execution::parallel_policy{4},
+		                            v.begin(), v.end(), throwing),
+		                std::runtime_error);
+	}
+}
+
+TEST_CASE("sort_transform (counting sort)") {
+	std::minstd_rand rng{std::random_device{}()};
+	struct narrow {
+		std::uint8_t key8;
+		std::int16_t key16;
+		std::size_t id;
+	};
+	auto check = [&](std::size_t n, auto member) {
+		using R = const narrow&;
+		std::uniform_int_distribution<int> dist(-32768, 32767);
+		std::vector<narrow> input(n);
+		for (auto i : kblib::range(n)) {
+			const auto v = dist(rng);
+			input[i] = {static_cast<std::uint8_t>(v), static_cast<std::int16_t>(v),
+			            i};
+		}
+		auto ids = [](const std::vector<narrow>& v) {
+			std::vector<std::size_t> out;
+			for (const auto& r : v) {
+				out.push_back(r.id);
+			}
+			return out;
+		};
+		auto expected = input;
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [&](R a, R b) { return a.*member < b.*member; });
+		auto got = input;
+		kblib::sort_transform(got.begin(), got.end(), member);
+		CHECK(ids(got) == ids(expected));
+
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [&](R a, R b) { return a.*member > b.*member; });
+		kblib::sort_transform(got.begin(), got.end(), member, std::greater<>{});
+		CHECK(ids(got) == ids(expected));
+	};
+
+	// Large enough for the counting sort to be chosen over LSD radix sort
+	SECTION("8-bit keys") { check(std::size_t{1} << 13u, &narrow::key8); }
+	SECTION("16-bit keys") { check(std::size_t{1} << 20u, &narrow::key16); }
+	SECTION("equal keys") {
+		std::vector<std::uint16_t> input(std::size_t{1} << 20u, 42);
+		kblib::sort(input.begin(), input.end());
+		CHECK(std::all_of(input.begin(), input.end(),
+		                  [](std::uint16_t v) { return v == 42; }));
+	}
+}
+
+TEST_CASE("stable_sort") {
+	std::minstd_rand rng{std::random_device{}()};
+	struct event {
+		std::uint32_t timestamp;
+		double weight;
+		std::string tag;
+		std::size_t id;
+	};
+	std::uniform_int_distribution<int> dist(0, 300);
+	auto make = [&](std::size_t n) {
+		std::vector<event> v(n);
+		for (auto i : kblib::range(n)) {
+			const auto x = dist(rng);
+			v[i] = {static_cast<std::uint32_t>(x * 1000003u), x / 7.0,
+			        std::to_string(x % 97), i};
+		}
+		return v;
+	};
+	auto ids = [](const std::vector<event>& v) {
+		std::vector<std::size_t> out;
+		for (const auto& e : v) {
+			out.push_back(e.id);
+		}
+		return out;
+	};
+	auto check = [&](auto sort, auto less) {
+		for (auto n : {std::size_t{0}, std::size_t{1}, std::size_t{7},
+		               std::size_t{100}, std::size_t{20000}}) {
+			auto input = make(n);
+			auto expected = input;
+			std::stable_sort(expected.begin(), expected.end(), less);
+			sort(input);
+			CHECK(ids(input) == ids(expected));
+		}
+	};
+	using R = const event&;
+
+	SECTION("integral keys") {
+		check(
+		    [](std::vector<event>& v) {
+			    kblib::stable_sort_transform(v.begin(), v.end(), &event::timestamp);
+		    },
+		    [](R a, R b) { return a.timestamp < b.timestamp; });
+	}
+	SECTION("floating point keys in reverse") {
+		check(
+		    [](std::vector<event>& v) {
+			    kblib::stable_sort_transform(v.begin(), v.end(), &event::weight,
+			                                 std::greater<>{});
+		    },
+		    [](R a, R b) { return a.weight > b.weight; });
+	}
+	SECTION("string keys") {
+		check(
+		    [](std::vector<event>& v) {
+			    kblib::stable_sort_transform(v.begin(), v.end(), &event::tag);
+		    },
+		    [](R a, R b) { return a.tag < b.tag; });
+	}
+	SECTION("custom comparison") {
+		auto by_mod = [](R a, R b) { return a.timestamp % 10 < b.timestamp % 10; };
+		check([&](std::vector<event>& v) {
+			kblib::stable_sort(v.begin(), v.end(), by_mod);
+		}, by_mod);
+	}
+	SECTION("computed keys") {
+		auto key = [](R e) { return e.tag + '.'; };
+		check(
+		    [&](std::vector<event>& v) {
+			    kblib::stable_sort_transform(v.begin(), v.end(), key);
+		    },
+		    [&](R a, R b) { return key(a) < key(b); });
+	}
+	SECTION("re-sorting keeps the previous order among equal keys") {
+		auto input = make(20000);
+		auto expected = input;
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [](R a, R b) { return a.tag < b.tag; });
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [](R a, R b) { return a.timestamp < b.timestamp; });
+		kblib::stable_sort_transform(input.begin(), input.end(), &event::tag);
+		kblib::stable_sort_transform(input.begin(), input.end(),
+		                             &event::timestamp);
+		CHECK(ids(input) == ids(expected));
+	}
+	SECTION("caller-owned buffer") {
+		std::vector<event> buffer;
+		auto input = make(20000);
+		kblib::stable_sort_transform(input.begin(), input.end(),
+		                             &event::timestamp, std::less<>{}, buffer);
+		const auto capacity = buffer.capacity();
+		CHECK(capacity >= input.size());
+		kblib::stable_sort(input.begin(), input.end(),
+		                   [](R a, R b) { return a.id < b.id; }, buffer);
+		CHECK(buffer.capacity() == capacity);
+		CHECK(std::is_sorted(input.begin(), input.end(),
+		                     [](R a, R b) { return a.id < b.id; }));
+	}
+	SECTION("plain values") {
+		std::vector<int> v{5, 3, 9, 1, 1, 4};
+		kblib::stable_sort(v.begin(), v.end());
+		CHECK(v == std::vector<int>{1, 1, 3, 4, 5, 9});
+		kblib::stable_sort(v.begin(), v.end(), std::greater<>{});
+		CHECK(v == std::vector<int>{9, 5, 4, 3, 1, 1});
+	}
+}
+
+TEST_CASE("sort_permutation") {
+	std::minstd_rand rng{std::random_device{}()};
+	std::uniform_int_distribution<int> dist(-1000, 1000);
+	const std::size_t n = 20000;
+	std::vector<int> keys(n);
+	std::generate(keys.begin(), keys.end(), [&] { return dist(rng); });
+	std::vector<std::string> names(n);
+	for (auto i : kblib::range(n)) {
+		names[i] = std::to_string(keys[i] % 37);
+	}
+	auto expected_perm = [&](auto less) {
+		std::vector<std::uint32_t> perm(n);
+		std::iota(perm.begin(), perm.end(), 0u);
+		std::stable_sort(perm.begin(), perm.end(), less);
+		return perm;
+	};
+
+	SECTION("integral keys") {
+		const auto before = keys;
+		auto perm = kblib::sort_permutation(keys.begin(), keys.end());
+		CHECK(keys == before);
+		CHECK(perm == expected_perm([&](std::uint32_t a, std::uint32_t b) {
+			      return keys[a] < keys[b];
+		      }));
+	}
+	SECTION("string keys in reverse") {
+		auto perm = kblib::sort_permutation(names.begin(), names.end(),
+		                                    std::greater<>{});
+		CHECK(perm == expected_perm([&](std::uint32_t a, std::uint32_t b) {
+			      return names[a] > names[b];
+		      }));
+	}
+	SECTION("projected keys into a caller-owned buffer") {
+		struct row {
+			std::array<char, 200> payload;
+			int key;
+		};
+		std::vector<row> rows(n);
+		for (auto i : kblib::range(n)) {
+			rows[i].key = keys[i];
+		}
+		std::vector<std::size_t> perm;
+		kblib::sort_permutation_transform(rows.begin(), rows.end(), &row::key,
+		                                  std::less<>{}, perm);
+		auto expected = expected_perm([&](std::uint32_t a, std::uint32_t b) {
+			return keys[a] < keys[b];
+		});
+		CHECK(std::equal(perm.begin(), perm.end(), expected.begin(),
+		                 expected.end()));
+	}
+	SECTION("computed keys") {
+		auto by_abs = [](int v) { return std::abs(v); };
+		auto perm = kblib::sort_permutation_transform<std::uint16_t>(
+		    keys.begin(), keys.begin() + 1000, by_abs);
+		std::vector<std::uint16_t> expected(1000);
+		std::iota(expected.begin(), expected.end(), std::uint16_t{});
+		std::stable_sort(expected.begin(), expected.end(),
+		                 [&](std::uint16_t a, std::uint16_t b) {
+			                 return by_abs(keys[a]) < by_abs(keys[b]);
+		                 });
+		CHECK(perm == expected);
+		CHECK_THROWS_AS(kblib::sort_permutation<std::uint8_t>(keys.begin(),
+		                                                      keys.end()),
+		                std::length_error);
+	}
+	SECTION("apply_permutation reorders parallel arrays") {
+		auto perm = kblib::sort_permutation(keys.begin(), keys.end());
+		auto sorted_keys = keys;
+		std::stable_sort(sorted_keys.begin(), sorted_keys.end());
+		std::vector<std::string> expected_names;
+		for (auto i : perm) {
+			expected_names.push_back(names[i]);
+		}
+		const auto perm_copy = perm;
+		kblib::apply_permutation(perm.begin(), perm.end(), keys.begin(),
+		                         names.begin());
+		CHECK(perm == perm_copy);
+		CHECK(keys == sorted_keys);
+		CHECK(names == expected_names);
+	}
+}
@@ -0,0 +1,243 @@
+/* *****************************************************************************
+ * %{QMAKE_PROJECT_NAME}
+ * Copyright (c) %YEAR% killerbee
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ * ****************************************************************************/
+#include "kblib/sort.h"
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+//#define FAST_TEST
+
+// Sizes go up by powers of 10 from 10 to this. Results are logged in
+// sort_timings.log.
+#ifndef SORT_BENCHMARK_MAX_SIZE
+#	ifdef NDEBUG
+#		define SORT_BENCHMARK_MAX_SIZE 100000000
+#	else
+#		define SORT_BENCHMARK_MAX_SIZE 100000
+#	endif
+#endif
+
+namespace {
+
+// Insertion sorts are quadratic, so they are only timed up to this size
+constexpr std::size_t insertion_max_size = 1000;
+// Sorting strings is only timed up to this size, to bound memory use
+constexpr std::size_t string_max_size = 1000000;
+
+enum class distribution { random, sorted, reversed, few_unique, zipf };
+
+auto name_of(distribution d) -> const char* {
+	switch (d) {
+	case distribution::random:
+		return "random";
+	case distribution::sorted:
+		return "sorted";
+	case distribution::reversed:
+		return "reversed";
+	case distribution::few_unique:
+		return "few unique";
+	case distribution::zipf:
+		return "zipf";
+	}
+	return "";
+}
+
+/**
+ * @brief Draws ranks in [0, n) with probability proportional to 1/(rank+1),
+ * by binary search in the cumulative distribution.
+ */
+class zipf_distribution {
+ public:
+	explicit zipf_distribution(std::size_t n)
+	    : cdf_(n) {
+		double sum{};
+		for (auto i : kblib::range(n)) {
+			sum += 1.0 / static_cast<double>(i + 1);
+			cdf_[i] = sum;
+		}
+		for (auto& c : cdf_) {
+			c /= sum;
+		}
+	}
+
+	template <typename URBG>
+	auto operator()(URBG& rng) const -> std::size_t {
+		const auto u = std::uniform_real_distribution<double>{}(rng);
+		return kblib::to_unsigned(
+		    std::lower_bound(cdf_.begin(), cdf_.end() - 1, u) - cdf_.begin());
+	}
+
+ private:
+	std::vector<double> cdf_;
+};
+
+auto make_input(distribution d, std::size_t n) -> std::vector<std::uint32_t> {
+	// Fixed seed, so that runs can be compared with each other
+	std::mt19937 rng{42};
+	std::vector<std::uint32_t> v(n);
+	switch (d) {
+	case distribution::random:
+		std::generate(v.begin(), v.end(), rng);
+		break;
+	case distribution::sorted:
+		std::iota(v.begin(), v.end(), 0u);
+		break;
+	case distribution::reversed:
+		std::iota(v.rbegin(), v.rend(), 0u);
+		break;
+	case distribution::few_unique: {
+		std::uniform_int_distribution<std::uint32_t> dist(0, 15);
+		std::generate(v.begin(), v.end(), [&] { return dist(rng) * 1000003u; });
+	} break;
+	case distribution::zipf: {
+		zipf_distribution dist(1000000);
+		// Scatter the ranks so that frequent keys are not also small
+		std::generate(v.begin(), v.end(), [&] {
+			return static_cast<std::uint32_t>(dist(rng)) * 2654435761u;
+		});
+	} break;
+	}
+	return v;
+}
+
+auto to_strings(const std::vector<std::uint32_t>& v)
+    -> std::vector<std::string> {
+	std::vector<std::string> out;
+	out.reserve(v.size());
+	for (auto x : v) {
+		out.push_back(std::to_string(x));
+	}
+	return out;
+}
+
+/**
+ * @brief Times sort on a fresh copy of input for each run, and checks that
+ * the result is sorted according to less.
+ */
+template <typename T, typename Sort, typename Less = std::less<>>
+auto time_sort(Catch::Benchmark::Chronometer& meter, const std::vector<T>& input,
+               Sort sort, Less less = {}) -> void {
+	std::vector<std::vector<T>> copies(kblib::to_unsigned(meter.runs()), input);
+	meter.measure([&](int i) {
+		auto& v = copies[kblib::to_unsigned(i)];
+		sort(v);
+		return v.data();
+	});
+	CHECK(std::is_sorted(copies.front().begin(), copies.front().end(), less));
+}
+
+} // namespace
+
+#ifndef FAST_TEST
+TEST_CASE("sort performance", "[.][benchmark]") {
+	const auto start = std::chrono::steady_clock::now();
+	using namespace std::literals;
+	const auto by_value = [](std::uint32_t a, std::uint32_t b) { return a < b; };
+
+	for (auto d : {distribution::random, distribution::sorted,
+	               distribution::reversed, distribution::few_unique,
+	               distribution::zipf}) {
+		for (std::size_t n = 10; n <= SORT_BENCHMARK_MAX_SIZE; n *= 10) {
+			const auto input = make_input(d, n);
+			const auto suffix = ", "s + name_of(d) + ", " + std::to_string(n);
+
+			BENCHMARK_ADVANCED("std::sort" + suffix)
+			(Catch::Benchmark::Chronometer meter) {
+				time_sort(meter, input, [](std::vector<std::uint32_t>& v) {
+					std::sort(v.begin(), v.end());
+				});
+			};
+			BENCHMARK_ADVANCED("std::stable_sort" + suffix)
+			(Catch::Benchmark::Chronometer meter) {
+				time_sort(meter, input, [](std::vector<std::uint32_t>& v) {
+					std::stable_sort(v.begin(), v.end());
+				});
+			};
+			// Radix sort
+			BENCHMARK_ADVANCED("kblib::sort" + suffix)
+			(Catch::Benchmark::Chronometer meter) {
+				time_sort(meter, input, [](std::vector<std::uint32_t>& v) {
+					kblib::sort(v.begin(), v.end());
+				});
+			};
+			// Comparison sort, as the comparison is opaque
+			BENCHMARK_ADVANCED("kblib::sort (lambda)" + suffix)
+			(Catch::Benchmark::Chronometer meter) {
+				time_sort(meter, input, [&](std::vector<std::uint32_t>& v) {
+					kblib::sort(v.begin(), v.end(), by_value);
+				});
+			};
+			BENCHMARK_ADVANCED("kblib::stable_sort" + suffix)
+			(Catch::Benchmark::Chronometer meter) {
+				time_sort(meter, input, [](std::vector<std::uint32_t>& v) {
+					kblib::stable_sort(v.begin(), v.end());
+				});
+			};
+			BENCHMARK_ADVANCED("kblib::stable_sort (lambda)" + suffix)
+			(Catch::Benchmark::Chronometer meter) {
+				time_sort(meter, input, [&](std::vector<std::uint32_t>& v) {
+					kblib::stable_sort(v.begin(), v.end(), by_value);
+				});
+			};
+
+			if (n <= insertion_max_size) {
+				BENCHMARK_ADVANCED("kblib::insertion_sort" + suffix)
+				(Catch::Benchmark::Chronometer meter) {
+					time_sort(meter, input, [](std::vector<std::uint32_t>& v) {
+						kblib::insertion_sort(v.begin(), v.end());
+					});
+				};
+				BENCHMARK_ADVANCED("kblib::adaptive_insertion_sort_copy" + suffix)
+				(Catch::Benchmark::Chronometer meter) {
+					std::vector<std::uint32_t> out(n);
+					meter.measure([&] {
+						kblib::adaptive_insertion_sort_copy(
+						    input.begin(), input.end(), out.begin(), out.end());
+						return out.data();
+					});
+					CHECK(std::is_sorted(out.begin(), out.end()));
+				};
+			}
+
+			if (n <= string_max_size) {
+				const auto strings = to_strings(input);
+				BENCHMARK_ADVANCED("std::sort (strings)" + suffix)
+				(Catch::Benchmark::Chronometer meter) {
+					time_sort(meter, strings, [](std::vector<std::string>& v) {
+						std::sort(v.begin(), v.end());
+					});
+				};
+				// MSD string radix sort
+				BENCHMARK_ADVANCED("kblib::sort (strings)" + suffix)
+				(Catch::Benchmark::Chronometer meter) {
+					time_sort(meter, strings, [](std::vector<std::string>& v) {
+						kblib::sort(v.begin(), v.end());
+					});
+				};
+			}
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	std::chrono::duration<float, std::ratio<1, 1>> time = end - start;
+	std::cout << "\n\nProfiling took " << time.count() << " seconds\n";
+}
+#endif // not defined(FAST_TEST)
@@ -1,10 +1,18 @@
 #include "kblib/trie.h"
+#include "kblib/io.h"
 
 #if KBLIB_USE_CXX17
 
 #	include "catch2/catch.hpp"
 
+#	include <filesystem>
+#	include <fstream>
+#	include <map>
+#	include <random>
+#	include <set>
+#	include <sstream>
 #	include <string>
+#	include <vector>
 
 TEST_CASE("trie") {
 	KBLIB_UNUSED auto test = kblib::trie<std::string, int>{};
@@ -22,4 +30,333 @@ TEST_CASE("trie") {
 	KBLIB_UNUSED auto test3 = kblib::trie<char[], int>{};
 }
 
+TEMPLATE_TEST_CASE("array-mapped trie sets", "", kblib::trie_qset<std::string>,
+                   kblib::trie_set<std::string>) {
+	// Includes the empty key, prefixes of other keys, and bytes above 127,
+	// which must sort after the others as they do in std::string
+	const std::vector<std::string> words{
+	    "tea", "ten", "", "to", "inn", "in", "i", "tea", "\xff\x01", "A"};
+	TestType set;
+	for (const auto& w : words) {
+		set.insert(w);
+	}
+	const std::set<std::string> expected(words.begin(), words.end());
+	REQUIRE(set.size() == expected.size());
+	CHECK(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+	for (const auto& w : expected) {
+		CHECK(set.contains(w));
+	}
+	CHECK(not set.contains("te"));
+	CHECK(not set.contains("tead"));
+	CHECK(not set.contains("x"));
+	CHECK(set.count("ten") == 1);
+
+	SECTION("erase") {
+		CHECK(set.erase("in") == 1);
+		CHECK(set.erase("in") == 0);
+		CHECK(set.erase("") == 1);
+		CHECK(set.erase("nope") == 0);
+		CHECK(not set.contains("in"));
+		CHECK(set.contains("inn"));
+		CHECK(set.size() == expected.size() - 2);
+		CHECK(std::distance(set.begin(), set.end())
+		      == static_cast<std::ptrdiff_t>(set.size()));
+	}
+	SECTION("bulk construction matches insertion") {
+		const TestType bulk(words.begin(), words.end());
+		CHECK(bulk.size() == set.size());
+		CHECK(bulk.row_count() == set.row_count());
+		CHECK(std::equal(bulk.begin(), bulk.end(), expected.begin(),
+		                 expected.end()));
+	}
+	SECTION("shrink_to_fit frees emptied rows") {
+		set.insert("a long key with many rows");
+		const auto rows = set.row_count();
+		set.erase("a long key with many rows");
+		CHECK(set.row_count() == rows);
+		set.shrink_to_fit();
+		CHECK(set.row_count() < rows);
+		CHECK(std::equal(set.begin(), set.end(), expected.begin(),
+		                 expected.end()));
+	}
+	SECTION("clear") {
+		set.clear();
+		CHECK(set.empty());
+		CHECK(set.begin() == set.end());
+		CHECK(not set.contains(""));
+	}
+}
+
+TEST_CASE("trie_qset random keys") {
+	std::mt19937 rng{7};
+	std::uniform_int_distribution<int> len(0, 6), elem(0, 255);
+	std::set<std::string> expected;
+	for (int i = 0; i != 2000; ++i) {
+		std::string k(static_cast<std::size_t>(len(rng)), '\0');
+		for (auto& c : k) {
+			c = static_cast<char>(elem(rng));
+		}
+		expected.insert(k);
+	}
+	// Unsorted input is sorted for a depth-first layout
+	const std::vector<std::string> keys(expected.rbegin(), expected.rend());
+	const kblib::trie_qset<std::string> set(keys.begin(), keys.end());
+	CHECK(set.size() == expected.size());
+	CHECK(std::equal(set.begin(), set.end(), expected.begin(), expected.end()));
+}
+
+TEST_CASE("trie_qset offset_type overflow") {
+	kblib::trie_qset<std::string, kblib::default_extract<std::string>,
+	                 signed char>
+	    set;
+	// Rows along one key jump to the next row, which always fits
+	CHECK(set.insert(std::string(200, 'a')));
+	// But a jump from the root past those 200 rows does not
+	CHECK_THROWS_AS(set.insert("bb"), std::length_error);
+	CHECK(set.insert("b"));
+}
+
+TEST_CASE("double_array_trie_set") {
+	CHECK(not kblib::double_array_trie_set<std::string>{}.contains(""));
+
+	std::mt19937 rng{11};
+	std::uniform_int_distribution<int> len(0, 6), elem(0, 255);
+	std::vector<std::string> keys;
+	for (int i = 0; i != 3000; ++i) {
+		std::string k(static_cast<std::size_t>(len(rng)), '\0');
+		for (auto& c : k) {
+			// Mostly a few letters, for shared prefixes
+			c = static_cast<char>(rng() % 4 == 0 ? elem(rng) : 'a' + rng() % 3);
+		}
+		keys.push_back(k);
+	}
+	// Unsorted, with duplicates
+	keys.insert(keys.end(), keys.begin(), keys.begin() + 100);
+	const std::set<std::string> expected(keys.begin(), keys.end());
+	const kblib::double_array_trie_set<std::string> set(keys.begin(),
+	                                                    keys.end());
+	CHECK(set.size() == expected.size());
+	for (const auto& k : expected) {
+		CHECK(set.contains(k));
+		auto shorter = k.substr(0, k.size() / 2);
+		CHECK(set.contains(shorter) == expected.count(shorter));
+		auto longer = k + '\xff';
+		CHECK(set.contains(longer) == expected.count(longer));
+	}
+	std::vector<std::string> found;
+	set.for_each_with_prefix(
+	    "", [&](const std::string& k) { found.push_back(k); });
+	CHECK(std::equal(found.begin(), found.end(), expected.begin(),
+	                 expected.end()));
+
+	const kblib::trie_qset<std::string> qset(keys.begin(), keys.end());
+	// Each unit is 8 bytes, each row over 2 KiB
+	CHECK(set.unit_count() < qset.row_count() * 256);
+}
+
+TEST_CASE("double_array_trie_set index_type overflow") {
+	using set_type
+	    = kblib::double_array_trie_set<std::string,
+	                                   kblib::default_extract<std::string>,
+	                                   signed char>;
+	// The child for 'a' is unit base + 'a' + 1 = 99, which fits
+	CHECK(set_type{"az"}.contains("az"));
+	// But not unit 1 + 255 + 1
+	CHECK_THROWS_AS(set_type{"\xff"}, std::length_error);
+}
+
+TEST_CASE("trie_set iterators") {
+	kblib::trie_set<std::string> set{"b", "a"};
+	auto r = set.insert("ab");
+	CHECK(r.second);
+	CHECK(*r.first == "ab");
+	CHECK(*++r.first == "b");
+	r = set.insert("a");
+	CHECK(not r.second);
+	CHECK(*r.first == "a");
+	CHECK(set.find("ab") != set.end());
+	CHECK(set.find("c") == set.end());
+	CHECK(set.find("") == set.end());
+	CHECK(&*set.find("ab") == &*set.find("ab"));
+}
+
+TEST_CASE("sparse_trie_map") {
+	kblib::sparse_trie_map<std::string, int> map;
+	map["/usr/lib"] = 1;
+	map["/usr/local/lib"] = 2;
+	map["/usr"] = 3;
+	map.try_emplace("/usr", 4);
+	CHECK(map.size() == 3);
+	CHECK(map.at("/usr") == 3);
+	CHECK_THROWS_AS(map.at("/us"), std::out_of_range);
+	CHECK(map.find("/usr/local") == map.end());
+	CHECK(map.insert_or_assign("/usr/lib", 5).second == false);
+	CHECK(map["/usr/lib"] == 5);
+	std::vector<std::string> keys;
+	for (const auto& [k, v] : map) {
+		keys.push_back(k);
+	}
+	CHECK(keys == std::vector<std::string>{"/usr", "/usr/lib", "/usr/local/lib"});
+	std::vector<int> under;
+	map.for_each_with_prefix(
+	    "/usr/l", [&](const auto& kv) { under.push_back(kv.second); });
+	CHECK(under == std::vector<int>{5, 2});
+	auto it = map.erase(map.find("/usr/lib"));
+	CHECK(it->first == "/usr/local/lib");
+	// Iterators yield proxies that refer to the stored value
+	it->second = 6;
+	(*it).second += 1;
+	CHECK(map.at("/usr/local/lib") == 7);
+	CHECK(map.size() == 2);
+
+	const auto copy = map;
+	CHECK(std::equal(copy.begin(), copy.end(), map.begin(), map.end(),
+	                 [](const auto& a, const auto& b) {
+		                 return a.first == b.first and a.second == b.second;
+	                 }));
+	map.clear();
+	CHECK(map.empty());
+	CHECK(copy.size() == 2);
+}
+
+TEST_CASE("sparse_trie_map matches std::map") {
+	// Keys share long prefixes, so that compressed paths longer than the
+	// stored prefix are split, and nodes see every fanout from 1 to 256
+	std::mt19937 rng{11};
+	const std::vector<std::string> stems{"", "http://example.com/",
+	                                     "http://example.com/a/very/long/path/",
+	                                     "http://example.org/"};
+	const auto random_key = [&] {
+		std::string k = stems[rng() % stems.size()];
+		const auto tail = rng() % 4;
+		for (std::size_t i = 0; i != tail; ++i) {
+			// Mostly a few values, sometimes any byte
+			k.push_back(static_cast<char>(rng() % 8 == 0 ? rng() % 256 : rng() % 4));
+		}
+		return k;
+	};
+	kblib::sparse_trie_map<std::string, int> trie;
+	std::map<std::string, int> expected;
+	for (int round = 0; round != 20000; ++round) {
+		const auto k = random_key();
+		if (rng() % 3 == 0) {
+			REQUIRE(trie.erase(k) == expected.erase(k));
+		} else {
+			REQUIRE(trie.try_emplace(k, round).second
+			        == expected.try_emplace(k, round).second);
+		}
+		REQUIRE(trie.size() == expected.size());
+		REQUIRE(trie.contains(k) == (expected.count(k) == 1));
+	}
+	CHECK(std::equal(trie.begin(), trie.end(), expected.begin(), expected.end(),
+	                 [](const auto& a, const auto& b) {
+		                 return a.first == b.first and a.second == b.second;
+	                 }));
+
+	const kblib::sparse_trie_set<std::string> set{"b", "", "ab", "a"};
+	CHECK(std::equal(set.begin(), set.end(),
+	                 std::set<std::string>{"b", "", "ab", "a"}.begin()));
+	CHECK(set.find("ab") != set.end());
+	CHECK(set.count("abc") == 0);
+}
+
+TEMPLATE_TEST_CASE("for_each_with_prefix", "", kblib::trie_qset<std::string>,
+                   kblib::trie_set<std::string>,
+                   kblib::sparse_trie_set<std::string>,
+                   kblib::double_array_trie_set<std::string>) {
+	// Long shared stems, so that sparse tries skip unstored prefix bytes
+	std::mt19937 rng{13};
+	const std::vector<std::string> stems{"", "a", "ab", "abcdefghijklmnop",
+	                                     "abcdefghijklmnoq"};
+	std::set<std::string> expected;
+	for (int i = 0; i != 3000; ++i) {
+		std::string k = stems[rng() % stems.size()];
+		const auto tail = rng() % 4;
+		for (std::size_t j = 0; j != tail; ++j) {
+			k.push_back(
+			    static_cast<char>(rng() % 8 == 0 ? rng() % 256 : 'a' + rng() % 3));
+		}
+		expected.insert(k);
+	}
+	const TestType set(expected.begin(), expected.end());
+
+	std::vector<std::string> prefixes(stems);
+	prefixes.insert(prefixes.end(), {"abc", "abcdefghijklmnoz", "abcdefgh",
+	                                 "abcdefghijklmnopab", "b", "\xff", "ba"});
+	for (const auto& prefix : prefixes) {
+		std::vector<std::string> found;
+		set.for_each_with_prefix(
+		    prefix, [&](const std::string& k) { found.push_back(k); });
+		std::vector<std::string> want;
+		for (auto it = expected.lower_bound(prefix);
+		     it != expected.end() and it->compare(0, prefix.size(), prefix) == 0;
+		     ++it) {
+			want.push_back(*it);
+		}
+		CHECK(found == want);
+	}
+}
+
+TEST_CASE("trie_qset_view") {
+	std::mt19937 rng{17};
+	std::set<std::string> expected{""};
+	for (int i = 0; i != 2000; ++i) {
+		std::string k;
+		const auto len = 1 + rng() % 6;
+		for (std::size_t j = 0; j != len; ++j) {
+			k.push_back(static_cast<char>('a' + rng() % 4));
+		}
+		expected.insert(k);
+	}
+	const kblib::trie_qset<std::string> set(expected.begin(), expected.end());
+
+	const auto path = std::filesystem::temp_directory_path()
+	                  / ("kblib-trie-test-" + std::to_string(rng()));
+	{
+		std::ofstream out(path, std::ios::binary);
+		REQUIRE(set.serialize(out));
+	}
+	const kblib::mapped_file file(path);
+	std::filesystem::remove(path);
+	const kblib::trie_qset_view<std::string> view(file.data(), file.size());
+
+	REQUIRE(view.size() == set.size());
+	REQUIRE(view.row_count() == set.row_count());
+	CHECK(std::equal(view.begin(), view.end(), expected.begin(),
+	                 expected.end()));
+	for (const auto* k : {"", "a", "abcd", "e", "aaaaaaa", "dddddd"}) {
+		CHECK(view.contains(k) == set.contains(k));
+	}
+	std::vector<std::string> a, b;
+	set.for_each_with_prefix("ab",
+	                         [&](const std::string& k) { a.push_back(k); });
+	view.for_each_with_prefix("ab",
+	                          [&](const std::string& k) { b.push_back(k); });
+	CHECK(a == b);
+
+	SECTION("bad data") {
+		std::ostringstream out;
+		set.serialize(out);
+		const auto bytes = out.str();
+		// Copied into memory from operator new, which is suitably aligned
+		const auto check = [&](std::string data) {
+			const std::unique_ptr<char[]> buf(new char[data.size()]);
+			std::copy(data.begin(), data.end(), buf.get());
+			CHECK_THROWS_AS(
+			    (kblib::trie_qset_view<std::string>(buf.get(), data.size())),
+			    std::invalid_argument);
+		};
+		check(bytes.substr(0, 10));
+		check(bytes.substr(0, bytes.size() - 1));
+		auto bad_magic = bytes;
+		bad_magic[0] = 'x';
+		check(bad_magic);
+		std::ostringstream narrow;
+		kblib::trie_qset<std::string, kblib::default_extract<std::string>, int>(
+		    expected.begin(), expected.end())
+		    .serialize(narrow);
+		check(narrow.str());
+	}
+}
+
 #endif
@@ -0,0 +1,335 @@
+#include "kblib/bits.h"
+#include "kblib/trie.h"
+
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "catch2/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if KBLIB_USE_CXX17
+
+namespace {
+
+// The number of IPv4 prefixes in the routing table. Results are logged in
+// trie_timings.log.
+#	ifndef TRIE_BENCHMARK_PREFIXES
+#		ifdef NDEBUG
+#			define TRIE_BENCHMARK_PREFIXES 1000000
+#		else
+#			define TRIE_BENCHMARK_PREFIXES 10000
+#		endif
+#	endif
+
+// The number of words in the dictionary
+#	ifndef TRIE_BENCHMARK_WORDS
+#		ifdef NDEBUG
+#			define TRIE_BENCHMARK_WORDS 200000
+#		else
+#			define TRIE_BENCHMARK_WORDS 2000
+#		endif
+#	endif
+
+// Each benchmark run looks up this many addresses or words
+constexpr std::size_t batch_size = 1024;
+
+using table_type
+    = kblib::compact_bit_trie<std::uint32_t, UINT32_MAX, std::uint32_t>;
+constexpr auto no_route = UINT32_MAX;
+
+struct route {
+	std::uint32_t prefix;
+	int bits;
+	std::uint32_t hop;
+};
+
+auto by_address(const route& a, const route& b) -> bool {
+	return std::tie(a.prefix, a.bits) < std::tie(b.prefix, b.bits);
+}
+
+auto mask_of(int bits) -> std::uint32_t {
+	return bits == 0 ? 0 : ~std::uint32_t{} << (32 - bits);
+}
+
+/**
+ * @brief Random routes with prefix lengths distributed roughly as in the
+ * global routing table: over half are /24, and nearly all the rest are /16 to
+ * /23. Duplicates are skipped.
+ */
+auto make_routes(std::size_t n) -> std::vector<route> {
+	// Fixed seed, so that runs can be compared with each other
+	std::mt19937 rng{42};
+	std::discrete_distribution<int> length{
+	    {0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 2, 4, 6, 8, 80, 30, 40, 60, 100,
+	     120, 150, 130, 560}};
+	table_type seen;
+	std::vector<route> routes;
+	routes.reserve(n);
+	while (routes.size() != n) {
+		const auto bits = length(rng);
+		const auto prefix = static_cast<std::uint32_t>(rng()) & mask_of(bits);
+		const auto hop = static_cast<std::uint32_t>(routes.size());
+		if (seen.insert({prefix, static_cast<std::uint16_t>(bits)}, hop)) {
+			routes.push_back({prefix, bits, hop});
+		}
+	}
+	return routes;
+}
+
+/**
+ * @brief Longest prefix match by binary search: the prefixes are flattened
+ * into sorted, disjoint address ranges, each labelled with the hop of the
+ * longest prefix covering it, so that a lookup is one upper_bound.
+ */
+class sorted_ranges {
+ public:
+	explicit sorted_ranges(std::vector<route> routes) {
+		// Enclosing prefixes come before the prefixes they contain
+		std::sort(routes.begin(), routes.end(), by_address);
+		struct open_route {
+			std::uint64_t last;
+			std::uint32_t hop;
+		};
+		std::vector<open_route> open;
+		const auto close_before = [&](std::uint64_t addr) {
+			while (not open.empty() and open.back().last < addr) {
+				const auto end = open.back().last + 1;
+				open.pop_back();
+				emit(end, open.empty() ? no_route : open.back().hop);
+			}
+		};
+		for (const auto& r : routes) {
+			close_before(r.prefix);
+			emit(r.prefix, r.hop);
+			open.push_back({std::uint64_t{r.prefix} + ~mask_of(r.bits), r.hop});
+		}
+		close_before(std::uint64_t{1} << 32u);
+	}
+
+	auto lookup(std::uint32_t addr) const noexcept -> std::uint32_t {
+		const auto it = std::upper_bound(starts.begin(), starts.end(), addr);
+		return it == starts.begin() ? no_route : hops[it - starts.begin() - 1];
+	}
+
+	auto memory_use() const noexcept -> std::size_t {
+		return starts.capacity() * sizeof(std::uint32_t)
+		       + hops.capacity() * sizeof(std::uint32_t);
+	}
+
+ private:
+	auto emit(std::uint64_t start, std::uint32_t hop) -> void {
+		if (start > UINT32_MAX) {
+			return;
+		}
+		if (not starts.empty() and starts.back() == start) {
+			hops.back() = hop;
+		} else if (hops.empty() or hops.back() != hop) {
+			starts.push_back(static_cast<std::uint32_t>(start));
+			hops.push_back(hop);
+		}
+	}
+
+	std::vector<std::uint32_t> starts;
+	std::vector<std::uint32_t> hops;
+};
+
+auto lpm(const table_type& table, std::uint32_t addr) -> std::uint32_t {
+	const auto it = table.longest_prefix_match(addr);
+	return it == table.end() ? no_route : *it;
+}
+
+template <typename F>
+auto time_once(const char* what, F f) -> void {
+	const auto start = std::chrono::steady_clock::now();
+	f();
+	const std::chrono::duration<double, std::milli> t
+	    = std::chrono::steady_clock::now() - start;
+	std::cout << what << ": " << t.count() << " ms\n";
+}
+
+/**
+ * @brief Random lowercase words of 3 to 12 letters.
+ */
+auto make_words(std::size_t n, std::mt19937& rng) -> std::vector<std::string> {
+	std::vector<std::string> words(n);
+	for (auto& w : words) {
+		const auto len = 3 + rng() % 10;
+		for (std::size_t i = 0; i != len; ++i) {
+			w.push_back(static_cast<char>('a' + rng() % 26));
+		}
+	}
+	return words;
+}
+
+} // namespace
+
+TEST_CASE("longest prefix match", "[.][benchmark]") {
+	const auto routes = make_routes(TRIE_BENCHMARK_PREFIXES);
+
+	table_type table;
+	time_once("compact_bit_trie build", [&] {
+		for (const auto& r : routes) {
+			table.insert({r.prefix, static_cast<std::uint16_t>(r.bits)}, r.hop);
+		}
+	});
+	auto compact = table;
+	time_once("compact_bit_trie shrink_to_fit",
+	          [&] { compact.shrink_to_fit(); });
+	std::optional<sorted_ranges> ranges;
+	time_once("sorted ranges build", [&] { ranges.emplace(routes); });
+	std::cout << "compact_bit_trie memory: " << table.memory_use() / 1024
+	          << " KiB\ncompacted: " << compact.memory_use() / 1024
+	          << " KiB\nsorted ranges memory: " << ranges->memory_use() / 1024
+	          << " KiB\n";
+
+	// Addresses inside a random route, so that most lookups match a long
+	// prefix, and fully random addresses, which mostly match short ones
+	std::mt19937 rng{7};
+	std::vector<std::uint32_t> routed(batch_size), random(batch_size);
+	for (auto& a : routed) {
+		const auto& r = routes[rng() % routes.size()];
+		a = r.prefix | (static_cast<std::uint32_t>(rng()) & ~mask_of(r.bits));
+	}
+	for (auto& a : random) {
+		a = static_cast<std::uint32_t>(rng());
+	}
+	for (const auto* addrs : {&routed, &random}) {
+		for (auto a : *addrs) {
+			REQUIRE(lpm(table, a) == ranges->lookup(a));
+			REQUIRE(lpm(compact, a) == ranges->lookup(a));
+		}
+	}
+
+	for (const auto& [name, addrs] : {std::pair{"routed addresses", &routed},
+	                                  {"random addresses", &random}}) {
+		BENCHMARK(std::string("compact_bit_trie, ") + name) {
+			std::uint32_t sum = 0;
+			for (auto a : *addrs) {
+				sum += lpm(table, a);
+			}
+			return sum;
+		};
+		BENCHMARK(std::string("compact_bit_trie, compacted, ") + name) {
+			std::uint32_t sum = 0;
+			for (auto a : *addrs) {
+				sum += lpm(compact, a);
+			}
+			return sum;
+		};
+		BENCHMARK(std::string("sorted ranges, ") + name) {
+			std::uint32_t sum = 0;
+			for (auto a : *addrs) {
+				sum += ranges->lookup(a);
+			}
+			return sum;
+		};
+	}
+
+	// Enumerating every route inside a /12, against the same query on a
+	// vector of routes sorted by address
+	std::vector<route> sorted = routes;
+	std::sort(sorted.begin(), sorted.end(), by_address);
+	std::vector<std::uint32_t> blocks(batch_size);
+	for (auto& b : blocks) {
+		b = static_cast<std::uint32_t>(rng()) & mask_of(12);
+	}
+	BENCHMARK("compact_bit_trie, routes in a /12") {
+		std::size_t n = 0;
+		for (auto b : blocks) {
+			const auto r = table.prefix_range({b, 12});
+			n += static_cast<std::size_t>(std::distance(r.first, r.second));
+		}
+		return n;
+	};
+	BENCHMARK("compact_bit_trie, compacted, routes in a /12") {
+		std::size_t n = 0;
+		for (auto b : blocks) {
+			const auto r = compact.prefix_range({b, 12});
+			n += static_cast<std::size_t>(std::distance(r.first, r.second));
+		}
+		return n;
+	};
+	BENCHMARK("sorted vector, routes in a /12") {
+		std::size_t n = 0;
+		for (auto b : blocks) {
+			const auto first = std::lower_bound(
+			    sorted.begin(), sorted.end(), b,
+			    [](const route& r, std::uint32_t x) { return r.prefix < x; });
+			const auto last = std::lower_bound(
+			    first, sorted.end(), std::uint64_t{b} + (1u << 20u),
+			    [](const route& r, std::uint64_t x) { return r.prefix < x; });
+			// Routes shorter than /12 start inside the block but cover more
+			n += static_cast<std::size_t>(std::count_if(
+			    first, last, [](const route& r) { return r.bits >= 12; }));
+		}
+		return n;
+	};
+}
+
+TEST_CASE("dictionary lookup", "[.][benchmark]") {
+	std::mt19937 rng{42};
+	const auto words = make_words(TRIE_BENCHMARK_WORDS, rng);
+
+	using qset_type = kblib::trie_qset<std::string,
+	                                   kblib::default_extract<std::string>, int>;
+	std::optional<qset_type> qset;
+	time_once("trie_qset build",
+	          [&] { qset.emplace(words.begin(), words.end()); });
+	std::optional<kblib::double_array_trie_set<std::string>> darray;
+	time_once("double_array_trie_set build",
+	          [&] { darray.emplace(words.begin(), words.end()); });
+	std::optional<std::set<std::string>> set;
+	time_once("std::set build",
+	          [&] { set.emplace(words.begin(), words.end()); });
+	std::cout << "trie_qset memory: "
+	          // Each row has a jump and a leaf bit for each of 256 slots
+	          << qset->row_count() * (256 * sizeof(int) + 256 / 8) / 1024
+	          << " KiB\ndouble_array_trie_set memory: "
+	          << darray->unit_count() * 2 * sizeof(std::int32_t) / 1024
+	          << " KiB\n";
+
+	// Half present, half random strings that are mostly absent
+	std::vector<std::string> queries;
+	for (std::size_t i = 0; i != batch_size / 2; ++i) {
+		queries.push_back(words[rng() % words.size()]);
+	}
+	const auto absent = make_words(batch_size / 2, rng);
+	queries.insert(queries.end(), absent.begin(), absent.end());
+	for (const auto& q : queries) {
+		REQUIRE(qset->contains(q) == set->count(q));
+		REQUIRE(darray->contains(q) == set->count(q));
+	}
+
+	BENCHMARK("trie_qset, lookup") {
+		std::size_t n = 0;
+		for (const auto& q : queries) {
+			n += qset->contains(q);
+		}
+		return n;
+	};
+	BENCHMARK("double_array_trie_set, lookup") {
+		std::size_t n = 0;
+		for (const auto& q : queries) {
+			n += darray->contains(q);
+		}
+		return n;
+	};
+	BENCHMARK("std::set, lookup") {
+		std::size_t n = 0;
+		for (const auto& q : queries) {
+			n += set->count(q);
+		}
+		return n;
+	};
+}
+
+#endif // KBLIB_USE_CXX17